@@ -0,0 +1,417 @@
+#include "album_art.h"
+#include "mapped_file.h"
+
+#define CPPHTTPLIB_OPENSSL_SUPPORT //for SSL/HTTPS, must match every TU including httplib
+#include "httplib.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include <jpeglib.h>
+
+// ============================
+// JPEG decoding
+// ============================
+namespace {
+struct JpegError {
+    jpeg_error_mgr mgr;
+    std::jmp_buf jump;
+};
+
+void jpeg_fail(j_common_ptr info) {
+    std::longjmp(((JpegError*)info->err)->jump, 1);
+}
+
+void jpeg_quiet(j_common_ptr) {
+}
+}
+
+// Box filter over the centered square of an RGB image
+static void downsample(const std::vector<uint8_t>& rgb, int w, int h, int size, std::vector<uint8_t>& rgba) {
+    int side = std::min(w, h);
+    int ox = (w - side) / 2, oy = (h - side) / 2;
+    rgba.assign((size_t)size * size * 4, 255);
+    for (int y = 0; y < size; y++) {
+        int y0 = oy + y * side / size;
+        int y1 = std::max(y0 + 1, oy + (y + 1) * side / size);
+        for (int x = 0; x < size; x++) {
+            int x0 = ox + x * side / size;
+            int x1 = std::max(x0 + 1, ox + (x + 1) * side / size);
+            uint32_t sum[3] = {0, 0, 0};
+            for (int sy = y0; sy < y1; sy++) {
+                const uint8_t* p = &rgb[((size_t)sy * w + x0) * 3];
+                for (int sx = x0; sx < x1; sx++, p += 3) {
+                    sum[0] += p[0];
+                    sum[1] += p[1];
+                    sum[2] += p[2];
+                }
+            }
+            uint32_t n = (uint32_t)((y1 - y0) * (x1 - x0));
+            uint8_t* out = &rgba[((size_t)y * size + x) * 4];
+            out[0] = (uint8_t)(sum[0] / n);
+            out[1] = (uint8_t)(sum[1] / n);
+            out[2] = (uint8_t)(sum[2] / n);
+        }
+    }
+}
+
+bool decode_cover(const std::string& jpeg, int size, std::vector<uint8_t>& rgba) {
+    if (jpeg.empty() || size <= 0)
+        return false;
+
+    jpeg_decompress_struct info;
+    JpegError err;
+    info.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = jpeg_fail;
+    err.mgr.output_message = jpeg_quiet;
+    // nothing below may own resources that longjmp would skip
+    std::vector<uint8_t> rgb;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, (const unsigned char*)jpeg.data(), (unsigned long)jpeg.size());
+    jpeg_read_header(&info, TRUE);
+
+    // let the IDCT do most of the shrinking: 1/2, 1/4, 1/8 cost almost nothing
+    int side = (int)std::min(info.image_width, info.image_height);
+    int denom = 8;
+    while (denom > 1 && side / denom < size)
+        denom /= 2;
+    info.scale_num = 1;
+    info.scale_denom = (unsigned)denom;
+    info.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&info);
+
+    int w = (int)info.output_width, h = (int)info.output_height;
+    rgb.resize((size_t)w * h * 3);
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW row = &rgb[(size_t)info.output_scanline * w * 3];
+        jpeg_read_scanlines(&info, &row, 1);
+    }
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+
+    downsample(rgb, w, h, size, rgba);
+    return true;
+}
+
+// ============================
+// AlbumArt
+// ============================
+AlbumArt::AlbumArt(const std::string& cacheDir_, size_t textureBudget_)
+    : cacheDir(cacheDir_),
+      textureBudget(textureBudget_)
+{
+}
+
+AlbumArt::~AlbumArt() {
+    stop();
+}
+
+void AlbumArt::start() {
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    running = true;
+    thread = std::thread(&AlbumArt::threadFunc, this);
+}
+
+void AlbumArt::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running)
+            return;
+        running = false;
+    }
+    cv.notify_all();
+    if (thread.joinable())
+        thread.join();
+}
+
+unsigned int AlbumArt::texture(const std::string& url, int size) {
+    if (url.empty() || size <= 0)
+        return 0;
+    std::string key = std::to_string(size) + ":" + url;
+
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        Entry& e = it->second;
+        if (e.state == READY) {
+            e.usedFrame = frame;
+            lru.splice(lru.begin(), lru, e.lru);
+            return e.tex;
+        }
+        if (e.state == LOADING ||
+            std::chrono::steady_clock::now() - e.failedAt < RETRY_AFTER)
+            return 0;
+        e.state = LOADING;
+    } else {
+        Entry& e = entries[key];
+        lru.push_front(key);
+        e.lru = lru.begin();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(Job{key, url, size});
+        // scrolling asks for many covers; the oldest asks are dropped first
+        if (jobs.size() > MAX_QUEUED) {
+            done.push_back(Decoded{jobs.front().key, jobs.front().size, false, true, {}});
+            jobs.pop_front();
+        }
+    }
+    cv.notify_one();
+    return 0;
+}
+
+bool AlbumArt::update(size_t uploadBudget) {
+    frame++;
+    std::vector<Decoded> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t bytes = 0;
+        while (!done.empty() && (batch.empty() || bytes + done.front().rgba.size() <= uploadBudget)) {
+            bytes += done.front().rgba.size();
+            batch.push_back(std::move(done.front()));
+            done.pop_front();
+        }
+    }
+
+    bool uploaded = false;
+    for (Decoded& d : batch) {
+        auto it = entries.find(d.key);
+        if (it == entries.end())
+            continue;
+        Entry& e = it->second;
+        if (d.dropped) {
+            lru.erase(e.lru);
+            entries.erase(it);
+            continue;
+        }
+        if (!d.ok) {
+            e.state = FAILED;
+            e.failedAt = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        GLuint tex = 0;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, d.size, d.size, 0, GL_RGBA, GL_UNSIGNED_BYTE, d.rgba.data());
+        e.state = READY;
+        e.tex = tex;
+        e.bytes = d.rgba.size();
+        residentBytes += e.bytes;
+        uploaded = true;
+    }
+    if (uploaded)
+        evict();
+    return uploaded;
+}
+
+bool AlbumArt::waiting() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !done.empty();
+}
+
+// Drops least recently drawn textures over the budget, but never one drawn
+// in the last frame (that would only reload it)
+void AlbumArt::evict() {
+    auto it = lru.end();
+    while (residentBytes > textureBudget && it != lru.begin()) {
+        --it;
+        auto e = entries.find(*it);
+        if (e->second.state != READY)
+            continue;
+        if (e->second.usedFrame + 1 >= frame)
+            break;
+        GLuint tex = e->second.tex;
+        glDeleteTextures(1, &tex);
+        residentBytes -= e->second.bytes;
+        entries.erase(e);
+        it = lru.erase(it);
+    }
+}
+
+void AlbumArt::releaseTextures() {
+    for (auto& kv : entries) {
+        if (kv.second.state == READY) {
+            GLuint tex = kv.second.tex;
+            glDeleteTextures(1, &tex);
+        }
+    }
+    entries.clear();
+    lru.clear();
+    residentBytes = 0;
+}
+
+std::string AlbumArt::cachePath(const std::string& url) const {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : url) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.jpg", (unsigned long long)h);
+    return cacheDir + "/" + name;
+}
+
+bool AlbumArt::fetch(const std::string& url, std::string& bytes) {
+    // "https://host[:port]/path": one keep-alive client per origin
+    size_t scheme = url.find("://");
+    if (scheme == std::string::npos)
+        return false;
+    size_t slash = url.find('/', scheme + 3);
+    std::string origin = url.substr(0, slash);
+    std::string path = slash == std::string::npos ? "/" : url.substr(slash);
+
+    if (!client || origin != clientOrigin) {
+        client.reset(new httplib::Client(origin));
+        client->set_keep_alive(true);
+        client->set_follow_location(true);
+        client->set_connection_timeout(5, 0);
+        client->set_read_timeout(10, 0);
+        clientOrigin = origin;
+    }
+    if (!client->is_valid())
+        return false;
+
+    bytes.clear();
+    httplib::Result res = client->Get(path, [&](const char* data, size_t n) {
+        bytes.append(data, n);
+        return bytes.size() <= MAX_DOWNLOAD;
+    });
+    return res && res->status == 200 && !bytes.empty();
+}
+
+void AlbumArt::threadFunc() {
+    std::string bytes;
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return !running || !jobs.empty(); });
+            if (!running)
+                return;
+            // newest first: that is what is on screen now
+            job = std::move(jobs.back());
+            jobs.pop_back();
+        }
+
+        std::string path = cachePath(job.url);
+        bool cached = false;
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (in) {
+                bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+                cached = !bytes.empty();
+            }
+        }
+        if (!cached && fetch(job.url, bytes)) {
+            // temp file + rename, so a crash never leaves half an image
+            std::string tmp = path + ".tmp";
+            std::ofstream out(tmp, std::ios::binary);
+            out.write(bytes.data(), (std::streamsize)bytes.size());
+            out.close();
+            if (out) {
+                replace_file(tmp, path);
+            }
+            cached = true;
+        }
+
+        Decoded d{job.key, job.size, false, false, {}};
+        d.ok = cached && decode_cover(bytes, job.size, d.rgba);
+        if (!d.ok)
+            std::cout << "[art] could not load " << job.url << std::endl;
+        // a broken file would otherwise fail every retry without a fetch
+        if (cached && !d.ok)
+            std::remove(path.c_str());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.push_back(std::move(d));
+        }
+        if (onReady)
+            onReady();
+    }
+}
+
+// ============================
+// Stand-in cover server
+// ============================
+// Covers for trying the loader without Spotify's CDN. /cover/<n>.jpg is a
+// gradient whose colour and size follow n (every third one is not square),
+// /broken.jpg is not a JPEG at all, /slow.jpg answers after three seconds.
+static std::string encode_test_cover(int w, int h, int n) {
+    jpeg_compress_struct info;
+    jpeg_error_mgr err;
+    info.err = jpeg_std_error(&err);
+    jpeg_create_compress(&info);
+    unsigned char* out = nullptr;
+    unsigned long outSize = 0;
+    jpeg_mem_dest(&info, &out, &outSize);
+    info.image_width = (JDIMENSION)w;
+    info.image_height = (JDIMENSION)h;
+    info.input_components = 3;
+    info.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, 85, TRUE);
+    jpeg_start_compress(&info, TRUE);
+
+    std::vector<uint8_t> row((size_t)w * 3);
+    int r = (n * 97) % 256, g = (n * 57 + 80) % 256, b = (n * 31 + 160) % 256;
+    while (info.next_scanline < info.image_height) {
+        int y = (int)info.next_scanline;
+        for (int x = 0; x < w; x++) {
+            row[x * 3]     = (uint8_t)(r * x / w);
+            row[x * 3 + 1] = (uint8_t)(g * y / h);
+            row[x * 3 + 2] = (uint8_t)b;
+        }
+        JSAMPROW p = row.data();
+        jpeg_write_scanlines(&info, &p, 1);
+    }
+    jpeg_finish_compress(&info);
+    std::string jpeg((const char*)out, outSize);
+    std::free(out);
+    jpeg_destroy_compress(&info);
+    return jpeg;
+}
+
+int album_art_fake_server(int port) {
+    httplib::Server server;
+    server.Get("/cover/:n", [](const httplib::Request& req, httplib::Response& res) {
+        int n = std::atoi(req.path_params.at("n").c_str());
+        int w = 300 + (n % 4) * 100;
+        int h = n % 3 == 0 ? w * 2 / 3 : w;
+        res.set_content(encode_test_cover(w, h, n), "image/jpeg");
+    });
+    server.Get("/broken.jpg", [](const httplib::Request&, httplib::Response& res) {
+        res.set_content("\xff\xd8 this is not a JPEG", "image/jpeg");
+    });
+    server.Get("/slow.jpg", [](const httplib::Request&, httplib::Response& res) {
+        std::this_thread::sleep_for(std::chrono::seconds(3));
+        res.set_content(encode_test_cover(640, 640, 1), "image/jpeg");
+    });
+    server.set_logger([](const httplib::Request& req, const httplib::Response& res) {
+        std::printf("[art] %s -> %d\n", req.path.c_str(), res.status);
+    });
+
+    std::printf("[art] stand-in covers on http://127.0.0.1:%d: /cover/<n>.jpg, /broken.jpg, /slow.jpg\n", port);
+    if (!server.listen("127.0.0.1", port)) {
+        std::printf("[art] could not listen on port %d\n", port);
+        return 1;
+    }
+    return 0;
+}
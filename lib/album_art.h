@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+namespace httplib { class Client; }
+
+// ============================
+// Album art loader
+// ============================
+// Cover images by URL, as square GL textures of the size they are drawn at.
+// A worker fetches each cover once (then keeps the JPEG in cacheDir),
+// decodes it with libjpeg at the smallest DCT scale that still covers the
+// size and box-filters it down. Finished pixels wait for update(), which
+// uploads a bounded amount per frame; textures live in an LRU capped at
+// textureBudget bytes.
+//
+// texture() / update() / releaseTextures() belong to the thread with the GL
+// context.
+class AlbumArt {
+public:
+    AlbumArt(const std::string& cacheDir, size_t textureBudget);
+    ~AlbumArt();
+
+    void start();
+    void stop();
+
+    // Texture for url at size x size pixels, or 0 while it loads (the first
+    // call queues it). A cover that failed is retried after RETRY_AFTER.
+    unsigned int texture(const std::string& url, int size);
+
+    // Uploads finished covers, up to uploadBudget bytes (at least one).
+    // Returns whether any new texture became available.
+    bool update(size_t uploadBudget);
+
+    // Whether decoded covers wait for update() (e.g. to schedule a frame)
+    bool waiting();
+
+    // Deletes every texture; call before the GL context goes away
+    void releaseTextures();
+
+    size_t textureBytes() const { return residentBytes; }
+    size_t textureCount() const { return entries.size(); }
+
+    // Called on the worker when a cover is decoded (e.g. to wake the UI)
+    void setOnReady(std::function<void()> fn) { onReady = std::move(fn); }
+
+private:
+    static constexpr size_t MAX_QUEUED = 64;
+    static constexpr size_t MAX_DOWNLOAD = 4 << 20;
+    static constexpr std::chrono::seconds RETRY_AFTER{30};
+
+    enum State { LOADING, READY, FAILED };
+
+    struct Entry {
+        State state = LOADING;
+        unsigned int tex = 0;
+        size_t bytes = 0;
+        uint64_t usedFrame = 0;
+        std::chrono::steady_clock::time_point failedAt;
+        std::list<std::string>::iterator lru;
+    };
+
+    struct Job {
+        std::string key;
+        std::string url;
+        int size;
+    };
+
+    struct Decoded {
+        std::string key;
+        int size;
+        bool ok;
+        bool dropped;   // pushed out of a full queue, may be asked for again
+        std::vector<uint8_t> rgba;
+    };
+
+    void threadFunc();
+    bool fetch(const std::string& url, std::string& bytes);
+    std::string cachePath(const std::string& url) const;
+    void evict();
+
+    std::string cacheDir;
+    size_t textureBudget;
+
+    // GL thread
+    std::unordered_map<std::string, Entry> entries;   // "size:url"
+    std::list<std::string> lru;                        // most recently drawn first
+    size_t residentBytes = 0;
+    uint64_t frame = 0;
+
+    // worker
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Job> jobs;
+    std::deque<Decoded> done;
+    std::unique_ptr<httplib::Client> client;
+    std::string clientOrigin;
+    std::function<void()> onReady;
+};
+
+// Decodes a JPEG and scales it to a size x size RGBA square (center crop)
+bool decode_cover(const std::string& jpeg, int size, std::vector<uint8_t>& rgba);
+
+// spotamp --fake-covers [port]: serves generated test covers, one broken
+// JPEG and one slow answer on 127.0.0.1 (default 3679) until killed
+int album_art_fake_server(int port);
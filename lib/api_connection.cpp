@@ -0,0 +1,146 @@
+#include "api_connection.h"
+#include "api_health.h"
+
+#define CPPHTTPLIB_OPENSSL_SUPPORT //for SSL/HTTPS, must match every TU including httplib
+#include "httplib.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+ApiConnection::ApiConnection(const std::string& host_, int port_)
+    : host(host_),
+      port(port_)
+{
+    reset();
+}
+
+ApiConnection::~ApiConnection() = default;
+
+void ApiConnection::setTimeouts(int connectMs_, int readMs_) {
+    std::lock_guard<std::mutex> lock(mutex);
+    connectMs = connectMs_;
+    readMs = readMs_;
+    reset();
+}
+
+void ApiConnection::reset() {
+    client.reset(new httplib::Client(host, port));
+    client->set_keep_alive(true);
+    client->set_tcp_nodelay(true);
+    client->set_connection_timeout(connectMs / 1000, (connectMs % 1000) * 1000);
+    client->set_read_timeout(readMs / 1000, (readMs % 1000) * 1000);
+    client->set_write_timeout(readMs / 1000, (readMs % 1000) * 1000);
+}
+
+bool ApiConnection::get(const char* path, std::string* body) {
+    return request(false, path, std::string(), body);
+}
+
+bool ApiConnection::post(const char* path, const std::string& json, std::string* body) {
+    return request(true, path, json, body);
+}
+
+bool ApiConnection::request(bool isPost, const char* path, const std::string& json, std::string* body) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (health && !health->allow()) {
+        rejected++;
+        return false;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    httplib::Result res;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        res = isPost ? client->Post(path, json, "application/json") : client->Get(path);
+        if (res)
+            break;
+
+        // transport error: the server may have closed our idle keep-alive
+        // socket. Commands (POST) are only retried if they never left, so a
+        // toggle like playpause cannot be applied twice.
+        auto err = res.error();
+        bool unsent = err == httplib::Error::Connection || err == httplib::Error::Write;
+        if (attempt > 0 || (isPost && !unsent))
+            break;
+        client->stop();
+        reconnects++;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    requests++;
+    totalMs += ms;
+    maxMs = std::max(maxMs, ms);
+
+    // any HTTP answer means the server is alive, even an error status
+    if (health) {
+        if (res) health->success();
+        else     health->failure();
+    }
+
+    if (!res || res->status != 200) {
+        failures++;
+        return false;
+    }
+    if (body)
+        *body = std::move(res->body);
+    return true;
+}
+
+ApiConnection::Stats ApiConnection::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats s;
+    s.requests   = requests;
+    s.failures   = failures;
+    s.reconnects = reconnects;
+    s.rejected   = rejected;
+    s.avgMs      = requests > 0 ? totalMs / requests : 0.0;
+    s.maxMs      = maxMs;
+    return s;
+}
+
+// ============================
+// Latency comparison
+// ============================
+static void print_latency(const char* label, std::vector<double>& ms, int failed) {
+    if (ms.empty()) {
+        std::cout << label << ": no successful requests (" << failed << " failed)" << std::endl;
+        return;
+    }
+    std::sort(ms.begin(), ms.end());
+    double sum = 0.0;
+    for (double v : ms) sum += v;
+    std::cout << label
+              << ": avg " << sum / ms.size() << " ms"
+              << ", p50 " << ms[ms.size() / 2] << " ms"
+              << ", p99 " << ms[std::min(ms.size() - 1, ms.size() * 99 / 100)] << " ms"
+              << ", max " << ms.back() << " ms"
+              << " (" << ms.size() << " ok, " << failed << " failed)" << std::endl;
+}
+
+void api_latency_benchmark(const std::string& host, int port, const char* path, int n) {
+    std::vector<double> fresh, kept;
+    int freshFailed = 0, keptFailed = 0;
+
+    for (int i = 0; i < n; i++) {
+        auto t0 = std::chrono::steady_clock::now();
+        httplib::Client cli(host, port);
+        auto res = cli.Get(path);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if (res && res->status == 200) fresh.push_back(ms); else freshFailed++;
+    }
+
+    ApiConnection conn(host, port);
+    for (int i = 0; i < n; i++) {
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = conn.get(path);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if (ok) kept.push_back(ms); else keptFailed++;
+    }
+
+    std::cout << "GET " << path << " x" << n << " on " << host << ":" << port << std::endl;
+    print_latency("  new client per call", fresh, freshFailed);
+    print_latency("  keep-alive         ", kept, keptFailed);
+}
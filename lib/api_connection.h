@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace httplib { class Client; }
+class ApiHealth;
+
+// ============================
+// Keep-alive API connection
+// ============================
+// One long-lived HTTP/1.1 connection to go-librespot instead of a new TCP
+// connection per call. A request that fails on a stale socket is retried
+// once on a fresh connection. Calls are serialized; use one instance per
+// thread that talks to the API concurrently.
+class ApiConnection {
+public:
+    struct Stats {
+        uint64_t requests;
+        uint64_t failures;
+        uint64_t reconnects;
+        uint64_t rejected;   // failed fast by the circuit breaker
+        double avgMs;
+        double maxMs;
+    };
+
+    ApiConnection(const std::string& host, int port);
+    ~ApiConnection();
+
+    void setTimeouts(int connectMs, int readMs);
+
+    // Shared circuit breaker; while it is open requests fail without I/O
+    void setHealth(ApiHealth* h) { health = h; }
+
+    // true on HTTP 200; body receives the response body when given
+    bool get(const char* path, std::string* body = nullptr);
+    bool post(const char* path, const std::string& json, std::string* body = nullptr);
+
+    Stats getStats() const;
+
+private:
+    bool request(bool isPost, const char* path, const std::string& json, std::string* body);
+    void reset();
+
+    std::string host;
+    int port;
+    int connectMs = 1000;
+    int readMs = 2000;
+
+    mutable std::mutex mutex;
+    std::unique_ptr<httplib::Client> client;
+    ApiHealth* health = nullptr;
+
+    uint64_t requests = 0;
+    uint64_t failures = 0;
+    uint64_t reconnects = 0;
+    uint64_t rejected = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+};
+
+// Times n GET requests with a fresh client per call vs one keep-alive
+// connection and prints both (spotamp --bench-http [n])
+void api_latency_benchmark(const std::string& host, int port, const char* path, int n);
@@ -0,0 +1,81 @@
+#include "api_health.h"
+
+#include <algorithm>
+#include <iostream>
+
+ApiHealth::ApiHealth()
+    : backoffMs(minBackoffMs),
+      retryAt(Clock::now())
+{
+}
+
+const char* ApiHealth::stateName(int state) {
+    switch (state) {
+        case STATE_CONNECTING: return "connecting";
+        case STATE_UP:         return "up";
+        case STATE_DOWN:       return "down";
+        case STATE_PROBING:    return "probing";
+        default:               return "?";
+    }
+}
+
+bool ApiHealth::allow() {
+    std::lock_guard<std::mutex> lock(mutex);
+    switch (state) {
+        case STATE_DOWN:
+            if (Clock::now() < retryAt)
+                return false;
+            state = STATE_PROBING;
+            return true;
+        case STATE_PROBING:
+            return false; // only the probe goes through
+        default:
+            return true;
+    }
+}
+
+void ApiHealth::success() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state != STATE_UP) {
+        generation++;
+        std::cout << "[api] go-librespot is up" << std::endl;
+    }
+    state = STATE_UP;
+    consecutiveFailures = 0;
+    backoffMs = minBackoffMs;
+}
+
+void ApiHealth::failure() {
+    std::lock_guard<std::mutex> lock(mutex);
+    consecutiveFailures++;
+
+    if (state == STATE_PROBING) {
+        // failed probe: back off further
+        backoffMs = std::min(backoffMs * 2, maxBackoffMs);
+    } else if (consecutiveFailures < failureThreshold) {
+        return;
+    } else if (state == STATE_UP) {
+        std::cout << "[api] go-librespot is not responding, backing off" << std::endl;
+    }
+
+    state = STATE_DOWN;
+    retryAt = Clock::now() + std::chrono::milliseconds(backoffMs);
+}
+
+ApiHealth::State ApiHealth::getState() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return state;
+}
+
+uint64_t ApiHealth::getGeneration() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return generation;
+}
+
+int ApiHealth::retryInMs() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state != STATE_DOWN)
+        return 0;
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(retryAt - Clock::now()).count();
+    return left > 0 ? (int)left : 0;
+}
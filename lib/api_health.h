@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <cstdint>
+
+// ============================
+// API health / circuit breaker
+// ============================
+// Shared by every connection to go-librespot. After a few consecutive
+// transport failures the breaker opens and requests fail fast (no socket,
+// no timeout) until an exponentially growing backoff expires; then a single
+// probe is let through. Each time the API comes (back) up the generation
+// counter increments so the UI can re-run its initialization.
+class ApiHealth {
+public:
+    enum State {
+        STATE_CONNECTING = 0, // never reached yet
+        STATE_UP,
+        STATE_DOWN,           // breaker open, waiting for backoff
+        STATE_PROBING         // half-open, one request in flight
+    };
+
+    ApiHealth();
+
+    // Ask before sending; false means fail fast
+    bool allow();
+    void success();
+    void failure();
+
+    State getState();
+    bool isUp() { return getState() == STATE_UP; }
+    uint64_t getGeneration();
+    // time left until the next probe, 0 when not backing off
+    int retryInMs();
+    static const char* stateName(int state);
+
+    int failureThreshold = 2;
+    int minBackoffMs = 250;
+    int maxBackoffMs = 8000;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::mutex mutex;
+    State state = STATE_CONNECTING;
+    int consecutiveFailures = 0;
+    int backoffMs = 0;
+    Clock::time_point retryAt;
+    uint64_t generation = 0;
+};
@@ -1,10 +1,17 @@
 #include "audio_engine.h"
 #include "audio_fft.h"
+#include "latency_probe.h"
+#include "loudness.h"
+#include "dynamics.h"
+#include "convolver.h"
 
+#include <algorithm>
 #include <atomic>
 #include <thread>
 #include <vector>
 #include <cstring>
+#include <cmath>
+#include <chrono>
 
 
 #define MINIAUDIO_IMPLEMENTATION
@@ -15,6 +22,7 @@
 #else
     #include <fcntl.h>
     #include <unistd.h>
+    #include <sys/ioctl.h>
     #include <sys/stat.h>
 #endif
 
@@ -42,15 +50,140 @@ static const char* PIPE_NAME = "/tmp/spotamp_audio";
 // ============================
 static ma_device device;
 static std::atomic<bool> running{false};
+static double deviceLatencyMs = 0.0; // device buffer, set once the device is up
+
+// ============================
+// Callback stats
+// ============================
+static std::atomic<float> statPeakLoad{0.0f};
+static std::atomic<uint32_t> statUnderruns{0};
+static std::atomic<uint64_t> statCallbacks{0};
+static std::atomic<uint64_t> framesPlayed{0};
+
+// ============================
+// Level ring (audio thread -> UI)
+// ============================
+// Single producer / single consumer; ~45 s of callbacks at 1024 frames
+static constexpr size_t LEVEL_RING = 2048;
+static AudioLevels levelRing[LEVEL_RING];
+static std::atomic<size_t> levelHead{0};   // next write, audio thread
+static std::atomic<size_t> levelTail{0};   // next read, consumer
+
+static void push_levels(const int16_t* samples, int frames, uint64_t firstFrame) {
+    size_t head = levelHead.load(std::memory_order_relaxed);
+    if (head - levelTail.load(std::memory_order_acquire) >= LEVEL_RING)
+        return; // nobody reading
+    int16_t lo = 32767, hi = -32768;
+    int64_t sum = 0;
+    for (int i = 0; i < frames * CHANNELS; i++) {
+        int s = samples[i];
+        lo = (int16_t)std::min<int>(lo, s);
+        hi = (int16_t)std::max<int>(hi, s);
+        sum += (int64_t)s * s;
+    }
+    AudioLevels& l = levelRing[head % LEVEL_RING];
+    l.firstFrame = firstFrame;
+    l.frames = (uint32_t)frames;
+    l.min = lo;
+    l.max = hi;
+    l.meanSquare = (float)((double)sum / ((double)frames * CHANNELS * 32768.0 * 32768.0));
+    levelHead.store(head + 1, std::memory_order_release);
+}
+
+size_t audio_read_levels(AudioLevels* out, size_t max) {
+    size_t tail = levelTail.load(std::memory_order_relaxed);
+    size_t head = levelHead.load(std::memory_order_acquire);
+    size_t n = std::min(max, head - tail);
+    for (size_t i = 0; i < n; i++)
+        out[i] = levelRing[(tail + i) % LEVEL_RING];
+    levelTail.store(tail + n, std::memory_order_release);
+    return n;
+}
+
+// a callback blocked for this many periods is a stalled producer, not CPU pressure
+static constexpr float STALL_PERIODS = 4.0f;
+
+static void record_callback(std::chrono::steady_clock::time_point start, ma_uint32 frameCount, bool underrun)
+{
+    float periodMs = frameCount * 1000.0f / SAMPLE_RATE;
+    float spentMs = std::chrono::duration<float, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    float load = periodMs > 0.0f ? spentMs / periodMs : 0.0f;
+
+    if (load < STALL_PERIODS) {
+        float prev = statPeakLoad.load(std::memory_order_relaxed);
+        while (load > prev && !statPeakLoad.compare_exchange_weak(prev, load, std::memory_order_relaxed)) {}
+    }
+    if (underrun)
+        statUnderruns.fetch_add(1, std::memory_order_relaxed);
+    statCallbacks.fetch_add(1, std::memory_order_relaxed);
+}
 
 // ============================
 // Miniaudio callback (reads pipe in real-time)
 // ============================
 extern AudioFFT* gAudioFFT; //FFT object defined in main.cpp
+extern LatencyProbe* gLatencyProbe; //set in main.cpp when --latency-probe is given
+extern LoudnessNormalizer* gLoudness; //loudness normalizer defined in main.cpp
+extern Dynamics* gDynamics; //output compressor / limiter defined in main.cpp
+extern Convolver* gConvolver; //set in main.cpp when --ir is given
+
+// ============================
+// Output DSP chain
+// ============================
+// s16 -> float, loudness gain, FIR convolution, compressor / limiter -> s16
+// in place. Gain stages work in float so only the limiter decides what
+// reaches full scale.
+static constexpr int DSP_CHUNK = 1024;
+static float dspBuffer[DSP_CHUNK * CHANNELS];   // audio thread only
+static int dspTail = 0;   // frames the chain may still hold, audio thread only
+
+static void run_dsp(int16_t* samples, int frames) {
+    for (int done = 0; done < frames; done += DSP_CHUNK) {
+        int n = std::min(DSP_CHUNK, frames - done);
+        int16_t* s = samples + done * CHANNELS;
+        if (gLoudness) {
+            gLoudness->process(s, dspBuffer, n);
+        } else {
+            for (int i = 0; i < n * CHANNELS; i++)
+                dspBuffer[i] = s[i] * (1.0f / 32768.0f);
+        }
+        if (gConvolver)
+            gConvolver->process(dspBuffer, n);
+        if (gDynamics) {
+            gDynamics->process(dspBuffer, s, n);
+        } else {
+            for (int i = 0; i < n * CHANNELS; i++)
+                s[i] = (int16_t)std::max(-32768.0f, std::min(32767.0f, std::nearbyint(dspBuffer[i] * 32768.0f)));
+        }
+    }
+    dspTail = (gDynamics ? gDynamics->latencyFrames() : 0) + (gConvolver ? gConvolver->tailFrames() : 0);
+}
 
+// When the pipe runs dry (pause, underrun, end of a track) the delay lines
+// still hold the last audio. Play it out into the silence that follows, so
+// it is not heard at the next resume (e.g. the old track's tail at a Load).
+static void flush_dsp(uint8_t* out, int fromFrame, int frameCount) {
+    if (dspTail <= 0 || fromFrame >= frameCount)
+        return;
+    int n = std::min(dspTail, frameCount - fromFrame);
+    int tail = dspTail - n;
+    run_dsp(reinterpret_cast<int16_t*>(out) + fromFrame * CHANNELS, n);   // zero padding in, tail out
+    dspTail = tail;
+}
+
+static void probe_block(std::chrono::steady_clock::time_point start, const uint8_t* out,
+                        int framesRead, ma_uint32 frameCount)
+{
+    if (gLatencyProbe)
+        gLatencyProbe->onBlock(start, std::chrono::steady_clock::now(),
+                               reinterpret_cast<const int16_t*>(out), framesRead,
+                               (int)frameCount, SAMPLE_RATE, deviceLatencyMs);
+}
 
 static void audio_callback(ma_device*, void* output, const void*, ma_uint32 frameCount)
 {
+    auto start = std::chrono::steady_clock::now();
     size_t bytesNeeded = frameCount * FRAME_BYTES;
     uint8_t* out = static_cast<uint8_t*>(output);
 
@@ -63,6 +196,8 @@ static void audio_callback(ma_device*, void* output, const void*, ma_uint32 fram
     DWORD bytesRead = 0;
     if (!ReadFile(pipeHandle, out, (DWORD)bytesNeeded, &bytesRead, NULL) || bytesRead == 0) {
         std::memset(out, 0, bytesNeeded);
+        flush_dsp(out, 0, (int)frameCount);
+        probe_block(start, out, 0, frameCount);
         return;
     }
 
@@ -71,6 +206,7 @@ static void audio_callback(ma_device*, void* output, const void*, ma_uint32 fram
     }
 
     int framesRead = bytesRead / FRAME_BYTES;
+    bool underrun = (size_t)bytesRead < bytesNeeded;
 
 #else
     if (pipeFd < 0) {
@@ -81,6 +217,8 @@ static void audio_callback(ma_device*, void* output, const void*, ma_uint32 fram
     ssize_t bytesRead = read(pipeFd, out, bytesNeeded);
     if (bytesRead <= 0) {
         std::memset(out, 0, bytesNeeded);
+        flush_dsp(out, 0, (int)frameCount);
+        probe_block(start, out, 0, frameCount);
         return;
     }
 
@@ -89,8 +227,24 @@ static void audio_callback(ma_device*, void* output, const void*, ma_uint32 fram
     }
 
     int framesRead = bytesRead / FRAME_BYTES;
+    bool underrun = (size_t)bytesRead < bytesNeeded;
 #endif
 
+    if (framesRead > 0) {
+        uint64_t first = framesPlayed.fetch_add(framesRead, std::memory_order_relaxed);
+        push_levels(reinterpret_cast<const int16_t*>(out), framesRead, first);
+        // the seek bar waveform shows the track; everything after hears the chain
+        if (gLoudness || gConvolver || gDynamics)
+            run_dsp(reinterpret_cast<int16_t*>(out), framesRead);
+    }
+    if (underrun) {
+        // partial frame bytes at the end are dropped
+        std::memset(out + (size_t)framesRead * FRAME_BYTES, 0, bytesNeeded - (size_t)framesRead * FRAME_BYTES);
+        flush_dsp(out, framesRead, (int)frameCount);
+    }
+
+    probe_block(start, out, framesRead, frameCount);
+
     //push ONLY valid frames
     if (gAudioFFT && framesRead > 0) {
         // static int dbg = 0;
@@ -100,6 +254,8 @@ static void audio_callback(ma_device*, void* output, const void*, ma_uint32 fram
         // }
         gAudioFFT->pushAudio(reinterpret_cast<int16_t*>(out), framesRead);
     }
+
+    record_callback(start, frameCount, underrun);
 }
 
 // ============================
@@ -162,9 +318,56 @@ bool audio_init() {
         return false;
     }
 
+    // audio written by the callback plays after the rest of the device buffer
+    if (device.playback.internalSampleRate > 0) {
+        deviceLatencyMs = (double)device.playback.internalPeriodSizeInFrames *
+                          device.playback.internalPeriods * 1000.0 /
+                          device.playback.internalSampleRate;
+    }
+    // plus the fixed delays of the convolver block and the limiter look-ahead
+    if (gConvolver)
+        deviceLatencyMs += gConvolver->latencyFrames() * 1000.0 / SAMPLE_RATE;
+    if (gDynamics)
+        deviceLatencyMs += gDynamics->latencyFrames() * 1000.0 / SAMPLE_RATE;
+
     return true;
 }
 
+AudioStats audio_get_stats() {
+    AudioStats stats;
+    stats.callbackLoad = statPeakLoad.exchange(0.0f);
+    stats.underruns    = statUnderruns.load();
+    stats.callbacks    = statCallbacks.load();
+    return stats;
+}
+
+uint64_t audio_get_frames_played() {
+    return framesPlayed.load(std::memory_order_relaxed);
+}
+
+int audio_get_sample_rate() {
+    return SAMPLE_RATE;
+}
+
+double audio_get_pipe_backlog_ms() {
+    long bytes = 0;
+#ifdef _WIN32
+    DWORD avail = 0;
+    if (pipeHandle != INVALID_HANDLE_VALUE &&
+        PeekNamedPipe(pipeHandle, NULL, 0, NULL, &avail, NULL))
+        bytes = (long)avail;
+#else
+    int avail = 0;
+    if (pipeFd >= 0 && ioctl(pipeFd, FIONREAD, &avail) == 0)
+        bytes = avail;
+#endif
+    return bytes / (double)FRAME_BYTES * 1000.0 / SAMPLE_RATE;
+}
+
+double audio_get_output_latency_ms() {
+    return deviceLatencyMs;
+}
+
 void audio_shutdown() {
     running = false;
 
@@ -1,4 +1,42 @@
 #pragma once
 
+#include <cstdint>
+#include <cstddef>
+
 bool audio_init();
 void audio_shutdown();
+
+// Device callback health, for the quality governor.
+// callbackLoad is the worst callback time / buffer period since the last call
+// (stalls where the pipe had no producer, e.g. while paused, are not counted).
+struct AudioStats {
+    float callbackLoad;
+    uint32_t underruns;
+    uint64_t callbacks;
+};
+
+AudioStats audio_get_stats();
+
+// Audio clock: stereo frames of real pipe data handed to the device so far
+// (silence fill while nothing arrives is not counted)
+uint64_t audio_get_frames_played();
+int audio_get_sample_rate();
+
+// Level summary of one callback's worth of real pipe data (both channels),
+// for the seek bar waveform
+struct AudioLevels {
+    uint64_t firstFrame;   // audio clock at its first frame
+    uint32_t frames;
+    int16_t min, max;
+    float meanSquare;      // of the samples, in full-scale units squared (0..1)
+};
+
+// Takes up to max summaries, oldest first. The audio thread drops new ones
+// while about 45 s of them are unread.
+size_t audio_read_levels(AudioLevels* out, size_t max);
+
+// Audio queued in the FIFO but not read yet, and the device buffer after the
+// callback plus the fixed delays of the output DSP (convolver block, limiter
+// look-ahead); both in ms (used by the latency probe)
+double audio_get_pipe_backlog_ms();
+double audio_get_output_latency_ms();
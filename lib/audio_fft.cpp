@@ -12,23 +12,144 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+static constexpr int SAMPLE_RATE = 44100;
+static constexpr int MAX_DECIMATION = 16;
+
+// ============================
+// AudioAnalyzer
+// ============================
+AudioAnalyzer::AudioAnalyzer(const char* name_, float budgetMs_)
+    : budgetMs(budgetMs_),
+      name(name_)
+{
+}
+
+// ============================
+// SpectrumAnalyzer
+// ============================
+SpectrumAnalyzer::SpectrumAnalyzer(int displayBins)
+    : AudioAnalyzer("spectrum", 0.5f)
+{
+    // Number of vertical lines in ImGui plot
+    displayVector.resize(displayBins, 0.0f);
+    work.resize(displayBins, 0.0f);
+    logBinStart.resize(displayBins);
+    logBinEnd.resize(displayBins);
+}
+
+// ---- Precompute log-frequency bin mapping (once per FFT size) ----
+void SpectrumAnalyzer::buildBinMap(int fftSize, int sampleRate) {
+    const int displayBins = (int)work.size();
+    const float minFreq = 20.0f;
+    const float maxFreq = sampleRate * 0.5f;
+
+    for (int i = 0; i < displayBins; i++) {
+        float t0 = i / (float)displayBins;
+        float t1 = (i + 1) / (float)displayBins;
+
+        float f0 = minFreq * std::pow(maxFreq / minFreq, t0);
+        float f1 = minFreq * std::pow(maxFreq / minFreq, t1);
+
+        int b0 = (int)(f0 * fftSize / sampleRate);
+        int b1 = (int)(f1 * fftSize / sampleRate);
+
+        b0 = std::clamp(b0, 1, fftSize / 2);
+        b1 = std::clamp(b1, b0 + 1, fftSize / 2 + 1);
+
+        logBinStart[i] = b0;
+        logBinEnd[i]   = b1;
+    }
+
+    magnitudeDb.assign(fftSize / 2 + 1, -100.0f);
+    mappedFftSize = fftSize;
+}
+
+void SpectrumAnalyzer::process(const SpectrumFrame& frame) {
+    constexpr float smoothing = 0.80f;
+    constexpr float dbMin = -100.0f;
+    constexpr float dbMax = -20.0f;
+    constexpr float eps   = 1e-12f;
+
+    if (frame.fftSize != mappedFftSize)
+        buildBinMap(frame.fftSize, frame.sampleRate);
+
+    // ---- Power → dB ----
+    const int bins = frame.fftSize / 2 + 1;
+    for (int i = 1; i < bins; i++) {
+        float db = 10.0f * std::log10(frame.power[i] + eps);
+        db = std::clamp(db, dbMin, dbMax);
+        magnitudeDb[i] = magnitudeDb[i] * smoothing + db * (1.0f - smoothing);
+    }
 
-AudioFFT::AudioFFT(int fftSize_)
-    : fftSize(fftSize_),
+    // ---- Log-frequency downsampling with bin averaging ----
+    const int displayBins = (int)work.size();
+    for (int i = 0; i < displayBins; i++) {
+        float sum = 0.0f;
+        int count = 0;
+
+        for (int b = logBinStart[i]; b < logBinEnd[i]; b++) {
+            sum += magnitudeDb[b];
+            count++;
+        }
+
+        float db = (count > 0) ? sum / count : dbMin;
+
+        float norm = (db - dbMin) / (dbMax - dbMin);
+        work[i] = std::clamp(norm, 0.0f, 1.0f);
+    }
+
+    std::lock_guard<std::mutex> lock(displayMutex);
+    for (int i = 0; i < displayBins; i++)
+        displayVector[i] = displayVector[i] * smoothing + work[i] * (1.0f - smoothing);
+}
+
+void SpectrumAnalyzer::getDisplay(std::vector<float>& out) {
+    std::lock_guard<std::mutex> lock(displayMutex);
+    out = displayVector;
+}
+
+// ============================
+// AudioFFT
+// ============================
+AudioFFT::AudioFFT(int fftSize_, int workerCount_)
+    : capacity(fftSize_),
+      fftSize(0),
+      sampleRate(SAMPLE_RATE),
+      requestedSize(fftSize_),
+      hopMs(16),
+      analysisEnabled(true),
+      paused(false),
       writeIndex(0),
       running(false),
       hasData(false),
-      peak(1e-3f)
+      frameIndex(0),
+      pushCount(0),
+      workerCount(workerCount_)
 {
-    audioBuffer.resize(fftSize, 0.0f);
-    fftInput.resize(fftSize, 0.0f);
-    fftMagnitude.resize(fftSize / 2 + 1, 0.0f);
+    audioBuffer.resize(capacity, 0.0f);
+    resize(capacity);
 
-    // Number of vertical lines in ImGui plot
-    displayVector.resize(200, 0.0f);
     waveform.resize(512, 0.0f);
 }
 
+void AudioFFT::resize(int size) {
+    fftSize = size;
+    fftInput.assign(fftSize, 0.0f);
+    power.assign(fftSize / 2 + 1, 0.0f);
+
+    // Hann window
+    window.resize(fftSize);
+    for (int i = 0; i < fftSize; i++)
+        window[i] = 0.5f * (1.0f - std::cos(2.0f * M_PI * i / (fftSize - 1)));
+}
+
+void AudioFFT::setFftSize(int size) {
+    int n = 64;
+    while (n * 2 <= size && n * 2 <= capacity)
+        n *= 2;
+    requestedSize = std::min(n, capacity);
+}
+
 AudioFFT::~AudioFFT() {
     stop();
 }
@@ -36,140 +157,220 @@ AudioFFT::~AudioFFT() {
 void AudioFFT::start() {
     running = true;
     fftThread = std::thread(&AudioFFT::threadFunc, this);
+    for (int i = 0; i < workerCount; i++)
+        workers.emplace_back(&AudioFFT::workerFunc, this);
 }
 
 void AudioFFT::stop() {
-    running = false;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        running = false;
+    }
+    poolCv.notify_all();
+    doneCv.notify_all();
+
     if (fftThread.joinable())
         fftThread.join();
+    for (auto& w : workers)
+        if (w.joinable())
+            w.join();
+    workers.clear();
+}
+
+void AudioFFT::addAnalyzer(AudioAnalyzer* analyzer) {
+    std::lock_guard<std::mutex> lock(analyzerMutex);
+    if (std::find(analyzers.begin(), analyzers.end(), analyzer) == analyzers.end())
+        analyzers.push_back(analyzer);
+}
+
+void AudioFFT::removeAnalyzer(AudioAnalyzer* analyzer) {
+    // The FFT thread holds analyzerMutex for a whole frame, so once we own it
+    // the analyzer is guaranteed not to be inside process()
+    std::lock_guard<std::mutex> lock(analyzerMutex);
+    analyzers.erase(std::remove(analyzers.begin(), analyzers.end(), analyzer), analyzers.end());
 }
 
 // Push stereo interleaved s16 samples
 void AudioFFT::pushAudio(const int16_t* samples, int frameCount) {
+    if (paused)
+        return;
+
     for (int i = 0; i < frameCount; i++) {
         float mono =
             (samples[i * 2] + samples[i * 2 + 1]) * (1.0f / 32768.0f) * 0.5f;
 
         audioBuffer[writeIndex] = mono;
-        writeIndex = (writeIndex + 1) % fftSize;
+        writeIndex = (writeIndex + 1) % capacity;
 
         if (writeIndex == 0)
             hasData = true;
     }
 
     // DEBUG waveform capture
-    for (int i = 0; i < frameCount && i < waveform.size(); i++) {
+    for (int i = 0; i < frameCount && i < (int)waveform.size(); i++) {
         waveform[i] = (samples[i*2] + samples[i*2+1]) * (1.0f / 65536.0f);
     }
-}
-
-void AudioFFT::threadFunc() {
-    // static constexpr int SAMPLE_RATE       = 44100;
-    // using namespace pocketfft;
-
-    // const float smoothing = 0.80f;
-    // const int displayBins = (int)displayVector.size();
-
-    // shape_t shape{ (size_t)fftSize };
-    // stride_t stride{ 1 };
-    // shape_t axes{ 0 };
-
-    // std::vector<std::complex<float>> fftOut(fftSize / 2 + 1);
-
-    // // ---- Precompute log-frequency bin mapping (ONCE) ----
-    // const float minFreq = 20.0f;
-    // const float maxFreq = SAMPLE_RATE * 0.5f;
-
-    // std::vector<int> logBinStart(displayBins);
-    // std::vector<int> logBinEnd(displayBins);
-
-    // for (int i = 0; i < displayBins; i++) {
-    //     float t0 = i / (float)displayBins;
-    //     float t1 = (i + 1) / (float)displayBins;
-
-    //     float f0 = minFreq * std::pow(maxFreq / minFreq, t0);
-    //     float f1 = minFreq * std::pow(maxFreq / minFreq, t1);
-
-    //     int b0 = (int)(f0 * fftSize / SAMPLE_RATE);
-    //     int b1 = (int)(f1 * fftSize / SAMPLE_RATE);
 
-    //     b0 = std::clamp(b0, 1, fftSize / 2);
-    //     b1 = std::clamp(b1, b0 + 1, fftSize / 2 + 1);
-
-    //     logBinStart[i] = b0;
-    //     logBinEnd[i]   = b1;
-    // }
-
-    // constexpr float dbMin = -100.0f;
-    // constexpr float dbMax = -20.0f;
-    // constexpr float eps   = 1e-12f;
-
-    // std::vector<float> prevDisplay(displayBins, 0.0f);
-
-    // while (running) {
-    //     if (!hasData) {
-    //         std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    //         continue;
-    //     }
-
-    //     // ---- Copy circular buffer (oldest -> newest) ----
-    //     int start = writeIndex.load();
-    //     for (int i = 0; i < fftSize; i++)
-    //         fftInput[i] = audioBuffer[(start + i) % fftSize];
+    pushCount++;
+}
 
-    //     // ---- Hann window ----
-    //     for (int i = 0; i < fftSize; i++) {
-    //         float w = 0.5f * (1.0f - std::cos(2.0f * M_PI * i / (fftSize - 1)));
-    //         fftInput[i] *= w;
-    //     }
+void AudioFFT::computeFrame() {
+    using namespace pocketfft;
 
-    //     // ---- Remove DC offset ----
-    //     float mean = 0.0f;
-    //     for (float v : fftInput)
-    //         mean += v;
-    //     mean /= fftSize;
+    static thread_local std::vector<std::complex<float>> fftOut;
+    fftOut.resize(fftSize / 2 + 1);
 
-    //     for (float& v : fftInput)
-    //         v -= mean;
+    // ---- Copy the newest fftSize samples of the ring (oldest -> newest) ----
+    int start = writeIndex.load() - fftSize + capacity;
+    for (int i = 0; i < fftSize; i++)
+        fftInput[i] = audioBuffer[(start + i) % capacity];
 
-    //     // ---- FFT ----
-    //     r2c(shape, stride, stride, axes,
-    //         FORWARD, fftInput.data(), fftOut.data(), 1.0f);
+    // ---- Remove DC offset, then Hann window ----
+    float mean = 0.0f;
+    for (float v : fftInput)
+        mean += v;
+    mean /= fftSize;
 
-    //     fftOut[0] = 0.0f; // kill DC explicitly
+    for (int i = 0; i < fftSize; i++)
+        fftInput[i] = (fftInput[i] - mean) * window[i];
 
-    //     // ---- Power → dB ----
-    //     for (size_t i = 1; i < fftOut.size(); i++) {
-    //         float power = std::norm(fftOut[i]);           // REAL FIX
-    //         float db = 10.0f * std::log10(power + eps);   // power → dB
+    // ---- FFT ----
+    shape_t shape{ (size_t)fftSize };
+    stride_t strideIn{ sizeof(float) };
+    stride_t strideOut{ sizeof(std::complex<float>) };
+    shape_t axes{ 0 };
 
-    //         db = std::clamp(db, dbMin, dbMax);
+    r2c(shape, strideIn, strideOut, axes,
+        FORWARD, fftInput.data(), fftOut.data(), 1.0f);
 
-    //         fftMagnitude[i] =
-    //             fftMagnitude[i] * smoothing + db * (1.0f - smoothing);
-    //     }
+    // ---- Power spectrum, DC killed explicitly ----
+    power[0] = 0.0f;
+    for (size_t i = 1; i < fftOut.size(); i++)
+        power[i] = std::norm(fftOut[i]);
+}
 
-    //     // ---- Log-frequency downsampling with bin averaging ----
-    //     for (int i = 0; i < displayBins; i++) {
-    //         float sum = 0.0f;
-    //         int count = 0;
+void AudioFFT::runAnalyzer(AudioAnalyzer* analyzer) {
+    if (analyzer->skip > 0) {
+        analyzer->skip--;
+        return;
+    }
 
-    //         for (int b = logBinStart[i]; b < logBinEnd[i]; b++) {
-    //             sum += fftMagnitude[b];
-    //             count++;
-    //         }
+    auto t0 = std::chrono::steady_clock::now();
+    analyzer->process(jobFrame);
+    float costMs = std::chrono::duration<float, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
 
-    //         float db = (count > 0) ? sum / count : dbMin;
+    analyzer->lastCostMs = costMs;
 
-    //         float norm = (db - dbMin) / (dbMax - dbMin);
-    //         norm = std::clamp(norm, 0.0f, 1.0f);
+    // Adapt the decimation so the analyzer stays inside its budget on average
+    int d = analyzer->decimation;
+    if (costMs > analyzer->budgetMs) {
+        analyzer->overruns++;
+        d = std::min(d * 2, MAX_DECIMATION);
+    } else if (costMs < analyzer->budgetMs * 0.5f && d > 1) {
+        d /= 2;
+    }
+    analyzer->decimation = d;
+    analyzer->skip = d - 1;
+}
 
-    //         displayVector[i] =
-    //             prevDisplay[i] * smoothing + norm * (1.0f - smoothing);
-    //     }
+// Pull jobs of the batch's generation until none are left (or a newer
+// generation was dispatched, which means this one is finished)
+void AudioFFT::runJobs(const JobBatch& batch) {
+    const uint64_t tag = batch.generation << 32;
+    for (;;) {
+        uint64_t claim = nextJob.load();
+        do {
+            if ((claim & ~0xffffffffull) != tag || (int)(claim & 0xffffffffu) >= batch.count)
+                return;
+        } while (!nextJob.compare_exchange_weak(claim, claim + 1));
+
+        runAnalyzer(batch.jobs[claim & 0xffffffffu]);
+
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (--jobsPending == 0)
+            doneCv.notify_all();
+    }
+}
 
-    //     prevDisplay = displayVector;
+void AudioFFT::workerFunc() {
+    uint64_t seen = 0;
+    for (;;) {
+        JobBatch mine;
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            poolCv.wait(lock, [&] { return !running || jobGeneration != seen; });
+            if (!running)
+                return;
+            seen = jobGeneration;
+            mine = batch;
+        }
+        runJobs(mine);
+    }
+}
 
-    //     std::this_thread::sleep_for(std::chrono::milliseconds(16));
-    // }
+void AudioFFT::threadFunc() {
+    std::vector<AudioAnalyzer*> active;
+
+    while (running) {
+        auto frame_start = std::chrono::steady_clock::now();
+
+        if (requestedSize != fftSize)
+            resize(requestedSize);
+
+        // ---- Snapshot enabled analyzers (hidden ones cost nothing) ----
+        std::unique_lock<std::mutex> analyzerLock(analyzerMutex);
+        active.clear();
+        if (analysisEnabled && !paused) {
+            for (AudioAnalyzer* a : analyzers)
+                if (a->isEnabled())
+                    active.push_back(a);
+        }
+
+        if (!hasData || active.empty()) {
+            analyzerLock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        computeFrame();
+
+        // ---- Dispatch the frame to the pool; this thread helps out ----
+        JobBatch mine;
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            jobs.swap(active);
+            jobFrame.samples    = fftInput.data();
+            jobFrame.power      = power.data();
+            jobFrame.fftSize    = fftSize;
+            jobFrame.sampleRate = sampleRate;
+            jobFrame.index      = frameIndex;
+            jobsPending = (int)jobs.size();
+            jobGeneration++;
+            nextJob = (jobGeneration & 0xffffffffu) << 32;
+            batch = JobBatch{jobGeneration & 0xffffffffu, jobs.data(), (int)jobs.size()};
+            mine = batch;
+        }
+        if (mine.count > 1)
+            poolCv.notify_all();
+
+        runJobs(mine);
+
+        {
+            // even when stopping: jobs points into active and the analyzers
+            // are only safe under analyzerLock. runJobs() above leaves no job
+            // unclaimed, so this only waits for the ones still running.
+            std::unique_lock<std::mutex> lock(poolMutex);
+            doneCv.wait(lock, [&] { return jobsPending == 0; });
+            jobs.swap(active);
+        }
+        analyzerLock.unlock();
+
+        frameIndex++;
+
+        auto elapsed = std::chrono::steady_clock::now() - frame_start;
+        auto hop = std::chrono::milliseconds(hopMs);
+        if (elapsed < hop)
+            std::this_thread::sleep_for(hop - elapsed);
+    }
 }
@@ -3,11 +3,88 @@
 #include <vector>
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <cstdint>
 
+// ============================
+// Shared STFT frame
+// ============================
+// One frame is computed per hop by the FFT thread and handed (read only)
+// to every enabled analyzer, so N visuals cost one FFT instead of N.
+struct SpectrumFrame {
+    const float* samples = nullptr; // windowed time-domain block (fftSize)
+    const float* power   = nullptr; // |X|^2 per bin (fftSize / 2 + 1), DC zeroed
+    int fftSize    = 0;
+    int sampleRate = 0;
+    uint64_t index = 0;             // increments once per frame
+};
+
+// ============================
+// Analyzer interface
+// ============================
+// Consumers of the shared frame stream. process() runs on the analyzer
+// worker pool and must only touch the analyzer's own state.
+class AudioAnalyzer {
+public:
+    explicit AudioAnalyzer(const char* name, float budgetMs = 1.0f);
+    virtual ~AudioAnalyzer() = default;
+
+    virtual void process(const SpectrumFrame& frame) = 0;
+
+    const char* getName() const { return name; }
+
+    // Disabled analyzers are never scheduled; with none enabled the FFT is skipped too
+    void setEnabled(bool e) { enabled = e; }
+    bool isEnabled() const { return enabled; }
+
+    // CPU budget per frame. Analyzers running over it are decimated
+    // (run every 2nd, 4th, ... frame) until they fit again.
+    float budgetMs;
+
+    std::atomic<float> lastCostMs{0.0f};
+    std::atomic<uint32_t> overruns{0};
+    std::atomic<int> decimation{1};
+
+private:
+    friend class AudioFFT;
+
+    const char* name;
+    std::atomic<bool> enabled{true};
+    int skip = 0;
+};
+
+// ============================
+// Spectrum analyzer (log-frequency bars)
+// ============================
+class SpectrumAnalyzer : public AudioAnalyzer {
+public:
+    explicit SpectrumAnalyzer(int displayBins = 200);
+
+    void process(const SpectrumFrame& frame) override;
+
+    // copy of the latest normalized (0..1) bars, safe to call from the UI thread
+    void getDisplay(std::vector<float>& out);
+
+private:
+    void buildBinMap(int fftSize, int sampleRate);
+
+    int mappedFftSize = 0;
+    std::vector<int> logBinStart;
+    std::vector<int> logBinEnd;
+    std::vector<float> magnitudeDb;
+    std::vector<float> work;
+
+    std::mutex displayMutex;
+    std::vector<float> displayVector;
+};
+
+// ============================
+// FFT / analyzer host
+// ============================
 class AudioFFT {
 public:
-    explicit AudioFFT(int fftSize = 1024);
+    explicit AudioFFT(int fftSize = 1024, int workerCount = 2);
     ~AudioFFT();
 
     void start();
@@ -16,29 +93,88 @@ public:
     // frameCount = number of stereo frames
     void pushAudio(const int16_t* samples, int frameCount);
 
-    std::vector<float>& getDisplayVector() { return displayVector; }
-    std::vector<float> waveform;
-    std::vector<float> fftMagnitude;
+    // Analyzers are owned by the caller and must outlive their registration
+    void addAnalyzer(AudioAnalyzer* analyzer);
+    void removeAnalyzer(AudioAnalyzer* analyzer);
+
+    uint64_t getFrameIndex() const { return frameIndex; }
+    // increments once per pushAudio() block, lets the UI notice new waveform data
+    uint64_t getPushCount() const { return pushCount; }
 
+    // Runtime quality knobs (safe from any thread, applied on the next frame).
+    // The FFT size is clamped to a power of two no larger than the constructor size.
+    void setFftSize(int size);
+    int getFftSize() const { return requestedSize; }
+    int getMaxFftSize() const { return capacity; }
+    void setHopMs(int ms) { hopMs = ms < 1 ? 1 : ms; }
+    int getHopMs() const { return hopMs; }
+
+    // Master switch over all analyzers, independent of their own enabled flag
+    void setAnalysisEnabled(bool e) { analysisEnabled = e; }
+    bool isAnalysisEnabled() const { return analysisEnabled; }
+
+    // Power saving: while paused pushAudio() is a no-op and no frames are
+    // computed. Playback is unaffected; resuming picks up with the next block.
+    void setPaused(bool p) { paused = p; }
+    bool isPaused() const { return paused; }
+
+    std::vector<float> waveform;
 
 private:
+    // One dispatched frame's jobs, copied under poolMutex; the analyzer
+    // list it points to stays put until every job of that generation is done
+    struct JobBatch {
+        uint64_t generation;   // low 32 bits of jobGeneration
+        AudioAnalyzer* const* jobs;
+        int count;
+    };
+
     void threadFunc();
+    void workerFunc();
+    void runJobs(const JobBatch& batch);
+    void runAnalyzer(AudioAnalyzer* analyzer);
+    void computeFrame();
+    void resize(int size);
 
-    int fftSize;
+    int capacity;       // ring size, upper bound for fftSize
+    int fftSize;        // only touched by the FFT thread
+    int sampleRate;
+    std::atomic<int> requestedSize;
+    std::atomic<int> hopMs;
+    std::atomic<bool> analysisEnabled;
+    std::atomic<bool> paused;
 
-    // Circular audio buffer
+    // Circular audio buffer (capacity samples)
     std::vector<float> audioBuffer;
     std::vector<float> fftInput;
-    
+    std::vector<float> window;
+    std::vector<float> power;
 
-    // What ImGui reads
-    std::vector<float> displayVector;
-    
     // Threading / state
     std::atomic<int> writeIndex;
     std::atomic<bool> running;
     std::atomic<bool> hasData;
-    float peak;
+    std::atomic<uint64_t> frameIndex;
+    std::atomic<uint64_t> pushCount;
 
     std::thread fftThread;
+
+    // Registered analyzers
+    std::mutex analyzerMutex;
+    std::vector<AudioAnalyzer*> analyzers;
+
+    // Worker pool (fixed size, one frame in flight at a time)
+    int workerCount;
+    std::vector<std::thread> workers;
+    std::mutex poolMutex;
+    std::condition_variable poolCv;
+    std::condition_variable doneCv;
+    uint64_t jobGeneration = 0;
+    int jobsPending = 0;
+    // low 32 bits of the generation, then the next job index; a worker
+    // holding an older batch cannot claim from a newer one
+    std::atomic<uint64_t> nextJob{0};
+    std::vector<AudioAnalyzer*> jobs;
+    JobBatch batch{0, nullptr, 0};
+    SpectrumFrame jobFrame;
 };
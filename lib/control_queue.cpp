@@ -0,0 +1,76 @@
+#include "control_queue.h"
+
+// Short timeouts: go-librespot is local, anything slower than this is wedged
+static constexpr int CONNECT_TIMEOUT_MS = 300;
+static constexpr int READ_TIMEOUT_MS    = 1500;
+
+ControlQueue::ControlQueue(const std::string& host, int port) {
+    for (auto& lane : lanes) {
+        lane.conn.reset(new ApiConnection(host, port));
+        lane.conn->setTimeouts(CONNECT_TIMEOUT_MS, READ_TIMEOUT_MS);
+        lane.conn->setHealth(&health);
+    }
+}
+
+ControlQueue::~ControlQueue() {
+    stop();
+}
+
+void ControlQueue::start() {
+    running = true;
+    for (int i = 0; i < LANE_COUNT; i++)
+        lanes[i].thread = std::thread(&ControlQueue::workerFunc, this, i);
+}
+
+void ControlQueue::stop() {
+    running = false;
+    for (auto& lane : lanes) {
+        {
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            lane.queue.clear();
+        }
+        lane.cv.notify_all();
+        if (lane.thread.joinable())
+            lane.thread.join();
+    }
+}
+
+void ControlQueue::post(Lane lane, Task task, const char* key) {
+    LaneState& l = lanes[lane];
+    {
+        std::lock_guard<std::mutex> lock(l.mutex);
+        if (key) {
+            for (auto& cmd : l.queue) {
+                if (cmd.key == key) {
+                    // keep its place in line, send only the newest value
+                    cmd.task = std::move(task);
+                    coalescedCount++;
+                    return;
+                }
+            }
+        }
+        l.queue.push_back(Command{key ? key : "", std::move(task)});
+    }
+    l.cv.notify_one();
+}
+
+size_t ControlQueue::pending(Lane lane) {
+    std::lock_guard<std::mutex> lock(lanes[lane].mutex);
+    return lanes[lane].queue.size();
+}
+
+void ControlQueue::workerFunc(int lane) {
+    LaneState& l = lanes[lane];
+    for (;;) {
+        Command cmd;
+        {
+            std::unique_lock<std::mutex> lock(l.mutex);
+            l.cv.wait(lock, [&] { return !running || !l.queue.empty(); });
+            if (!running)
+                return;
+            cmd = std::move(l.queue.front());
+            l.queue.pop_front();
+        }
+        cmd.task(*l.conn);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+#include "api_connection.h"
+#include "api_health.h"
+
+// ============================
+// Asynchronous control queue
+// ============================
+// Posting a command returns immediately; it runs later on a background
+// worker. Each lane has its own worker thread and keep-alive connection,
+// so playback commands never wait behind a status poll. Commands posted
+// with a key supersede a queued, not yet started command with the same key
+// (only the latest volume or seek target is ever sent).
+class ControlQueue {
+public:
+    enum Lane {
+        LANE_PLAYBACK = 0, // user commands: play/pause, skip, load, volume, seek
+        LANE_STATUS,       // polling
+        LANE_COUNT
+    };
+
+    using Task = std::function<void(ApiConnection&)>;
+
+    ControlQueue(const std::string& host, int port);
+    ~ControlQueue();
+
+    void start();
+    void stop();
+
+    void post(Lane lane, Task task, const char* key = nullptr);
+
+    size_t pending(Lane lane);
+    uint64_t coalesced() const { return coalescedCount; }
+    ApiConnection& connection(Lane lane) { return *lanes[lane].conn; }
+    ApiHealth& getHealth() { return health; }
+
+private:
+    struct Command {
+        std::string key;
+        Task task;
+    };
+
+    struct LaneState {
+        std::unique_ptr<ApiConnection> conn;
+        std::deque<Command> queue;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::thread thread;
+    };
+
+    void workerFunc(int lane);
+
+    ApiHealth health;
+    LaneState lanes[LANE_COUNT];
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> coalescedCount{0};
+};
@@ -0,0 +1,446 @@
+#include "convolver.h"
+
+#include "pocketfft_hdronly.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+
+// Real FFT of 2 * BLOCK points, planned once. Spectra are kept split
+// (re[], im[]) so the partition multiply-add vectorizes.
+struct Convolver::Plan {
+    pocketfft::detail::pocketfft_r<float> fft{2 * BLOCK};
+};
+
+// ============================
+// WAV reading
+// ============================
+static uint32_t read_le(const uint8_t* p, int bytes) {
+    uint32_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+// PCM 16 / 24 / 32 bit or IEEE float, any channel count; one vector per channel
+static bool read_wav(const std::string& path, int& rate, std::vector<std::vector<float>>& channels) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (file.size() < 12 || std::memcmp(file.data(), "RIFF", 4) != 0 || std::memcmp(file.data() + 8, "WAVE", 4) != 0)
+        return false;
+
+    int format = 0, count = 0, bits = 0;
+    const uint8_t* data = nullptr;
+    size_t dataSize = 0;
+    for (size_t pos = 12; pos + 8 <= file.size();) {
+        const uint8_t* chunk = file.data() + pos;
+        size_t size = read_le(chunk + 4, 4);
+        size_t avail = std::min(size, file.size() - pos - 8);
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && avail >= 16) {
+            format = (int)read_le(chunk + 8, 2);
+            count = (int)read_le(chunk + 10, 2);
+            rate = (int)read_le(chunk + 12, 4);
+            bits = (int)read_le(chunk + 22, 2);
+            if (format == 0xFFFE && avail >= 40)   // WAVE_FORMAT_EXTENSIBLE: sub format GUID
+                format = (int)read_le(chunk + 32, 2);
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            data = chunk + 8;
+            dataSize = avail;
+        }
+        pos += 8 + size + (size & 1);
+    }
+
+    bool pcm = format == 1 && (bits == 16 || bits == 24 || bits == 32);
+    bool ieee = format == 3 && bits == 32;
+    if (!data || count <= 0 || rate <= 0 || (!pcm && !ieee))
+        return false;
+
+    int bytes = bits / 8;
+    size_t frames = dataSize / ((size_t)bytes * count);
+    channels.assign(count, std::vector<float>(frames));
+    const uint8_t* p = data;
+    for (size_t f = 0; f < frames; f++) {
+        for (int c = 0; c < count; c++, p += bytes) {
+            float v;
+            if (ieee) {
+                uint32_t u = read_le(p, 4);
+                std::memcpy(&v, &u, 4);
+            } else {
+                // left-align, then the sign comes for free
+                int32_t s = (int32_t)(read_le(p, bytes) << (32 - bits));
+                v = s * (1.0f / 2147483648.0f);
+            }
+            channels[c][f] = v;
+        }
+    }
+    return true;
+}
+
+// ============================
+// Convolver
+// ============================
+Convolver::Convolver(int sampleRate_, int maxThreads_)
+    : sampleRate(sampleRate_),
+      maxThreads(std::max(1, maxThreads_)),
+      plan(new Plan()),
+      fftBuffer(2 * BLOCK)
+{
+}
+
+Convolver::~Convolver() {
+    stopWorkers();
+}
+
+bool Convolver::load(const std::string& path) {
+    int rate = 0;
+    std::vector<std::vector<float>> channels;
+    if (!read_wav(path, rate, channels)) {
+        std::cout << "[convolver] could not read " << path << " (PCM or float WAV expected)" << std::endl;
+        return false;
+    }
+    if (rate != sampleRate) {
+        std::cout << "[convolver] " << path << " is " << rate << " Hz, the output is " << sampleRate << " Hz"
+                  << std::endl;
+        return false;
+    }
+    if (channels.size() > 2) {
+        std::cout << "[convolver] " << path << " has " << channels.size() << " channels, 1 or 2 expected"
+                  << std::endl;
+        return false;
+    }
+    if (channels[0].empty()) {
+        std::cout << "[convolver] " << path << " is empty" << std::endl;
+        return false;
+    }
+
+    size_t maxFrames = (size_t)(MAX_IR_SECONDS * sampleRate);
+    if (channels[0].size() > maxFrames) {
+        std::cout << "[convolver] " << path << " cut to " << MAX_IR_SECONDS << " s" << std::endl;
+        for (auto& ch : channels)
+            ch.resize(maxFrames);
+    }
+
+    size_t slash = path.find_last_of("/\\");
+    name = slash == std::string::npos ? path : path.substr(slash + 1);
+    setImpulse(channels[0], channels.size() > 1 ? channels[1] : std::vector<float>());
+    return true;
+}
+
+// halfcomplex (r0, r1, i1, ..., r[n/2]) <-> split spectra
+void Convolver::forward(const float* time, float* re, float* im) {
+    std::copy(time, time + 2 * BLOCK, fftBuffer.begin());
+    plan->fft.exec(fftBuffer.data(), 1.0f, true);
+    re[0] = fftBuffer[0];
+    im[0] = 0.0f;
+    for (int k = 1; k < BLOCK; k++) {
+        re[k] = fftBuffer[2 * k - 1];
+        im[k] = fftBuffer[2 * k];
+    }
+    re[BLOCK] = fftBuffer[2 * BLOCK - 1];
+    im[BLOCK] = 0.0f;
+}
+
+void Convolver::setImpulse(const std::vector<float>& left, const std::vector<float>& right) {
+    stopWorkers();
+
+    irChannels = right.empty() ? 1 : 2;
+    irFrames = std::max(left.size(), right.size());
+    partitionCount = (int)((irFrames + BLOCK - 1) / BLOCK);
+    size_t spectra = (size_t)partitionCount * BINS;
+
+    // each partition zero padded to 2 * BLOCK; 1 / N folded in for the inverse
+    irRe.assign(irChannels * spectra, 0.0f);
+    irIm.assign(irChannels * spectra, 0.0f);
+    std::vector<float> padded(2 * BLOCK);
+    const float scale = 1.0f / (2 * BLOCK);
+    for (int c = 0; c < irChannels; c++) {
+        const std::vector<float>& ir = c == 0 ? left : right;
+        for (int p = 0; p < partitionCount; p++) {
+            std::fill(padded.begin(), padded.end(), 0.0f);
+            size_t from = (size_t)p * BLOCK;
+            for (size_t i = from; i < std::min(ir.size(), from + BLOCK); i++)
+                padded[i - from] = ir[i] * scale;
+            size_t at = c * spectra + (size_t)p * BINS;
+            forward(padded.data(), &irRe[at], &irIm[at]);
+        }
+    }
+
+    fdlRe.assign(2 * spectra, 0.0f);
+    fdlIm.assign(2 * spectra, 0.0f);
+    current = 0;
+    std::memset(input, 0, sizeof(input));
+    std::memset(output, 0, sizeof(output));
+    fill = 0;
+
+    threadCount = std::max(1, std::min(maxThreads, partitionCount / MIN_PARTITIONS_PER_THREAD));
+    accRe.assign((size_t)threadCount * 2 * BINS, 0.0f);
+    accIm.assign((size_t)threadCount * 2 * BINS, 0.0f);
+    sliceUsed.assign(threadCount, 0);
+    sliceState.reset(new std::atomic<uint64_t>[threadCount]);
+    for (int s = 0; s < threadCount; s++)
+        sliceState[s].store(0, std::memory_order_relaxed);
+    generation = 1;
+    aheadJob.store(0, std::memory_order_relaxed);
+    startWorkers();
+}
+
+void Convolver::process(float* samples, int frames) {
+    for (int f = 0; f < frames; f++) {
+        for (int c = 0; c < 2; c++) {
+            float x = samples[f * 2 + c];
+            samples[f * 2 + c] = output[c][fill];
+            input[c][BLOCK + fill] = x;
+        }
+        if (++fill == BLOCK) {
+            processBlock();
+            fill = 0;
+        }
+    }
+}
+
+void Convolver::processBlock() {
+    bool wet = partitionCount > 0 && enabled.load(std::memory_order_relaxed);
+    size_t spectra = (size_t)partitionCount * BINS;
+
+    // ---- Input spectrum of [previous block | this block] into the ring ----
+    // kept up while bypassed, so switching back on has no stale history
+    for (int c = 0; c < 2; c++) {
+        if (partitionCount > 0) {
+            size_t at = c * spectra + (size_t)current * BINS;
+            forward(input[c], &fdlRe[at], &fdlIm[at]);
+        }
+        if (!wet)
+            std::copy(input[c] + BLOCK, input[c] + 2 * BLOCK, output[c]);
+        std::copy(input[c] + BLOCK, input[c] + 2 * BLOCK, input[c]);
+    }
+
+    if (wet) {
+        // ---- Multiply-add: partition 0 and the audio thread's share ----
+        std::fill_n(accRe.begin(), 2 * BINS, 0.0f);
+        std::fill_n(accIm.begin(), 2 * BINS, 0.0f);
+        int p0, p1;
+        sliceRange(0, p0, p1);
+        multiplyAdd(0, p1, current, 0, 0);
+
+        // ---- The helpers' shares, done during the last block ----
+        // Taking a share back is one exchange: a helper that has not started
+        // it skips it, one still on it finds its claim gone and its result is
+        // dropped. Either way it is computed here, into slot 0, at once.
+        for (int s = 1; s < threadCount; s++) {
+            uint64_t was = sliceState[s].exchange(generation << 2 | SLICE_TAKEN,
+                                                  std::memory_order_acquire);
+            sliceUsed[s] = was == (generation << 2 | SLICE_DONE);
+            if (!sliceUsed[s]) {
+                sliceRange(s, p0, p1);
+                multiplyAdd(p0, p1, current, 0, 0);
+            }
+        }
+
+        // ---- Sum the slices, inverse FFT; the second half is valid ----
+        for (int c = 0; c < 2; c++) {
+            float* re = &accRe[(size_t)c * BINS];
+            float* im = &accIm[(size_t)c * BINS];
+            for (int s = 1; s < threadCount; s++) {
+                if (!sliceUsed[s])
+                    continue;
+                const float* sr = &accRe[((size_t)s * 2 + c) * BINS];
+                const float* si = &accIm[((size_t)s * 2 + c) * BINS];
+                for (int k = 0; k < BINS; k++) {
+                    re[k] += sr[k];
+                    im[k] += si[k];
+                }
+            }
+            fftBuffer[0] = re[0];
+            for (int k = 1; k < BLOCK; k++) {
+                fftBuffer[2 * k - 1] = re[k];
+                fftBuffer[2 * k] = im[k];
+            }
+            fftBuffer[2 * BLOCK - 1] = re[BLOCK];
+            plan->fft.exec(fftBuffer.data(), 1.0f, false);
+            std::copy(fftBuffer.begin() + BLOCK, fftBuffer.end(), output[c]);
+        }
+    }
+
+    if (partitionCount > 0)
+        current = (current + 1) % partitionCount;
+    generation++;
+
+    // ---- Hand the next block's shares to the helpers ----
+    // Partitions 1.. of the next block only read spectra already in the
+    // ring. No waiting here: the mutex is only tried, and a helper that
+    // misses the wake finds the job on its next timed check.
+    if (wet && threadCount > 1) {
+        for (int s = 1; s < threadCount; s++)
+            sliceState[s].store(generation << 2 | SLICE_READY, std::memory_order_relaxed);
+        aheadJob.store(generation << 16 | (uint64_t)current, std::memory_order_release);
+        if (poolMutex.try_lock()) {
+            poolMutex.unlock();
+            poolCv.notify_all();
+        }
+    }
+}
+
+// Partitions of the slice: slice 0 takes partition 0 and the first share of
+// the rest, the helpers' slices split the remainder evenly
+void Convolver::sliceRange(int slice, int& p0, int& p1) const {
+    int rest = partitionCount - 1;
+    p0 = slice == 0 ? 0 : 1 + (int)((int64_t)slice * rest / threadCount);
+    p1 = 1 + (int)((int64_t)(slice + 1) * rest / threadCount);
+}
+
+// Partitions [p0, p1) of both channels, for the block whose input spectrum
+// is at ring position pos, added into accumulator slot. A helper passes its
+// job and gives up (false) as soon as a newer one is posted: by then its
+// result is no longer wanted, and the ring starts to move under it.
+bool Convolver::multiplyAdd(int p0, int p1, int pos, int slot, uint64_t job) {
+    size_t spectra = (size_t)partitionCount * BINS;
+
+    for (int c = 0; c < 2; c++) {
+        float* re = &accRe[((size_t)slot * 2 + c) * BINS];
+        float* im = &accIm[((size_t)slot * 2 + c) * BINS];
+        size_t irAt = (irChannels == 2 ? c : 0) * spectra;
+
+        for (int p = p0; p < p1; p++) {
+            if (job && aheadJob.load(std::memory_order_relaxed) != job)
+                return false;
+            // partition p meets the input spectrum from p blocks ago
+            int at = pos - p;
+            if (at < 0)
+                at += partitionCount;
+            const float* xr = &fdlRe[c * spectra + (size_t)at * BINS];
+            const float* xi = &fdlIm[c * spectra + (size_t)at * BINS];
+            const float* hr = &irRe[irAt + (size_t)p * BINS];
+            const float* hi = &irIm[irAt + (size_t)p * BINS];
+            for (int k = 0; k < BINS; k++) {
+                re[k] += xr[k] * hr[k] - xi[k] * hi[k];
+                im[k] += xr[k] * hi[k] + xi[k] * hr[k];
+            }
+        }
+    }
+    return true;
+}
+
+// ============================
+// Helper threads
+// ============================
+void Convolver::startWorkers() {
+    running = true;
+    for (int s = 1; s < threadCount; s++)
+        workers.emplace_back(&Convolver::workerFunc, this, s);
+}
+
+void Convolver::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        running = false;
+    }
+    poolCv.notify_all();
+    for (auto& w : workers)
+        if (w.joinable())
+            w.join();
+    workers.clear();
+}
+
+void Convolver::workerFunc(int slice) {
+    uint64_t seen = 0;
+    for (;;) {
+        uint64_t job;
+        {
+            // timed: the audio thread skips the wake when the mutex is busy
+            std::unique_lock<std::mutex> lock(poolMutex);
+            poolCv.wait_for(lock, std::chrono::milliseconds(1), [&] {
+                return !running || aheadJob.load(std::memory_order_acquire) != seen;
+            });
+            if (!running)
+                return;
+            job = aheadJob.load(std::memory_order_acquire);
+        }
+        if (job == seen)
+            continue;
+        seen = job;
+
+        // claim the share, unless the audio thread already took it back
+        uint64_t gen = job >> 16;
+        uint64_t expect = gen << 2 | SLICE_READY;
+        if (!sliceState[slice].compare_exchange_strong(expect, gen << 2 | SLICE_RUNNING,
+                                                       std::memory_order_acquire))
+            continue;
+
+        std::fill_n(&accRe[(size_t)slice * 2 * BINS], 2 * BINS, 0.0f);
+        std::fill_n(&accIm[(size_t)slice * 2 * BINS], 2 * BINS, 0.0f);
+        int p0, p1;
+        sliceRange(slice, p0, p1);
+        if (!multiplyAdd(p0, p1, (int)(job & 0xffff), slice, job))
+            continue;
+        expect = gen << 2 | SLICE_RUNNING;
+        sliceState[slice].compare_exchange_strong(expect, gen << 2 | SLICE_DONE,
+                                                  std::memory_order_release);
+    }
+}
+
+// ============================
+// Benchmark
+// ============================
+void convolver_benchmark(int seconds) {
+    using clock = std::chrono::steady_clock;
+    if (seconds <= 0)
+        seconds = 20;
+    const int rate = 44100, callback = 1024;
+    const double callbackMs = callback * 1000.0 / rate;
+
+    std::mt19937 rng(5);
+    std::normal_distribution<float> noise(0.0f, 0.1f);
+    std::vector<float> audio((size_t)rate * 2 * 2);   // 2 s, looped
+    for (float& v : audio)
+        v = noise(rng);
+
+    int cores = (int)std::max(1u, std::thread::hardware_concurrency());
+    std::printf("convolver: %d s of stereo audio in %d-frame callbacks, block %d, %d core(s)\n", seconds, callback,
+                Convolver::BLOCK, cores);
+    std::printf("  %8s %10s %8s %14s %12s %16s\n", "IR", "partitions", "threads", "ms per audio s", "% of a core",
+                "worst callback");
+
+    const double lengths[] = {0.1, 0.5, 1.0, 2.0, 4.0, 6.0};
+    for (double len : lengths) {
+        // decaying noise, like a room
+        std::vector<float> left((size_t)(len * rate)), right(left.size());
+        for (size_t i = 0; i < left.size(); i++) {
+            float env = std::exp(-6.0f * i / left.size());
+            left[i] = noise(rng) * env;
+            right[i] = noise(rng) * env;
+        }
+
+        std::vector<int> counts = {1};
+        if (cores > 1)
+            counts.push_back(std::min(cores, 4));
+        for (int threads : counts) {
+            Convolver conv(rate, threads);
+            conv.setImpulse(left, right);
+            if (threads > 1 && conv.threads() == 1)
+                continue;   // too short to split
+
+            std::vector<float> block((size_t)callback * 2);
+            size_t total = (size_t)seconds * rate, pos = 0;
+            double worst = 0;
+            auto t0 = clock::now();
+            for (size_t done = 0; done < total; done += callback) {
+                for (int i = 0; i < callback * 2; i++, pos++)
+                    block[i] = audio[pos % audio.size()];
+                auto c0 = clock::now();
+                conv.process(block.data(), callback);
+                worst = std::max(worst, std::chrono::duration<double, std::milli>(clock::now() - c0).count());
+            }
+            double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+            std::printf("  %7.1fs %10d %8d %14.2f %11.2f%% %9.2f / %.1f ms\n", len, conv.partitions(), conv.threads(),
+                        ms / seconds, ms / (seconds * 10.0), worst, callbackMs);
+        }
+    }
+}
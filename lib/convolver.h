@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// ============================
+// FIR convolver
+// ============================
+// Convolves the output with an impulse response (room correction, headphone
+// EQ) using uniformly partitioned overlap-save: the IR is cut into BLOCK
+// sized partitions whose spectra are multiplied with a delay line of input
+// spectra, so every block costs the same (one FFT pair plus a multiply-add
+// per partition) however long the IR is. Latency is a constant BLOCK frames.
+// A mono IR is applied to both channels, a stereo one per channel.
+//
+// Long IRs can spread the partitions over helper threads. Every partition
+// but the first only needs input that has already arrived, so the helpers
+// work one block ahead, while the current block plays; a share they have
+// not finished when the block is due is computed on the audio thread, which
+// never waits or blocks on them. This only pays off with spare cores and
+// hundreds of partitions.
+class Convolver {
+public:
+    static constexpr int BLOCK = 256;
+    static constexpr double MAX_IR_SECONDS = 6.0;
+
+    Convolver(int sampleRate, int maxThreads = 1);
+    ~Convolver();
+
+    // Before audio runs: reads a 16 / 24 / 32 bit or float WAV at the output
+    // sample rate, mono or stereo. Longer than MAX_IR_SECONDS is cut.
+    bool load(const std::string& wavPath);
+    // right empty: left is used for both channels
+    void setImpulse(const std::vector<float>& left, const std::vector<float>& right);
+
+    // audio thread: interleaved stereo, in place, BLOCK frames late
+    void process(float* samples, int frames);
+    int latencyFrames() const { return BLOCK; }
+    // silent frames after which nothing of the past input is left to play
+    int tailFrames() const { return BLOCK + partitionCount * BLOCK; }
+
+    // Off passes the input through with the same latency
+    void setEnabled(bool on) { enabled = on; }
+    bool isEnabled() const { return enabled; }
+
+    int partitions() const { return partitionCount; }
+    int threads() const { return threadCount; }
+    double irSeconds() const { return irFrames / (double)sampleRate; }
+    const std::string& irName() const { return name; }
+
+private:
+    static constexpr int BINS = BLOCK + 1;
+    static constexpr int MIN_PARTITIONS_PER_THREAD = 64;
+
+    struct Plan;
+
+    void processBlock();
+    void sliceRange(int slice, int& p0, int& p1) const;
+    bool multiplyAdd(int p0, int p1, int pos, int slot, uint64_t job);
+    void forward(const float* time, float* re, float* im);
+    void startWorkers();
+    void stopWorkers();
+    void workerFunc(int slice);
+
+    int sampleRate;
+    int maxThreads;
+    std::unique_ptr<Plan> plan;
+    std::string name;
+    size_t irFrames = 0;
+    int irChannels = 0;
+    int partitionCount = 0;
+    int threadCount = 1;
+
+    // IR spectra: [channel][partition][bin], scaled for the inverse FFT
+    std::vector<float> irRe, irIm;
+    // input spectra, a ring of partitionCount per channel
+    std::vector<float> fdlRe, fdlIm;
+    int current = 0;
+    // one accumulator per slice and channel; slot 0 is the audio thread's
+    std::vector<float> accRe, accIm;
+
+    float input[2][2 * BLOCK] = {};   // previous block, then the one filling
+    float output[2][BLOCK] = {};
+    int fill = 0;
+    std::vector<float> fftBuffer;
+
+    std::atomic<bool> enabled{true};
+
+    // helper threads, one slice each of partitions 1.. of the next block
+    enum : uint64_t { SLICE_READY = 0, SLICE_RUNNING = 1, SLICE_DONE = 2, SLICE_TAKEN = 3 };
+    std::vector<std::thread> workers;
+    std::mutex poolMutex;
+    std::condition_variable poolCv;
+    bool running = false;
+    uint64_t generation = 1;                          // audio thread: block number
+    std::atomic<uint64_t> aheadJob{0};                // generation << 16 | ring position
+    std::unique_ptr<std::atomic<uint64_t>[]> sliceState;   // generation << 2 | SLICE_*
+    std::vector<char> sliceUsed;                      // audio thread: helper result taken
+};
+
+// spotamp --bench-convolver [seconds]: CPU per second of audio against IR
+// length, single threaded and split
+void convolver_benchmark(int seconds);
@@ -0,0 +1,242 @@
+#include "dynamics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// ============================
+// Setup
+// ============================
+Dynamics::Dynamics(int sampleRate) {
+    ceiling = std::pow(10.0f, CEILING_DB / 20.0f);
+    releaseCoef = 1.0f - std::exp(-1000.0f / (RELEASE_MS * sampleRate));
+    compAttack = 1.0f - std::exp(-1000.0f / (COMP_ATTACK_MS * sampleRate));
+    compRelease = 1.0f - std::exp(-1000.0f / (COMP_RELEASE_MS * sampleRate));
+
+    // Phase p interpolates TP_DELAY - p / 4 frames before the newest sample:
+    // windowed sinc, band-limited a little under Nyquist, unity gain at DC.
+    // Phase 0 is the sample itself.
+    const double pi = 3.14159265358979323846;
+    const double cutoff = 0.9, halfWidth = TP_TAPS / 2 + 0.5;
+    for (int p = 0; p < TP_PHASES; p++) {
+        double sum = 0;
+        for (int k = 0; k < TP_TAPS; k++) {
+            double t = k - (TP_TAPS - 1 - TP_DELAY) - (double)p / TP_PHASES;
+            double sinc = t == 0.0 ? 1.0 : std::sin(pi * cutoff * t) / (pi * cutoff * t);
+            double w = 0.42 + 0.5 * std::cos(pi * t / halfWidth) + 0.08 * std::cos(2.0 * pi * t / halfWidth);
+            phases[p][k] = (float)(sinc * w);
+            sum += sinc * w;
+        }
+        for (int k = 0; k < TP_TAPS; k++)
+            phases[p][k] = p == 0 ? (k == TP_TAPS - 1 - TP_DELAY ? 1.0f : 0.0f) : (float)(phases[p][k] / sum);
+    }
+
+    std::fill(box, box + LOOKAHEAD, 1.0f);
+}
+
+// ============================
+// Processing
+// ============================
+void Dynamics::process(const float* in, int16_t* out, int frames) {
+    for (int done = 0; done < frames; done += CHUNK)
+        processChunk(in + done * 2, out + done * 2, std::min(CHUNK, frames - done));
+}
+
+float Dynamics::compressorGainDb(float levelDb) const {
+    float over = levelDb - COMP_THRESHOLD_DB;
+    float slope = 1.0f / COMP_RATIO - 1.0f;
+    if (2.0f * over <= -COMP_KNEE_DB)
+        return 0.0f;
+    if (2.0f * over >= COMP_KNEE_DB)
+        return slope * over;
+    float o = over + COMP_KNEE_DB / 2.0f;
+    return slope * o * o / (2.0f * COMP_KNEE_DB);
+}
+
+void Dynamics::processChunk(const float* in, int16_t* out, int frames) {
+    float* x[2] = {history[0] + TP_TAPS - 1, history[1] + TP_TAPS - 1};
+
+    // ---- Deinterleave, compress ----
+    float deepestComp = 0.0f;
+    if (compressorOn.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < frames; i++) {
+            float l = in[i * 2], r = in[i * 2 + 1];
+            float level = std::max(std::fabs(l), std::fabs(r));
+            float db = level > 1e-6f ? 20.0f * std::log10(level) : -120.0f;
+            compEnvDb += (db - compEnvDb) * (db > compEnvDb ? compAttack : compRelease);
+            float gr = compressorGainDb(compEnvDb);
+            float g = std::pow(10.0f, (gr + COMP_MAKEUP_DB) / 20.0f);
+            deepestComp = std::min(deepestComp, gr);
+            x[0][i] = l * g;
+            x[1][i] = r * g;
+        }
+    } else {
+        compEnvDb = -120.0f;
+        for (int i = 0; i < frames; i++) {
+            x[0][i] = in[i * 2];
+            x[1][i] = in[i * 2 + 1];
+        }
+    }
+
+    // ---- True peak, per frame over both channels ----
+    // Loops run over the whole chunk per tap, so the compiler vectorizes them
+    std::fill(peak, peak + frames, 0.0f);
+    for (int c = 0; c < 2; c++) {
+        for (int p = 0; p < TP_PHASES; p++) {
+            std::fill(acc, acc + frames, 0.0f);
+            for (int k = 0; k < TP_TAPS; k++) {
+                const float h = phases[p][k];
+                const float* src = history[c] + k;
+                for (int i = 0; i < frames; i++)
+                    acc[i] += h * src[i];
+            }
+            for (int i = 0; i < frames; i++)
+                peak[i] = std::max(peak[i], std::fabs(acc[i]));
+        }
+        std::memmove(history[c], history[c] + frames, (TP_TAPS - 1) * sizeof(float));
+    }
+
+    // ---- Limiter gain, applied to the delayed audio ----
+    // peak[i] describes the sample TP_DELAY frames back; the gain reaches its
+    // minimum LOOKAHEAD - 1 frames after it first sees the peak, just as that
+    // sample leaves the delay line
+    const int latency = latencyFrames();
+    float deepest = 1.0f;
+    for (int i = 0; i < frames; i++, now++) {
+        float want = peak[i] > ceiling ? ceiling / peak[i] : 1.0f;
+
+        // window of the last LOOKAHEAD frames: expire the oldest before the
+        // push, so a steadily rising gain (falling peaks) never holds more
+        // than LOOKAHEAD entries
+        if (minSize > 0 && now - minTime[minHead] >= (uint32_t)LOOKAHEAD) {
+            minHead = (minHead + 1) % LOOKAHEAD;
+            minSize--;
+        }
+        while (minSize > 0 && minValue[(minHead + minSize - 1) % LOOKAHEAD] >= want)
+            minSize--;
+        int slot = (minHead + minSize) % LOOKAHEAD;
+        minValue[slot] = want;
+        minTime[slot] = now;
+        minSize++;
+        float held = minValue[minHead];
+
+        released = held < released ? held : released + (held - released) * releaseCoef;
+        boxSum += released - box[boxPos];
+        box[boxPos] = released;
+        boxPos = boxPos + 1 == LOOKAHEAD ? 0 : boxPos + 1;
+        float g = std::min(1.0f, boxSum * (1.0f / LOOKAHEAD));
+        deepest = std::min(deepest, g);
+
+        delay[0][delayPos] = x[0][i];
+        delay[1][delayPos] = x[1][i];
+        int from = (delayPos - latency) & (DELAY_RING - 1);
+        delayPos = (delayPos + 1) & (DELAY_RING - 1);
+        for (int c = 0; c < 2; c++) {
+            float v = delay[c][from] * g * 32768.0f;
+            out[i * 2 + c] = (int16_t)std::max(-32768.0f, std::min(32767.0f, std::nearbyint(v)));
+        }
+    }
+
+    // the running sum drifts in float; resum once per chunk
+    boxSum = 0.0f;
+    for (float b : box)
+        boxSum += b;
+
+    limiterReduction.store(20.0f * std::log10(deepest), std::memory_order_relaxed);
+    compressorReduction.store(deepestComp, std::memory_order_relaxed);
+}
+
+// ============================
+// Check
+// ============================
+// Runs one signal through a fresh limiter in uneven callbacks; returns the
+// output's highest sample and (if asked) its 16x interpolated true peak
+static void check_signal(const std::vector<float>& in, std::mt19937& rng, int& samplePeak, double* truePeak) {
+    Dynamics d(44100);
+    std::vector<int16_t> out(in.size());
+    size_t frames = in.size() / 2;
+    std::uniform_int_distribution<int> blocks(1, 1500);
+    for (size_t f = 0; f < frames;) {
+        int n = (int)std::min<size_t>(blocks(rng), frames - f);
+        d.process(in.data() + f * 2, out.data() + f * 2, n);
+        f += n;
+    }
+
+    samplePeak = 0;
+    for (int16_t v : out)
+        samplePeak = std::max(samplePeak, std::abs((int)v));
+    if (!truePeak)
+        return;
+    const double pi = 3.14159265358979323846;
+    *truePeak = 0;
+    for (size_t f = 32; f + 32 < frames; f++) {
+        for (int c = 0; c < 2; c++) {
+            for (int s = 1; s < 16; s++) {
+                double t = s / 16.0, sum = 0;
+                for (int k = -31; k <= 32; k++) {
+                    double a = k - t;
+                    sum += out[(f + k) * 2 + c] * std::sin(pi * a) / (pi * a) * (0.5 + 0.5 * std::cos(pi * a / 33.0));
+                }
+                *truePeak = std::max(*truePeak, std::fabs(sum));
+            }
+        }
+    }
+}
+
+int dynamics_check(int signals) {
+    const int rate = 44100;
+    const double pi = 3.14159265358979323846;
+    const int limit = (int)std::ceil(std::pow(10.0, Dynamics::CEILING_DB / 20.0) * 32768.0) + 1;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+    int failures = 0, worst = 0;
+
+    // hot bass with level jumps: the wanted gain rises for long stretches
+    for (int n = 0; n < signals; n++) {
+        std::vector<float> in((size_t)rate * 2);
+        float f1 = 30.0f + 90.0f * uni(rng), f2 = 2.0f * f1 + 40.0f * uni(rng);
+        float level = 1.0f;
+        for (int i = 0; i < rate; i++) {
+            if (i % 4410 == 0)
+                level = 0.3f + 3.7f * uni(rng);   // up to +12 dB over full scale
+            float v = level * (0.8f * std::sin(2.0f * (float)pi * f1 * i / rate) +
+                               0.3f * std::sin(2.0f * (float)pi * f2 * i / rate));
+            in[i * 2] = v;
+            in[i * 2 + 1] = v * (0.7f + 0.3f * uni(rng));
+        }
+        int peak;
+        check_signal(in, rng, peak, nullptr);
+        worst = std::max(worst, peak);
+        if (peak > limit) {
+            failures++;
+            std::printf("  signal %d: sample peak %.2f dBFS\n", n, 20.0 * std::log10(peak / 32768.0));
+        }
+    }
+    std::printf("limiter: %d bass signals, highest sample %.2f dBFS\n", signals, 20.0 * std::log10(worst / 32768.0));
+
+    // a falling ramp (each frame wants more gain than the last) into a spike
+    {
+        std::vector<float> in((size_t)rate * 2);
+        for (int i = 0; i < rate; i++) {
+            float level = i < rate / 2 ? 4.0f - 3.5f * i / (rate / 2) : 0.5f;
+            float v = level * std::sin(2.0f * (float)pi * 60.0f * i / rate);
+            in[i * 2] = in[i * 2 + 1] = v;
+        }
+        in[(rate / 2 + 100) * 2] = in[(rate / 2 + 100) * 2 + 1] = 3.0f;
+        int peak;
+        double truePeak;
+        check_signal(in, rng, peak, &truePeak);
+        double tpDb = 20.0 * std::log10(truePeak / 32768.0);
+        std::printf("limiter: ramp + spike, sample peak %.2f dBFS, true peak %.2f dBTP\n",
+                    20.0 * std::log10(peak / 32768.0), tpDb);
+        // the 4x detector may miss a little between its points
+        if (peak > limit || tpDb > Dynamics::CEILING_DB + 0.3)
+            failures++;
+    }
+
+    std::printf("limiter: %d failure(s)\n", failures);
+    return failures;
+}
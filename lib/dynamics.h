@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// ============================
+// Output dynamics
+// ============================
+// Last stage before the device: an optional compressor, then a look-ahead
+// brickwall limiter that keeps true peaks (4x oversampled) under CEILING_DB,
+// then s16. The limiter sees each peak LOOKAHEAD frames early and fades the
+// gain down over that window, so nothing clips and nothing clicks; it costs
+// a constant latencyFrames() of delay. Everything it needs is allocated in
+// the constructor, so process() is safe on the audio thread.
+class Dynamics {
+public:
+    static constexpr float CEILING_DB = -1.0f;   // true peak (dBTP)
+
+    explicit Dynamics(int sampleRate);
+
+    // audio thread: in is interleaved stereo, full scale 1.0 (may exceed it);
+    // out receives what went in latencyFrames() earlier
+    void process(const float* in, int16_t* out, int frames);
+    // frames between a sample going in and coming out; constant
+    int latencyFrames() const { return LOOKAHEAD - 1 + TP_DELAY; }
+
+    void setCompressor(bool on) { compressorOn = on; }
+    bool compressorEnabled() const { return compressorOn; }
+
+    // UI thread: gain reduction in the last block, dB (0 = untouched)
+    float limiterDb() const { return limiterReduction.load(std::memory_order_relaxed); }
+    float compressorDb() const { return compressorReduction.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int CHUNK = 256;         // frames per inner pass
+    static constexpr int LOOKAHEAD = 64;      // ~1.5 ms at 44.1 kHz
+    static constexpr int TP_PHASES = 4;       // true peak: 4x oversampling
+    static constexpr int TP_TAPS = 12;        // per phase
+    static constexpr int TP_DELAY = TP_TAPS / 2;
+    static constexpr int DELAY_RING = 128;    // power of two > latency
+    static constexpr float RELEASE_MS = 100.0f;
+
+    // gentle levelling for noisy rooms; peaks are left to the limiter
+    static constexpr float COMP_THRESHOLD_DB = -16.0f;
+    static constexpr float COMP_RATIO = 2.5f;
+    static constexpr float COMP_KNEE_DB = 6.0f;
+    static constexpr float COMP_MAKEUP_DB = 3.0f;
+    static constexpr float COMP_ATTACK_MS = 5.0f;
+    static constexpr float COMP_RELEASE_MS = 150.0f;
+
+    void processChunk(const float* in, int16_t* out, int frames);
+    float compressorGainDb(float levelDb) const;
+
+    float ceiling;
+    float releaseCoef;
+    float compAttack, compRelease;
+
+    // true-peak interpolator: one fractional-delay FIR per phase
+    float phases[TP_PHASES][TP_TAPS];
+    // per channel: the last TP_TAPS - 1 inputs, then the chunk
+    float history[2][TP_TAPS - 1 + CHUNK] = {};
+    float acc[CHUNK];
+    float peak[CHUNK];
+
+    float delay[2][DELAY_RING] = {};
+    int delayPos = 0;
+
+    // sliding minimum of the wanted gain over LOOKAHEAD frames
+    float minValue[LOOKAHEAD];
+    uint32_t minTime[LOOKAHEAD];
+    int minHead = 0, minSize = 0;
+    uint32_t now = 0;
+    // release, then a LOOKAHEAD box filter as the attack ramp
+    float released = 1.0f;
+    float box[LOOKAHEAD];
+    int boxPos = 0;
+    float boxSum = LOOKAHEAD;
+
+    float compEnvDb = -120.0f;
+
+    std::atomic<bool> compressorOn{false};
+    std::atomic<float> limiterReduction{0.0f};
+    std::atomic<float> compressorReduction{0.0f};
+};
+
+// spotamp --check-limiter [n]: n random bass-heavy signals with level jumps,
+// plus a falling ramp into a spike, through the limiter against the ceiling;
+// returns the number of failures
+int dynamics_check(int signals);
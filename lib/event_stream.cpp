@@ -0,0 +1,657 @@
+#include "event_stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <openssl/evp.h>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    typedef SOCKET socket_t;
+    #define CLOSE_SOCKET closesocket
+    #define SHUT_RDWR SD_BOTH
+    #define SEND_FLAGS 0
+#else
+    #include <sys/socket.h>
+    #include <sys/time.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <netdb.h>
+    #include <unistd.h>
+    typedef int socket_t;
+    #define CLOSE_SOCKET close
+    // a peer that went away must fail the send, not raise SIGPIPE
+    #ifdef MSG_NOSIGNAL
+        #define SEND_FLAGS MSG_NOSIGNAL
+    #else
+        #define SEND_FLAGS 0   // macOS: SO_NOSIGPIPE is set on the socket instead
+    #endif
+#endif
+
+static constexpr int OP_CONT  = 0x0;
+static constexpr int OP_TEXT  = 0x1;
+static constexpr int OP_CLOSE = 0x8;
+static constexpr int OP_PING  = 0x9;
+static constexpr int OP_PONG  = 0xA;
+
+static constexpr int IDLE_PING_S = 15;        // recv timeout; ping when idle this long
+static constexpr size_t MAX_MESSAGE = 1 << 20; // events are small, refuse anything huge
+
+static std::string base64(const unsigned char* data, size_t n) {
+    static const char* tbl = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < n; i += 3) {
+        uint32_t v = data[i] << 16;
+        if (i + 1 < n) v |= data[i + 1] << 8;
+        if (i + 2 < n) v |= data[i + 2];
+        out += tbl[(v >> 18) & 63];
+        out += tbl[(v >> 12) & 63];
+        out += i + 1 < n ? tbl[(v >> 6) & 63] : '=';
+        out += i + 2 < n ? tbl[v & 63] : '=';
+    }
+    return out;
+}
+
+EventStream::EventStream(const std::string& host_, int port_, const std::string& path_)
+    : host(host_),
+      port(port_),
+      path(path_)
+{
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+}
+
+EventStream::~EventStream() {
+    stop();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void EventStream::start(Handler onMessage) {
+    handler = std::move(onMessage);
+    running = true;
+    thread = std::thread(&EventStream::threadFunc, this);
+}
+
+void EventStream::stop() {
+    running = false;
+    {
+        // unblocks a recv() in progress
+        std::lock_guard<std::mutex> lock(sockMutex);
+        if (sock != -1)
+            shutdown((socket_t)sock, SHUT_RDWR);
+    }
+    if (thread.joinable())
+        thread.join();
+}
+
+bool EventStream::openSocket() {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0)
+        return false;
+
+    socket_t s = (socket_t)-1;
+    for (addrinfo* ai = res; ai; ai = ai->ai_next) {
+        s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (s == (socket_t)-1)
+            continue;
+        if (connect(s, ai->ai_addr, (int)ai->ai_addrlen) == 0)
+            break;
+        CLOSE_SOCKET(s);
+        s = (socket_t)-1;
+    }
+    freeaddrinfo(res);
+    if (s == (socket_t)-1)
+        return false;
+
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+    setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&one, sizeof(one));
+#endif
+#ifdef _WIN32
+    DWORD tv = IDLE_PING_S * 1000;
+#else
+    timeval tv{IDLE_PING_S, 0};
+#endif
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
+
+    std::lock_guard<std::mutex> lock(sockMutex);
+    sock = (intptr_t)s;
+    pending.clear();
+    pendingPos = 0;
+    return true;
+}
+
+void EventStream::closeSocket() {
+    std::lock_guard<std::mutex> lock(sockMutex);
+    if (sock != -1) {
+        CLOSE_SOCKET((socket_t)sock);
+        sock = -1;
+    }
+}
+
+bool EventStream::sendAll(const void* data, size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        int sent = send((socket_t)sock, p, (int)n, SEND_FLAGS);
+        if (sent <= 0)
+            return false;
+        p += sent;
+        n -= sent;
+    }
+    return true;
+}
+
+// Reads n bytes, first from what was buffered during the handshake.
+// A receive timeout on an idle stream sends a ping and keeps waiting.
+bool EventStream::readExact(void* dst, size_t n) {
+    char* out = static_cast<char*>(dst);
+    while (n > 0) {
+        if (pendingPos < pending.size()) {
+            size_t take = std::min(n, pending.size() - pendingPos);
+            std::memcpy(out, pending.data() + pendingPos, take);
+            pendingPos += take;
+            out += take;
+            n -= take;
+            continue;
+        }
+
+        char buf[4096];
+        int got = recv((socket_t)sock, buf, sizeof(buf), 0);
+        if (got > 0) {
+            pending.assign(buf, got);
+            pendingPos = 0;
+            continue;
+        }
+#ifdef _WIN32
+        bool timeout = got < 0 && WSAGetLastError() == WSAETIMEDOUT;
+#else
+        bool timeout = got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#endif
+        if (!timeout || !running || !sendFrame(OP_PING, ""))
+            return false;
+    }
+    return true;
+}
+
+// Client frames must be masked (RFC 6455 5.3)
+bool EventStream::sendFrame(int opcode, const std::string& payload) {
+    static thread_local std::mt19937 rng{std::random_device{}()};
+
+    std::string frame;
+    frame += (char)(0x80 | opcode);
+    size_t n = payload.size();
+    if (n < 126) {
+        frame += (char)(0x80 | n);
+    } else if (n < 65536) {
+        frame += (char)(0x80 | 126);
+        frame += (char)(n >> 8);
+        frame += (char)(n & 0xFF);
+    } else {
+        frame += (char)(0x80 | 127);
+        for (int i = 7; i >= 0; i--)
+            frame += (char)((uint64_t)n >> (i * 8));
+    }
+
+    uint32_t key = rng();
+    unsigned char mask[4] = {(unsigned char)(key >> 24), (unsigned char)(key >> 16),
+                             (unsigned char)(key >> 8), (unsigned char)key};
+    frame.append((const char*)mask, 4);
+    for (size_t i = 0; i < n; i++)
+        frame += (char)(payload[i] ^ mask[i & 3]);
+
+    return sendAll(frame.data(), frame.size());
+}
+
+bool EventStream::handshake() {
+    std::random_device rd;
+    unsigned char nonce[16];
+    for (auto& b : nonce)
+        b = (unsigned char)rd();
+    std::string key = base64(nonce, sizeof(nonce));
+
+    std::string req =
+        "GET " + path + " HTTP/1.1\r\n"
+        "Host: " + host + ":" + std::to_string(port) + "\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Key: " + key + "\r\n"
+        "Sec-WebSocket-Version: 13\r\n\r\n";
+    if (!sendAll(req.data(), req.size()))
+        return false;
+
+    // read the response head; anything after it already belongs to frames
+    std::string head;
+    size_t end;
+    while ((end = head.find("\r\n\r\n")) == std::string::npos) {
+        char buf[1024];
+        int got = recv((socket_t)sock, buf, sizeof(buf), 0);
+        if (got <= 0 || head.size() > 16384)
+            return false;
+        head.append(buf, got);
+    }
+    pending = head.substr(end + 4);
+    pendingPos = 0;
+    head.resize(end + 2);
+
+    if (head.compare(0, 12, "HTTP/1.1 101") != 0)
+        return false;
+
+    // Sec-WebSocket-Accept = base64(SHA1(key + GUID))
+    std::string src = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    EVP_Digest(src.data(), src.size(), digest, &len, EVP_sha1(), nullptr);
+    std::string accept = base64(digest, len);
+
+    std::string lower = head;
+    for (char& c : lower) c = (char)std::tolower((unsigned char)c);
+    size_t at = lower.find("sec-websocket-accept:");
+    if (at == std::string::npos)
+        return false;
+    at += 21;
+    while (at < head.size() && head[at] == ' ') at++;
+    return head.compare(at, accept.size(), accept) == 0;
+}
+
+// Returns when the connection is lost or closed
+bool EventStream::readLoop() {
+    std::string message;
+    int messageOp = 0;
+
+    while (running) {
+        unsigned char hdr[2];
+        if (!readExact(hdr, 2))
+            return false;
+
+        bool fin = hdr[0] & 0x80;
+        int opcode = hdr[0] & 0x0F;
+        bool masked = hdr[1] & 0x80;
+        uint64_t len = hdr[1] & 0x7F;
+
+        if (len == 126) {
+            unsigned char ext[2];
+            if (!readExact(ext, 2)) return false;
+            len = (ext[0] << 8) | ext[1];
+        } else if (len == 127) {
+            unsigned char ext[8];
+            if (!readExact(ext, 8)) return false;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = (len << 8) | ext[i];
+        }
+        if (len > MAX_MESSAGE || message.size() + len > MAX_MESSAGE)
+            return false;
+
+        unsigned char mask[4] = {0, 0, 0, 0};
+        if (masked && !readExact(mask, 4))
+            return false;
+
+        std::string payload(len, '\0');
+        if (len > 0 && !readExact(&payload[0], len))
+            return false;
+        if (masked)
+            for (size_t i = 0; i < len; i++)
+                payload[i] ^= mask[i & 3];
+
+        switch (opcode) {
+            case OP_PING:
+                if (!sendFrame(OP_PONG, payload)) return false;
+                break;
+            case OP_PONG:
+                break;
+            case OP_CLOSE:
+                sendFrame(OP_CLOSE, "");
+                return true;
+            case OP_TEXT:
+            case OP_CONT:
+                if (opcode == OP_TEXT) {
+                    message.clear();
+                    messageOp = OP_TEXT;
+                }
+                message += payload;
+                if (fin && messageOp == OP_TEXT) {
+                    messages++;
+                    if (handler) handler(message);
+                    message.clear();
+                    messageOp = 0;
+                }
+                break;
+            default:
+                break; // binary frames are not used by go-librespot
+        }
+    }
+    return true;
+}
+
+void EventStream::threadFunc() {
+    int backoffMs = 250;
+    while (running) {
+        if (openSocket()) {
+            if (handshake()) {
+                connected = true;
+                backoffMs = 250;
+                std::cout << "[events] connected to ws://" << host << ":" << port << path << std::endl;
+                readLoop();
+                connected = false;
+                if (running)
+                    std::cout << "[events] disconnected" << std::endl;
+            }
+            closeSocket();
+        }
+
+        // back off before reconnecting, staying responsive to stop()
+        for (int waited = 0; running && waited < backoffMs; waited += 50)
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        backoffMs = std::min(backoffMs * 2, 8000);
+    }
+}
+
+// ============================
+// Stand-in go-librespot
+// ============================
+// Enough of go-librespot's API on one port to run SpotAmp without it. A
+// list of FAKE_TRACK_MS long tracks plays on a clock. /events streams
+// metadata / playing / paused / seek / volume events, every fourth
+// metadata split into fragments with a ping between them. GET /status and
+// /player/volume describe the same state; next, prev, playpause, play and
+// volume move it, any other request answers {}. Covers point at
+// --fake-covers, every fifth one broken.
+namespace {
+constexpr int FAKE_TRACK_MS = 45000;
+
+struct FakePlayer {
+    std::mutex mutex;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int64_t pausedAt = -1;   // ms into the list while paused, -1 playing
+    int volume = 60;
+    uint64_t changes = 0;    // bumped by transport commands
+    int coverPort = 3679;
+
+    // under the mutex
+    int64_t elapsedMs() const {
+        if (pausedAt >= 0)
+            return pausedAt;
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+    void jumpTo(int64_t ms) {
+        ms = std::max<int64_t>(0, ms);
+        if (pausedAt >= 0)
+            pausedAt = ms;
+        else
+            start = std::chrono::steady_clock::now() - std::chrono::milliseconds(ms);
+        changes++;
+    }
+};
+
+FakePlayer fake;
+
+std::string fake_track_json(int64_t elapsed, int coverPort) {
+    int n = (int)(elapsed / FAKE_TRACK_MS);
+    char cover[96];
+    if (n % 5 == 4)
+        std::snprintf(cover, sizeof(cover), "http://127.0.0.1:%d/broken.jpg", coverPort);
+    else
+        std::snprintf(cover, sizeof(cover), "http://127.0.0.1:%d/cover/%d.jpg", coverPort, n);
+    char json[512];
+    std::snprintf(json, sizeof(json),
+        "{\"uri\":\"spotify:track:SpotAmpFake%011d\",\"name\":\"Stand-in track %d\","
+        "\"artist_names\":[\"SpotAmp\",\"Nobody\"],\"album_name\":\"Stand-in album %d\","
+        "\"album_cover_url\":\"%s\",\"position\":%d,\"duration\":%d}",
+        n, n, n / 3, cover, (int)(elapsed % FAKE_TRACK_MS), FAKE_TRACK_MS);
+    return json;
+}
+
+bool fake_send(socket_t c, const std::string& data) {
+    const char* p = data.data();
+    size_t n = data.size();
+    while (n > 0) {
+        int sent = send(c, p, (int)n, SEND_FLAGS);
+        if (sent <= 0)
+            return false;
+        p += sent;
+        n -= sent;
+    }
+    return true;
+}
+
+// server frames are not masked
+std::string fake_frame(int opcode, const std::string& payload, bool fin = true) {
+    std::string frame;
+    frame += (char)((fin ? 0x80 : 0) | opcode);
+    size_t n = payload.size();
+    if (n < 126) {
+        frame += (char)n;
+    } else {
+        frame += (char)126;
+        frame += (char)(n >> 8);
+        frame += (char)(n & 0xFF);
+    }
+    return frame + payload;
+}
+
+std::string fake_header(const std::string& head, const char* name) {
+    std::string lower = head;
+    for (char& c : lower) c = (char)std::tolower((unsigned char)c);
+    size_t at = lower.find(std::string("\r\n") + name + ":");
+    if (at == std::string::npos)
+        return std::string();
+    at += std::strlen(name) + 3;
+    size_t end = head.find("\r\n", at);
+    while (at < end && head[at] == ' ') at++;
+    return head.substr(at, end - at);
+}
+
+// Upgrades the connection and streams state changes until the client goes
+void fake_events(socket_t c, const std::string& key) {
+    std::string src = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    EVP_Digest(src.data(), src.size(), digest, &len, EVP_sha1(), nullptr);
+    if (!fake_send(c, "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                      "Sec-WebSocket-Accept: " + base64(digest, len) + "\r\n\r\n"))
+        return;
+    std::cout << "[fake] event stream connected" << std::endl;
+
+    int shownTrack = -1, shownVolume = -1;
+    uint64_t shownChanges = 0;
+    bool shownPaused = false;
+    for (int tick = 0;; tick++) {
+        int64_t elapsed;
+        bool paused;
+        int volume, coverPort;
+        uint64_t changes;
+        {
+            std::lock_guard<std::mutex> lock(fake.mutex);
+            elapsed = fake.elapsedMs();
+            paused = fake.pausedAt >= 0;
+            volume = fake.volume;
+            changes = fake.changes;
+            coverPort = fake.coverPort;
+        }
+        int track = (int)(elapsed / FAKE_TRACK_MS);
+        char small[128];
+        std::string out;
+
+        if (track != shownTrack) {
+            std::string meta = "{\"type\":\"metadata\",\"data\":" + fake_track_json(elapsed, coverPort) + "}";
+            if (track % 4 == 3) {
+                size_t half = meta.size() / 2;
+                out += fake_frame(OP_TEXT, meta.substr(0, half), false);
+                out += fake_frame(OP_PING, "fake");
+                out += fake_frame(OP_CONT, meta.substr(half));
+            } else {
+                out += fake_frame(OP_TEXT, meta);
+            }
+            std::cout << "[fake] track " << track << std::endl;
+        }
+        if (track != shownTrack || paused != shownPaused || changes != shownChanges) {
+            out += fake_frame(OP_TEXT, paused ? "{\"type\":\"paused\"}" : "{\"type\":\"playing\"}");
+            std::snprintf(small, sizeof(small), "{\"type\":\"seek\",\"data\":{\"position\":%d,\"duration\":%d}}",
+                          (int)(elapsed % FAKE_TRACK_MS), FAKE_TRACK_MS);
+            out += fake_frame(OP_TEXT, small);
+        }
+        if (volume != shownVolume) {
+            std::snprintf(small, sizeof(small), "{\"type\":\"volume\",\"data\":{\"value\":%d,\"max\":100}}", volume);
+            out += fake_frame(OP_TEXT, small);
+        }
+        // a ping now and then notices a client that is gone
+        if (out.empty() && tick % 50 == 49)
+            out = fake_frame(OP_PING, "");
+
+        if (!out.empty() && !fake_send(c, out)) {
+            std::cout << "[fake] event stream closed" << std::endl;
+            return;
+        }
+        shownTrack = track;
+        shownPaused = paused;
+        shownChanges = changes;
+        shownVolume = volume;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+std::string fake_reply(const std::string& method, const std::string& target, const std::string& body) {
+    std::lock_guard<std::mutex> lock(fake.mutex);
+    int64_t elapsed = fake.elapsedMs();
+    char json[768];
+
+    if (method == "GET" && target == "/status") {
+        std::snprintf(json, sizeof(json),
+            "{\"paused\":%s,\"stopped\":false,\"volume\":%d,\"volume_steps\":100,"
+            "\"shuffle_context\":false,\"track\":%s}",
+            fake.pausedAt >= 0 ? "true" : "false", fake.volume,
+            fake_track_json(elapsed, fake.coverPort).c_str());
+        return json;
+    }
+    if (method == "GET" && target == "/player/volume") {
+        std::snprintf(json, sizeof(json), "{\"value\":%d,\"max\":100}", fake.volume);
+        return json;
+    }
+    if (method != "POST")
+        return "{}";
+
+    int64_t trackStart = elapsed - elapsed % FAKE_TRACK_MS;
+    if (target == "/player/next" || target == "/player/play") {
+        fake.jumpTo(trackStart + FAKE_TRACK_MS);
+    } else if (target == "/player/prev") {
+        fake.jumpTo(elapsed - trackStart > 3000 ? trackStart : trackStart - FAKE_TRACK_MS);
+    } else if (target == "/player/playpause") {
+        if (fake.pausedAt >= 0) {
+            fake.start = std::chrono::steady_clock::now() - std::chrono::milliseconds(fake.pausedAt);
+            fake.pausedAt = -1;
+        } else {
+            fake.pausedAt = elapsed;
+        }
+        fake.changes++;
+    } else if (target == "/player/seek") {
+        size_t at = body.find("\"position\":");
+        if (at != std::string::npos)
+            fake.jumpTo(trackStart + std::atoi(body.c_str() + at + 11));
+    } else if (target == "/player/volume") {
+        size_t at = body.find("\"volume\":");
+        if (at != std::string::npos)
+            fake.volume = std::max(0, std::min(100, std::atoi(body.c_str() + at + 9)));
+    }
+    return "{}";
+}
+
+// Keep-alive HTTP until the peer closes, or an event stream
+void fake_serve(socket_t c) {
+    std::string in;
+    for (;;) {
+        size_t end;
+        while ((end = in.find("\r\n\r\n")) == std::string::npos) {
+            char buf[4096];
+            int got = recv(c, buf, sizeof(buf), 0);
+            if (got <= 0 || in.size() > 65536) {
+                CLOSE_SOCKET(c);
+                return;
+            }
+            in.append(buf, got);
+        }
+        std::string head = in.substr(0, end + 2);
+        in.erase(0, end + 4);
+        size_t length = (size_t)std::atoi(fake_header(head, "content-length").c_str());
+        while (in.size() < length) {
+            char buf[4096];
+            int got = recv(c, buf, sizeof(buf), 0);
+            if (got <= 0) {
+                CLOSE_SOCKET(c);
+                return;
+            }
+            in.append(buf, got);
+        }
+        std::string body = in.substr(0, length);
+        in.erase(0, length);
+
+        size_t sp1 = head.find(' '), sp2 = head.find(' ', sp1 + 1);
+        if (sp1 == std::string::npos || sp2 == std::string::npos)
+            break;
+        std::string method = head.substr(0, sp1);
+        std::string target = head.substr(sp1 + 1, sp2 - sp1 - 1);
+
+        std::string key = fake_header(head, "sec-websocket-key");
+        if (target == "/events" && !key.empty()) {
+            fake_events(c, key);
+            break;
+        }
+        std::string reply = fake_reply(method, target, body);
+        if (method == "POST")
+            std::cout << "[fake] " << target << std::endl;
+        if (!fake_send(c, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                          std::to_string(reply.size()) + "\r\n\r\n" + reply))
+            break;
+    }
+    CLOSE_SOCKET(c);
+}
+}
+
+int event_stream_fake_server(int port, int coverPort) {
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+    fake.coverPort = coverPort;
+
+    socket_t listener = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (listener == (socket_t)-1 || bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 16) != 0) {
+        std::cout << "[fake] could not listen on port " << port << std::endl;
+        return 1;
+    }
+    std::cout << "[fake] stand-in go-librespot on 127.0.0.1:" << port
+              << ", covers from 127.0.0.1:" << coverPort << " (spotamp --fake-covers)" << std::endl;
+
+    for (;;) {
+        socket_t c = accept(listener, nullptr, nullptr);
+        if (c == (socket_t)-1)
+            continue;
+        setsockopt(c, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+        setsockopt(c, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&one, sizeof(one));
+#endif
+        std::thread(fake_serve, c).detach();
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+// ============================
+// go-librespot event stream
+// ============================
+// Minimal WebSocket (RFC 6455) client for go-librespot's /events endpoint.
+// Runs on its own thread, reconnects with backoff and delivers every text
+// message (one JSON event) to the handler on that thread.
+class EventStream {
+public:
+    using Handler = std::function<void(const std::string& message)>;
+
+    EventStream(const std::string& host, int port, const std::string& path = "/events");
+    ~EventStream();
+
+    void start(Handler onMessage);
+    void stop();
+
+    bool isConnected() const { return connected; }
+    uint64_t getMessageCount() const { return messages; }
+
+private:
+    void threadFunc();
+    bool openSocket();
+    void closeSocket();
+    bool handshake();
+    bool readLoop();
+    bool readExact(void* dst, size_t n);
+    bool sendFrame(int opcode, const std::string& payload);
+    bool sendAll(const void* data, size_t n);
+
+    std::string host;
+    int port;
+    std::string path;
+    Handler handler;
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> connected{false};
+    std::atomic<uint64_t> messages{0};
+
+    std::mutex sockMutex;
+    intptr_t sock = -1;
+
+    // bytes received past the handshake / current read position
+    std::string pending;
+    size_t pendingPos = 0;
+};
+
+// spotamp --fake-events [port] [cover port]: a stand-in go-librespot on
+// 127.0.0.1 (default 3678, where SpotAmp looks for it) with a scripted
+// event stream and /status; covers come from spotamp --fake-covers.
+// Runs until killed.
+int event_stream_fake_server(int port, int coverPort);
@@ -0,0 +1,122 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+
+FramePacer::FramePacer()
+    : interval(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / 60))),
+      deadline(Clock::now()),
+      histogram(BUCKETS, 0.0f)
+{
+}
+
+void FramePacer::configure(int refreshHz_, bool tearControl_) {
+    refreshHz = refreshHz_ > 0 ? refreshHz_ : 60;
+    tearControl = tearControl_;
+}
+
+const char* FramePacer::modeName(int mode) {
+    switch (mode) {
+        case MODE_VSYNC:    return "vsync";
+        case MODE_TIMER:    return "timer";
+        case MODE_ADAPTIVE: return "adaptive";
+        default:            return "?";
+    }
+}
+
+void FramePacer::setMode(Mode m) {
+    mode = m;
+    resetStats();
+}
+
+void FramePacer::setTargetFps(int fps) {
+    fps = std::max(fps, 1);
+    if (fps == targetFps)
+        return;
+    targetFps = fps;
+    interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+}
+
+// Below the refresh rate only a timer can pace (vsync would run at full rate)
+bool FramePacer::timerPaced() const {
+    return mode == MODE_TIMER || targetFps < refreshHz;
+}
+
+int FramePacer::swapInterval() const {
+    switch (mode) {
+        case MODE_TIMER:    return 0;
+        case MODE_ADAPTIVE: return targetFps < refreshHz ? 0 : (tearControl ? -1 : 1);
+        default:            return 1;
+    }
+}
+
+bool FramePacer::swapIntervalChanged() {
+    int i = swapInterval();
+    if (i == appliedInterval)
+        return false;
+    appliedInterval = i;
+    return true;
+}
+
+FramePacer::Clock::time_point FramePacer::nextFrameTime() const {
+    if (!haveLastFrame)
+        return lastFrame;
+    if (timerPaced())
+        return deadline;
+    // the swap already blocks until vblank, so the timer must never be the
+    // reason a vblank is missed: allow starting a bit early
+    return lastFrame + interval / 2;
+}
+
+void FramePacer::frameStarted(Clock::time_point now) {
+    if (haveLastFrame) {
+        double ms = std::chrono::duration<double, std::milli>(now - lastFrame).count();
+        if (ms < IDLE_GAP_MS) {
+            int b = std::min((int)(ms / BUCKET_MS), BUCKETS - 1);
+            histogram[b] += 1.0f;
+            frames++;
+            maxMs = std::max(maxMs, ms);
+        }
+    }
+
+    // Advance the deadline by whole intervals so timing errors do not
+    // accumulate; resync after idle periods or when running late
+    deadline += interval;
+    if (deadline < now || deadline > now + interval)
+        deadline = now + interval;
+
+    lastFrame = now;
+    haveLastFrame = true;
+}
+
+FramePacer::Stats FramePacer::getStats() const {
+    Stats s{0.0, 0.0, maxMs, frames};
+    if (frames == 0)
+        return s;
+
+    uint64_t p50 = (frames + 1) / 2;
+    uint64_t p99 = std::max<uint64_t>(1, (frames * 99 + 99) / 100);
+    uint64_t seen = 0;
+    bool have50 = false;
+    for (int b = 0; b < BUCKETS; b++) {
+        seen += (uint64_t)histogram[b];
+        double upper = (b + 1) * BUCKET_MS;
+        if (!have50 && seen >= p50) {
+            s.p50Ms = upper;
+            have50 = true;
+        }
+        if (seen >= p99) {
+            s.p99Ms = upper;
+            break;
+        }
+    }
+    s.p50Ms = std::min(s.p50Ms, maxMs);
+    s.p99Ms = std::min(s.p99Ms, maxMs);
+    return s;
+}
+
+void FramePacer::resetStats() {
+    std::fill(histogram.begin(), histogram.end(), 0.0f);
+    frames = 0;
+    maxMs = 0.0;
+    haveLastFrame = false;
+}
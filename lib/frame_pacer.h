@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// ============================
+// Frame pacing
+// ============================
+// Decides when the next frame may start and how the swap chain throttles:
+//   VSYNC    - swap interval 1, the blocking swap paces; the timer never
+//              skips a vblank, it only caps rates below the refresh rate
+//   TIMER    - swap interval 0, deadline-based scheduling on steady_clock
+//   ADAPTIVE - late-swap tearing (interval -1) when the driver supports it,
+//              vsync at full rate, timer for reduced rates
+// Also keeps a frame-time histogram of consecutive rendered frames.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Mode {
+        MODE_VSYNC = 0,
+        MODE_TIMER,
+        MODE_ADAPTIVE,
+        MODE_COUNT
+    };
+
+    struct Stats {
+        double p50Ms;
+        double p99Ms;
+        double maxMs;
+        uint64_t frames;
+    };
+
+    FramePacer();
+
+    // refreshHz from the monitor, tearControl = swap_control_tear available
+    void configure(int refreshHz, bool tearControl);
+
+    void setMode(Mode mode);
+    Mode getMode() const { return mode; }
+    static const char* modeName(int mode);
+
+    void setTargetFps(int fps);
+    int getTargetFps() const { return targetFps; }
+
+    // Swap interval the caller should pass to glfwSwapInterval after a change
+    int swapInterval() const;
+    bool swapIntervalChanged();
+
+    // Earliest time the next frame may start
+    Clock::time_point nextFrameTime() const;
+    bool due(Clock::time_point now) const { return now >= nextFrameTime(); }
+
+    // Call right before building a frame
+    void frameStarted(Clock::time_point now);
+
+    Stats getStats() const;
+    const std::vector<float>& getHistogram() const { return histogram; }
+    double getBucketMs() const { return BUCKET_MS; }
+    void resetStats();
+
+private:
+    bool timerPaced() const;
+
+    static constexpr double BUCKET_MS = 0.25;
+    static constexpr int BUCKETS = 400;          // 0..100 ms
+    static constexpr double IDLE_GAP_MS = 250.0; // longer gaps are idle, not pacing
+
+    Mode mode = MODE_VSYNC;
+    int refreshHz = 60;
+    bool tearControl = false;
+    int targetFps = 60;
+    int appliedInterval = -2;
+
+    Clock::duration interval;
+    Clock::time_point deadline;
+    Clock::time_point lastFrame;
+    bool haveLastFrame = false;
+
+    std::vector<float> histogram;
+    uint64_t frames = 0;
+    double maxMs = 0.0;
+};
@@ -0,0 +1,209 @@
+#include "latency_probe.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+// below this RMS (about -80 dBFS) a block counts as silence
+static constexpr float SILENCE_RMS = 1e-4f;
+// block level this far from the running level counts as new material
+static constexpr float JUMP_DB = 18.0f;
+
+LatencyProbe::LatencyProbe() {
+    for (Slot& s : slots)
+        s.command[0] = '\0';
+}
+
+int64_t LatencyProbe::toNs(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+LatencyProbe::Slot* LatencyProbe::find(uint64_t id) {
+    if (id == 0) return nullptr;
+    Slot& s = slots[id % SLOTS];
+    return s.id.load(std::memory_order_acquire) == id ? &s : nullptr;
+}
+
+uint64_t LatencyProbe::begin(const char* command) {
+    uint64_t id = nextId.fetch_add(1);
+    int index = (int)(id % SLOTS);
+    Slot& s = slots[index];
+
+    s.id.store(0, std::memory_order_release);
+    std::snprintf(s.command, sizeof(s.command), "%s", command);
+    s.sentNs = 0;
+    s.completedNs = 0;
+    s.pcmNs = 0;
+    s.audibleNs = 0;
+    s.backlogMs = 0.0f;
+    s.ok = false;
+    s.reported = false;
+    s.postedNs = toNs(std::chrono::steady_clock::now());
+    s.id.store(id, std::memory_order_release);
+
+    // a newer command supersedes the one being followed; this one is armed
+    // once it is actually sent, so nothing heard before can count for it
+    armed.store(-1, std::memory_order_release);
+    return id;
+}
+
+void LatencyProbe::sent(uint64_t id) {
+    if (Slot* s = find(id)) {
+        s->sentNs = toNs(std::chrono::steady_clock::now());
+        // only the newest command is followed
+        if (id + 1 == nextId.load())
+            armed.store((int)(id % SLOTS), std::memory_order_release);
+    }
+}
+
+void LatencyProbe::completed(uint64_t id, bool ok, double backlogMs) {
+    if (Slot* s = find(id)) {
+        s->ok = ok;
+        s->backlogMs = (float)backlogMs;
+        s->completedNs = toNs(std::chrono::steady_clock::now());
+    }
+}
+
+void LatencyProbe::onBlock(std::chrono::steady_clock::time_point start,
+                           std::chrono::steady_clock::time_point end,
+                           const int16_t* samples, int frames, int periodFrames,
+                           int sampleRate, double deviceLatencyMs)
+{
+    double sum = 0.0;
+    for (int i = 0; i < frames * 2; i++)
+        sum += (double)samples[i] * samples[i];
+    float rms = frames > 0 ? (float)(std::sqrt(sum / (frames * 2)) / 32768.0) : 0.0f;
+    bool silent = rms < SILENCE_RMS;
+
+    double periodMs = periodFrames * 1000.0 / sampleRate;
+    double waitedMs = std::chrono::duration<double, std::milli>(end - start).count();
+    bool gap = waitedMs > 2.0 * periodMs || frames < periodFrames;
+
+    int index = armed.load(std::memory_order_acquire);
+    if (index >= 0) {
+        Slot& s = slots[index];
+        int64_t sentAt = s.sentNs.load(std::memory_order_relaxed);
+        int64_t startNs = toNs(start);
+        int64_t endNs = toNs(end);
+        int64_t at = 0;
+
+        // blocks read before the request went out cannot be its effect
+        if (startNs >= sentAt) {
+            if (gap) {
+                // the stream stopped after the command: audio ended when we began waiting
+                at = startNs;
+            } else {
+                bool onset = wasSilent && !silent;
+                bool stop  = !wasSilent && silent;
+                bool jump  = !silent && levelEma > 0.0f &&
+                             std::fabs(20.0f * std::log10(rms / levelEma)) > JUMP_DB;
+                if (onset || stop || jump)
+                    at = endNs;
+            }
+        }
+
+        if (at != 0) {
+            s.pcmNs = at;
+            s.audibleNs = at + (int64_t)(deviceLatencyMs * 1e6);
+            armed.compare_exchange_strong(index, -1);
+        }
+    }
+
+    if (!silent)
+        levelEma = levelEma > 0.0f ? levelEma * 0.8f + rms * 0.2f : rms;
+    wasSilent = silent;
+}
+
+void LatencyProbe::report(Slot& s, int64_t now) {
+    auto ms = [](int64_t a, int64_t b) { return (a && b) ? (b - a) / 1e6 : 0.0; };
+
+    Record r;
+    std::memcpy(r.command, s.command, sizeof(r.command));
+    r.id        = s.id;
+    r.ok        = s.ok;
+    r.detected  = s.pcmNs != 0;
+    // go-librespot may change the sound before it answers: the reply then
+    // ends at the change and librespot+pipe is 0
+    int64_t replied = s.completedNs;
+    if (r.detected && replied != 0 && s.pcmNs < replied)
+        replied = s.pcmNs;
+    r.queueMs   = ms(s.postedNs, s.sentNs);
+    r.apiMs     = ms(s.sentNs, replied);
+    r.pcmMs     = ms(replied, s.pcmNs);
+    r.deviceMs  = ms(s.pcmNs, s.audibleNs);
+    r.totalMs   = ms(s.postedNs, r.detected ? (int64_t)s.audibleNs : now);
+    r.backlogMs = s.backlogMs;
+    s.reported = true;
+
+    char line[256];
+    if (r.detected) {
+        std::snprintf(line, sizeof(line),
+            "[latency] %s: queue %.1f | api %.1f | librespot+pipe %.1f (backlog %.0f) | device %.1f | total %.1f ms%s",
+            r.command, r.queueMs, r.apiMs, r.pcmMs, r.backlogMs, r.deviceMs, r.totalMs,
+            r.ok ? "" : " (HTTP failed)");
+    } else {
+        std::snprintf(line, sizeof(line),
+            "[latency] %s: queue %.1f | api %.1f | no audible change within %d ms%s",
+            r.command, r.queueMs, r.apiMs, TIMEOUT_MS, r.ok ? "" : " (HTTP failed)");
+    }
+    std::cout << line << std::endl;
+
+    std::lock_guard<std::mutex> lock(summaryMutex);
+    history.push_back(r);
+}
+
+bool LatencyProbe::poll() {
+    int64_t now = toNs(std::chrono::steady_clock::now());
+    bool pending = false;
+
+    for (int i = 0; i < SLOTS; i++) {
+        Slot& s = slots[i];
+        if (s.id == 0 || s.reported)
+            continue;
+
+        bool done = s.pcmNs != 0 && s.completedNs != 0;
+        bool expired = now - s.postedNs > (int64_t)TIMEOUT_MS * 1000000;
+        if (done || expired) {
+            if (!done) {
+                int index = i;
+                armed.compare_exchange_strong(index, -1);
+            }
+            report(s, now);
+        } else {
+            pending = true;
+        }
+    }
+    return pending;
+}
+
+void LatencyProbe::printSummary() {
+    struct Sum { int n = 0, missed = 0; double queue = 0, api = 0, pcm = 0, device = 0, total = 0; };
+
+    std::lock_guard<std::mutex> lock(summaryMutex);
+    if (history.empty()) return;
+
+    std::map<std::string, Sum> sums;
+    for (const Record& r : history) {
+        Sum& s = sums[r.command];
+        if (!r.detected) { s.missed++; continue; }
+        s.n++;
+        s.queue += r.queueMs;
+        s.api += r.apiMs;
+        s.pcm += r.pcmMs;
+        s.device += r.deviceMs;
+        s.total += r.totalMs;
+    }
+
+    std::cout << "[latency] averages (ms): queue | api | librespot+pipe | device | total" << std::endl;
+    for (const auto& kv : sums) {
+        const Sum& s = kv.second;
+        int n = std::max(s.n, 1);
+        char line[192];
+        std::snprintf(line, sizeof(line), "  %-24s x%-3d %6.1f %6.1f %8.1f %6.1f %7.1f  (%d undetected)",
+            kv.first.c_str(), s.n, s.queue / n, s.api / n, s.pcm / n, s.device / n, s.total / n, s.missed);
+        std::cout << line << std::endl;
+    }
+}
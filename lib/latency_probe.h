@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ============================
+// Command-to-audible latency probe
+// ============================
+// Follows one transport command (play/pause, next, prev, load) from the
+// click to the speaker:
+//
+//   posted     post_json() queued it
+//   sent       the control lane started the HTTP request
+//   completed  go-librespot answered
+//   pcm        the device callback read the first block from the FIFO that
+//              differs (silence / gap / new sound / level jump)
+//   audible    pcm + the device buffer, i.e. when that block leaves the DAC
+//
+// Only the newest command is armed, from the moment it is sent; a new one
+// supersedes it. The audio callback side is lock-free and allocation-free.
+class LatencyProbe {
+public:
+    struct Record {
+        char command[32];
+        uint64_t id;
+        double queueMs;      // posted -> sent
+        double apiMs;        // sent -> completed (or the change, if that came first)
+        double pcmMs;        // completed -> changed block read (librespot + pipe), >= 0
+        double deviceMs;     // block read -> audible (device buffer estimate)
+        double totalMs;      // posted -> audible
+        double backlogMs;    // audio queued in the FIFO when the HTTP call completed
+        bool ok;             // HTTP succeeded
+        bool detected;       // a change was seen before the timeout
+    };
+
+    LatencyProbe();
+
+    // Returns a command id for sent()/completed(); 0 = not tracked
+    uint64_t begin(const char* command);
+    void sent(uint64_t id);
+    void completed(uint64_t id, bool ok, double backlogMs);
+
+    // Audio callback: one device period. start is the callback entry, end
+    // when the FIFO read returned; a long wait in between is a producer gap.
+    void onBlock(std::chrono::steady_clock::time_point start,
+                 std::chrono::steady_clock::time_point end,
+                 const int16_t* samples, int frames, int periodFrames,
+                 int sampleRate, double deviceLatencyMs);
+
+    // UI thread: prints records that are finished (or timed out) and
+    // returns whether a command is still being followed
+    bool poll();
+
+    // Per-command averages, printed at shutdown
+    void printSummary();
+
+private:
+    static constexpr int SLOTS = 64;
+    static constexpr int TIMEOUT_MS = 5000;
+
+    struct Slot {
+        char command[32];
+        std::atomic<uint64_t> id{0};
+        std::atomic<int64_t> postedNs{0};
+        std::atomic<int64_t> sentNs{0};
+        std::atomic<int64_t> completedNs{0};
+        std::atomic<int64_t> pcmNs{0};
+        std::atomic<int64_t> audibleNs{0};
+        std::atomic<float> backlogMs{0.0f};
+        std::atomic<bool> ok{false};
+        bool reported = false;   // UI thread only
+    };
+
+    Slot* find(uint64_t id);
+    void report(Slot& s, int64_t now);
+    static int64_t toNs(std::chrono::steady_clock::time_point t);
+
+    Slot slots[SLOTS];
+    std::atomic<uint64_t> nextId{1};
+    std::atomic<int> armed{-1};   // slot the callback is watching
+
+    // callback-only detection state
+    float levelEma = 0.0f;
+    bool wasSilent = true;
+
+    std::mutex summaryMutex;
+    std::vector<Record> history;
+};
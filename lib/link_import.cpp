@@ -0,0 +1,185 @@
+#include "link_import.h"
+#include "spotify_uri.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_set>
+
+// below this much text one thread is faster than starting more
+static constexpr size_t PARALLEL_MIN_BYTES = 64 * 1024;
+static constexpr int MAX_PARSE_THREADS = 8;
+static constexpr size_t MAX_FILE_BYTES = 256u << 20;
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// Parses every whitespace-separated token of [p, end)
+static void parse_range(const char* p, const char* end, std::vector<SpotifyRef>& out, uint64_t& tokens) {
+    while (p < end) {
+        while (p < end && is_space(*p)) p++;
+        const char* tokenEnd = p;
+        while (tokenEnd < end && !is_space(*tokenEnd)) tokenEnd++;
+        if (tokenEnd > p) {
+            tokens++;
+            SpotifyRef ref;
+            if (spotify_parse(p, (size_t)(tokenEnd - p), ref))
+                out.push_back(ref);
+        }
+        p = tokenEnd;
+    }
+}
+
+LinkImporter::LinkImporter() = default;
+
+LinkImporter::~LinkImporter() {
+    stop();
+}
+
+void LinkImporter::start() {
+    running = true;
+    thread = std::thread(&LinkImporter::threadFunc, this);
+}
+
+void LinkImporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        running = false;
+    }
+    jobCv.notify_all();
+    if (thread.joinable())
+        thread.join();
+}
+
+void LinkImporter::submitText(std::string text, Target target) {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back(Job{false, std::move(text), target});
+        busy = true;
+    }
+    jobCv.notify_one();
+}
+
+void LinkImporter::submitFile(std::string path, Target target) {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back(Job{true, std::move(path), target});
+        busy = true;
+    }
+    jobCv.notify_one();
+}
+
+bool LinkImporter::drain(Target target, std::vector<std::string>& out) {
+    std::lock_guard<std::mutex> lock(resultMutex);
+    std::vector<std::string>& results = this->results[target];
+    if (results.empty())
+        return false;
+    if (out.empty()) {
+        out.swap(results);
+    } else {
+        out.insert(out.end(), std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
+        results.clear();
+    }
+    return true;
+}
+
+void LinkImporter::threadFunc() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobCv.wait(lock, [&] { return !running || !jobs.empty(); });
+            if (!running)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        if (job.isFile) {
+            std::ifstream in(job.data, std::ios::binary);
+            if (!in) {
+                std::cout << "[import] cannot open " << job.data << std::endl;
+            } else {
+                in.seekg(0, std::ios::end);
+                std::streamoff size = in.tellg();
+                in.seekg(0, std::ios::beg);
+                if (size < 0 || (size_t)size > MAX_FILE_BYTES) {
+                    std::cout << "[import] " << job.data << " is too large" << std::endl;
+                } else {
+                    std::string text((size_t)size, '\0');
+                    in.read(&text[0], size);
+                    text.resize((size_t)in.gcount());
+                    std::cout << "[import] reading " << job.data << std::endl;
+                    importText(text, job.target);
+                }
+            }
+        } else {
+            importText(job.data, job.target);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            if (jobs.empty())
+                busy = false;
+        }
+        if (onReady)
+            onReady();
+    }
+}
+
+void LinkImporter::importText(const std::string& text, Target target) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+
+    // ---- Split at whitespace into one range per thread ----
+    int parts = 1;
+    if (text.size() >= PARALLEL_MIN_BYTES) {
+        int hw = (int)std::thread::hardware_concurrency();
+        parts = std::clamp(hw, 1, MAX_PARSE_THREADS);
+        parts = std::min<int>(parts, (int)(text.size() / PARALLEL_MIN_BYTES) + 1);
+    }
+
+    std::vector<const char*> cuts{begin};
+    for (int k = 1; k < parts; k++) {
+        const char* c = std::max(cuts.back(), begin + text.size() * k / parts);
+        while (c < end && !is_space(*c)) c++;
+        cuts.push_back(c);
+    }
+    cuts.push_back(end);
+
+    std::vector<std::vector<SpotifyRef>> found(parts);
+    std::vector<uint64_t> tokens(parts, 0);
+    std::vector<std::thread> helpers;
+    for (int k = 1; k < parts; k++)
+        helpers.emplace_back(parse_range, cuts[k], cuts[k + 1], std::ref(found[k]), std::ref(tokens[k]));
+    parse_range(cuts[0], cuts[1], found[0], tokens[0]);
+    for (auto& h : helpers)
+        h.join();
+
+    // ---- Merge in input order, dropping repeats ----
+    std::vector<std::string> batch;
+    std::unordered_set<std::string> seen;
+    uint64_t tokenCount = 0;
+    for (int k = 0; k < parts; k++) {
+        tokenCount += tokens[k];
+        for (const SpotifyRef& ref : found[k]) {
+            char uri[40];
+            size_t len = spotify_format(ref, uri, sizeof(uri));
+            std::string s(uri, len);
+            if (seen.insert(s).second)
+                batch.push_back(std::move(s));
+        }
+    }
+
+    tokensSeen += tokenCount;
+    linksFound += batch.size();
+    std::cout << "[import] " << batch.size() << " link(s) from " << tokenCount << " token(s)" << std::endl;
+    if (onImported[target])
+        onImported[target](batch);
+
+    std::lock_guard<std::mutex> lock(resultMutex);
+    std::vector<std::string>& results = this->results[target];
+    results.insert(results.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+// ============================
+// Bulk link import
+// ============================
+// Turns pasted text or dropped / named text files into canonical Spotify
+// URIs off the render thread. Every whitespace-separated token is tried as
+// a link; large inputs are split across several threads. Results keep the
+// input order with duplicates removed, and are collected with drain() for
+// the list they were submitted for.
+class LinkImporter {
+public:
+    enum Target { QUEUE, PLAYLIST, TARGET_COUNT };
+
+    LinkImporter();
+    ~LinkImporter();
+
+    void start();
+    void stop();
+
+    void submitText(std::string text, Target target = QUEUE);
+    void submitFile(std::string path, Target target = QUEUE);
+
+    // Called on the import thread after each job (e.g. to wake the UI)
+    void setOnReady(std::function<void()> fn) { onReady = std::move(fn); }
+    // Before start(): called on the import thread with each job's links for
+    // target before they can be drained, for work that may leave the render
+    // thread (e.g. adding them to a list that locks itself)
+    using Imported = std::function<void(const std::vector<std::string>& links)>;
+    void setOnImported(Target target, Imported fn) { onImported[target] = std::move(fn); }
+
+    // Moves finished URIs into out (appending); false if there were none
+    bool drain(Target target, std::vector<std::string>& out);
+
+    bool isBusy() const { return busy; }
+    uint64_t getLinksFound() const { return linksFound; }
+    uint64_t getTokensSeen() const { return tokensSeen; }
+
+private:
+    struct Job {
+        bool isFile;
+        std::string data;   // text, or a file path
+        Target target;
+    };
+
+    void threadFunc();
+    void importText(const std::string& text, Target target);
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> busy{false};
+    std::atomic<uint64_t> linksFound{0};
+    std::atomic<uint64_t> tokensSeen{0};
+
+    std::mutex jobMutex;
+    std::condition_variable jobCv;
+    std::deque<Job> jobs;
+
+    std::mutex resultMutex;
+    std::vector<std::string> results[TARGET_COUNT];
+
+    std::function<void()> onReady;
+    Imported onImported[TARGET_COUNT];
+};
@@ -0,0 +1,324 @@
+#include "loudness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+static constexpr float SILENT_LUFS = -200.0f;
+
+// ============================
+// LoudnessMeter
+// ============================
+// K-weighting filter coefficients for any sample rate, from the analog
+// prototypes behind the 48 kHz tables in ITU-R BS.1770
+LoudnessMeter::LoudnessMeter(int sampleRate, int channels_)
+    : channels(channels_),
+      stepFrames(sampleRate / 10)
+{
+    const double pi = 3.14159265358979323846;
+
+    // stage 1: high shelf, +4 dB above ~1.7 kHz (head effects)
+    double f0 = 1681.974450955533, gain = 3.999843853973347, q = 0.7071752369554196;
+    double k = std::tan(pi * f0 / sampleRate);
+    double vh = std::pow(10.0, gain / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    shelf = {(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+             2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+
+    // stage 2: RLB high pass at ~38 Hz
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(pi * f0 / sampleRate);
+    a0 = 1.0 + k / q + k * k;
+    highpass = {1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+
+    state.assign((size_t)channels * 4, 0.0);
+}
+
+void LoudnessMeter::reset() {
+    std::fill(state.begin(), state.end(), 0.0);
+    stepSum = 0;
+    stepFill = 0;
+    stepCount = 0;
+    gatedBlocks = 0;
+    std::fill(std::begin(histCount), std::end(histCount), 0u);
+    std::fill(std::begin(histEnergy), std::end(histEnergy), 0.0);
+}
+
+float LoudnessMeter::toLufs(double meanSquare) {
+    return meanSquare > 1e-20 ? (float)(-0.691 + 10.0 * std::log10(meanSquare)) : SILENT_LUFS;
+}
+
+bool LoudnessMeter::process(const int16_t* samples, int frames) {
+    bool stepped = false;
+    for (int f = 0; f < frames; f++) {
+        for (int c = 0; c < channels; c++) {
+            double x = samples[f * channels + c] * (1.0 / 32768.0);
+            double* z = &state[(size_t)c * 4];
+            // transposed direct form II, both stages
+            double y = shelf.b0 * x + z[0];
+            z[0] = shelf.b1 * x - shelf.a1 * y + z[1];
+            z[1] = shelf.b2 * x - shelf.a2 * y;
+            double w = highpass.b0 * y + z[2];
+            z[2] = highpass.b1 * y - highpass.a1 * w + z[3];
+            z[3] = highpass.b2 * y - highpass.a2 * w;
+            stepSum += w * w;   // channel weight 1 for L / R
+        }
+        if (++stepFill == stepFrames) {
+            endStep();
+            stepped = true;
+        }
+    }
+    return stepped;
+}
+
+void LoudnessMeter::endStep() {
+    steps[stepCount % SHORT_TERM_STEPS] = stepSum / stepFrames;
+    stepCount++;
+    stepSum = 0;
+    stepFill = 0;
+
+    // a 400 ms gating block ends every step (75 % overlap)
+    if (stepCount >= 4) {
+        double block = 0;
+        for (int i = 1; i <= 4; i++)
+            block += steps[(stepCount - i) % SHORT_TERM_STEPS];
+        block /= 4;
+        float l = toLufs(block);
+        if (l >= HIST_LOW) {
+            int bin = std::min(HIST_BINS - 1, (int)((l - HIST_LOW) * 10.0f));
+            histCount[bin]++;
+            histEnergy[bin] += block;
+            gatedBlocks++;
+        }
+    }
+
+    // silence decays the filter state towards denormals, which are slow
+    for (double& z : state)
+        if (std::fabs(z) < 1e-200)
+            z = 0.0;
+}
+
+float LoudnessMeter::momentary() const {
+    int n = std::min(stepCount, 4);
+    double sum = 0;
+    for (int i = 1; i <= n; i++)
+        sum += steps[(stepCount - i) % SHORT_TERM_STEPS];
+    return n ? toLufs(sum / n) : SILENT_LUFS;
+}
+
+float LoudnessMeter::shortTerm() const {
+    int n = std::min(stepCount, SHORT_TERM_STEPS);
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += steps[i];
+    return n ? toLufs(sum / n) : SILENT_LUFS;
+}
+
+float LoudnessMeter::integrated() const {
+    if (gatedBlocks == 0)
+        return SILENT_LUFS;
+    double energy = 0;
+    for (int i = 0; i < HIST_BINS; i++)
+        energy += histEnergy[i];
+    float relative = toLufs(energy / gatedBlocks) - 10.0f;
+
+    // bins are 0.1 LU wide; a bin is in if its blocks average above the gate
+    double gated = 0;
+    uint64_t count = 0;
+    for (int i = 0; i < HIST_BINS; i++) {
+        if (histCount[i] && toLufs(histEnergy[i] / histCount[i]) >= relative) {
+            gated += histEnergy[i];
+            count += histCount[i];
+        }
+    }
+    return count ? toLufs(gated / count) : SILENT_LUFS;
+}
+
+// ============================
+// LoudnessNormalizer
+// ============================
+LoudnessNormalizer::LoudnessNormalizer(int sampleRate_, float targetLufs)
+    : meter(sampleRate_, 2),
+      sampleRate(sampleRate_),
+      target(targetLufs),
+      knownLufs(NAN),
+      measured(SILENT_LUFS),
+      shortTerm(SILENT_LUFS)
+{
+}
+
+void LoudnessNormalizer::startTrack(float lufs) {
+    knownLufs.store(lufs, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+}
+
+static float clamp_gain(float db) {
+    return std::max(LoudnessNormalizer::MAX_CUT_DB, std::min(LoudnessNormalizer::MAX_BOOST_DB, db));
+}
+
+void LoudnessNormalizer::process(const int16_t* samples, float* out, int frames) {
+    if (frames <= 0)
+        return;
+
+    uint32_t gen = generation.load(std::memory_order_acquire);
+    if (gen != seenGeneration) {
+        seenGeneration = gen;
+        meter.reset();
+        float known = knownLufs.load(std::memory_order_relaxed);
+        bool fixed = !std::isnan(known);
+        fixedGain.store(fixed, std::memory_order_relaxed);
+        // a new track keeps the current gain until it has been heard a bit
+        wantedDb = fixed ? clamp_gain(target - known) : currentDb;
+        measured.store(SILENT_LUFS, std::memory_order_relaxed);
+        measuredSecs.store(0.0, std::memory_order_relaxed);
+    }
+
+    // ---- Meter (before the gain: it measures the track, not our output) ----
+    if (meter.process(samples, frames)) {
+        float integrated = meter.integrated();
+        measured.store(integrated, std::memory_order_relaxed);
+        measuredSecs.store(meter.gatedSeconds(), std::memory_order_relaxed);
+        shortTerm.store(meter.shortTerm(), std::memory_order_relaxed);
+        if (!fixedGain.load(std::memory_order_relaxed) && meter.gatedSeconds() >= SETTLE_SECONDS)
+            wantedDb = clamp_gain(target - integrated);
+    }
+
+    // ---- Gain, ramped across the block ----
+    bool on = enabled.load(std::memory_order_relaxed);
+    float goal = on ? wantedDb : 0.0f;
+    bool quick = !on || fixedGain.load(std::memory_order_relaxed);
+    float step = (quick ? KNOWN_SLEW_DB_PER_S : SLEW_DB_PER_S) * frames / sampleRate;
+    float nextDb = currentDb + std::max(-step, std::min(step, goal - currentDb));
+
+    float g0 = std::pow(10.0f, currentDb / 20.0f);
+    float g1 = std::pow(10.0f, nextDb / 20.0f);
+    currentDb = nextDb;
+    appliedDb.store(nextDb, std::memory_order_relaxed);
+
+    // not clipped: the output limiter behind this keeps the peaks in range
+    float dg = (g1 - g0) / frames * (1.0f / 32768.0f);
+    float g = g0 * (1.0f / 32768.0f);
+    for (int f = 0; f < frames; f++) {
+        g += dg;
+        out[f * 2] = samples[f * 2] * g;
+        out[f * 2 + 1] = samples[f * 2 + 1] * g;
+    }
+}
+
+// ============================
+// LoudnessCache
+// ============================
+LoudnessCache::LoudnessCache(const std::string& path_) : path(path_) {
+}
+
+bool LoudnessCache::load() {
+    std::ifstream in(path);
+    if (!in)
+        return true; // nothing measured yet
+
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t t1 = line.find('\t');
+        size_t t2 = t1 == std::string::npos ? t1 : line.find('\t', t1 + 1);
+        if (t1 == 0 || t2 == std::string::npos)
+            continue;
+        float lufs = std::strtof(line.c_str() + t1 + 1, nullptr);
+        float seconds = std::strtof(line.c_str() + t2 + 1, nullptr);
+        if (!std::isfinite(lufs) || lufs < -70.0f || lufs > 10.0f)
+            continue;
+        entries[line.substr(0, t1)] = Entry{lufs, seconds};
+    }
+    return !in.bad();
+}
+
+float LoudnessCache::get(const std::string& uri) const {
+    auto it = entries.find(uri);
+    return it == entries.end() ? NAN : it->second.lufs;
+}
+
+void LoudnessCache::put(const std::string& uri, float lufs, double seconds) {
+    if (uri.empty() || uri.find_first_of("\t\n") != std::string::npos)
+        return;
+    auto it = entries.find(uri);
+    if (it != entries.end() && it->second.seconds >= seconds - 1.0)
+        return;
+    entries[uri] = Entry{lufs, (float)seconds};
+
+    FILE* f = std::fopen(path.c_str(), "a");
+    if (!f)
+        return;
+    std::fprintf(f, "%s\t%.2f\t%.1f\n", uri.c_str(), lufs, seconds);
+    std::fclose(f);
+}
+
+// ============================
+// Benchmark
+// ============================
+void loudness_benchmark(int seconds) {
+    using clock = std::chrono::steady_clock;
+    if (seconds <= 0)
+        seconds = 600;
+    const int rate = 44100, block = 1024;
+
+    // pink-ish noise with a slow level swing, like music between passages
+    std::mt19937 rng(3);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::vector<int16_t> audio((size_t)rate * 10 * 2);
+    float lp = 0;
+    for (size_t i = 0; i < audio.size(); i++) {
+        lp = 0.9f * lp + 0.1f * noise(rng);
+        float level = 0.15f + 0.1f * std::sin(i * 2e-5f);
+        audio[i] = (int16_t)std::max(-32768.0f, std::min(32767.0f, lp * level * 32767.0f * 3.0f));
+    }
+
+    // sanity: a 1 kHz stereo sine at -23 dBFS reads -23 LUFS
+    {
+        LoudnessMeter m(rate, 2);
+        std::vector<int16_t> sine((size_t)rate * 2);
+        float amp = std::pow(10.0f, -23.0f / 20.0f) * 32767.0f;
+        for (int i = 0; i < rate; i++)
+            sine[i * 2] = sine[i * 2 + 1] = (int16_t)(amp * std::sin(2.0 * 3.14159265358979 * 1000.0 * i / rate));
+        for (int k = 0; k < 5; k++)
+            m.process(sine.data(), rate);
+        std::printf("loudness: 1 kHz sine at -23 dBFS reads %.2f LUFS integrated, %.2f momentary\n",
+                    m.integrated(), m.momentary());
+    }
+
+    size_t frames = audio.size() / 2;
+    std::vector<float> out((size_t)block * 2);
+    auto run = [&](const char* name, auto&& fn) {
+        std::vector<int16_t> work(audio);
+        auto t0 = clock::now();
+        size_t done = 0;
+        for (int s = 0; s < seconds; s += 10) {
+            std::copy(audio.begin(), audio.end(), work.begin());
+            for (size_t f = 0; f < frames; f += block) {
+                int n = (int)std::min<size_t>(block, frames - f);
+                fn(work.data() + f * 2, n);
+                done += n;
+            }
+        }
+        double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+        double audioMs = done * 1000.0 / rate;
+        std::printf("  %-11s %.3f ms per second of audio, %.3f%% of one core\n", name, ms / (audioMs / 1000.0),
+                    ms / audioMs * 100.0);
+    };
+
+    LoudnessMeter meter(rate, 2);
+    float last = 0;
+    std::printf("  %d s of stereo audio in %d-frame callbacks\n", seconds, block);
+    run("meter", [&](int16_t* p, int n) {
+        if (meter.process(p, n))
+            last = meter.integrated();   // as the normalizer reads it
+    });
+    LoudnessNormalizer norm(rate);
+    norm.startTrack(NAN);
+    run("normalizer", [&](int16_t* p, int n) { norm.process(p, out.data(), n); });
+    std::printf("  integrated %.2f LUFS, adaptive gain now %.2f dB\n", last, norm.gainDb());
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+
+// ============================
+// EBU R128 loudness meter
+// ============================
+// K-weighted mean square over 100 ms steps: momentary is the last 400 ms,
+// short-term the last 3 s, integrated is gated (-70 LUFS absolute, -10 LU
+// relative) over everything since reset(). Gated blocks go into a 0.1 LU
+// histogram, so the integrated value costs the same after an hour as after
+// a second. Values are LUFS; quieter than -70 reads as -70 or below.
+class LoudnessMeter {
+public:
+    LoudnessMeter(int sampleRate, int channels);
+
+    void reset();
+    // interleaved s16; returns whether a 100 ms step completed
+    bool process(const int16_t* samples, int frames);
+
+    float momentary() const;
+    float shortTerm() const;
+    float integrated() const;
+    // audio that passed the absolute gate
+    double gatedSeconds() const { return gatedBlocks * 0.1; }
+
+private:
+    static constexpr int SHORT_TERM_STEPS = 30;   // 3 s of 100 ms steps
+    static constexpr int HIST_BINS = 750;          // -70 .. +5 LUFS in 0.1 LU
+    static constexpr float HIST_LOW = -70.0f;
+
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+
+    static float toLufs(double meanSquare);
+    void endStep();
+
+    int channels;
+    int stepFrames;
+    Biquad shelf, highpass;
+    std::vector<double> state;   // per channel: shelf z1 z2, highpass z1 z2
+
+    double stepSum = 0;          // weighted square sum in the running step
+    int stepFill = 0;
+    double steps[SHORT_TERM_STEPS] = {};   // mean square per finished step
+    int stepCount = 0;
+
+    uint64_t gatedBlocks = 0;
+    uint32_t histCount[HIST_BINS] = {};
+    double histEnergy[HIST_BINS] = {};
+};
+
+// ============================
+// Loudness normalizer
+// ============================
+// Runs on the audio thread: meters each track as it arrives and scales it
+// towards targetLufs. A track whose loudness is known (measured on an
+// earlier play) gets its exact gain from the start; a new one starts with
+// the previous track's gain and glides towards the gain its integrated
+// loudness asks for, at most SLEW_DB_PER_S, with no look-ahead.
+class LoudnessNormalizer {
+public:
+    LoudnessNormalizer(int sampleRate, float targetLufs = -14.0f);
+
+    // audio thread: meters the samples, writes them with the gain applied to
+    // out as floats (full scale 1.0, may exceed it)
+    void process(const int16_t* samples, float* out, int frames);
+
+    // one control thread at a time: a new track starts; knownLufs is NAN if it was never measured
+    void startTrack(float knownLufs);
+    void setEnabled(bool on) { enabled = on; }
+    bool isEnabled() const { return enabled; }
+
+    // any thread: the current track as measured so far
+    float measuredLufs() const { return measured.load(std::memory_order_relaxed); }
+    double measuredSeconds() const { return measuredSecs.load(std::memory_order_relaxed); }
+    float shortTermLufs() const { return shortTerm.load(std::memory_order_relaxed); }
+    float gainDb() const { return appliedDb.load(std::memory_order_relaxed); }
+    bool gainKnown() const { return fixedGain.load(std::memory_order_relaxed); }
+
+    static constexpr float MAX_BOOST_DB = 6.0f;
+    static constexpr float MAX_CUT_DB = -20.0f;
+
+private:
+    static constexpr float SLEW_DB_PER_S = 1.5f;
+    static constexpr float KNOWN_SLEW_DB_PER_S = 60.0f;   // a quick, click-free jump
+    static constexpr double SETTLE_SECONDS = 3.0;          // before the first adaptive move
+
+    LoudnessMeter meter;
+    int sampleRate;
+    float target;
+    float currentDb = 0.0f;     // audio thread
+    float wantedDb = 0.0f;
+
+    std::atomic<bool> enabled{true};
+    std::atomic<uint32_t> generation{0};
+    uint32_t seenGeneration = 0;
+    std::atomic<float> knownLufs;
+    std::atomic<bool> fixedGain{false};
+
+    std::atomic<float> measured;
+    std::atomic<double> measuredSecs{0.0};
+    std::atomic<float> shortTerm;
+    std::atomic<float> appliedDb{0.0f};
+};
+
+// ============================
+// Loudness cache
+// ============================
+// Measured loudness per track URI, so replays are normalized from the
+// start. Text file, one "uri \t LUFS \t seconds measured" per line; lines
+// are only appended and later lines win.
+class LoudnessCache {
+public:
+    explicit LoudnessCache(const std::string& path);
+
+    bool load();
+    // NAN if unknown
+    float get(const std::string& uri) const;
+    // Keeps the measurement if it covers more of the track than the known one
+    void put(const std::string& uri, float lufs, double seconds);
+
+    size_t size() const { return entries.size(); }
+
+private:
+    struct Entry {
+        float lufs;
+        float seconds;
+    };
+
+    std::string path;
+    std::unordered_map<std::string, Entry> entries;
+};
+
+// spotamp --bench-loudness [seconds]: meter / normalizer cost per second of
+// audio, as a share of one core
+void loudness_benchmark(int seconds);
@@ -0,0 +1,126 @@
+#include "mapped_file.h"
+
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <cstdio>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mapHandle = mapping;
+    base = (const char*)view;
+    length = (size_t)size.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    if (view == MAP_FAILED)
+        return false;
+    base = (const char*)view;
+    length = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!base)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle((HANDLE)mapHandle);
+    CloseHandle((HANDLE)fileHandle);
+    fileHandle = mapHandle = nullptr;
+#else
+    munmap((void*)base, length);
+#endif
+    base = nullptr;
+    length = 0;
+}
+
+// ============================
+// Append-only record files
+// ============================
+uint32_t fnv1a(const char* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (uint8_t)p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+size_t map_record_file(MappedFile& file, const std::string& path, std::mutex& lock,
+                       const char* log, const char* kind, const std::function<size_t()>& scan) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        file.open(path);
+    }
+    if (!file.data())
+        return 0;
+
+    size_t validEnd = scan();
+    if (validEnd == 0) {
+        std::cout << log << " " << path << " is not " << kind << ", starting over" << std::endl;
+    } else if (validEnd < file.size()) {
+        std::cout << log << " dropping " << file.size() - validEnd << " torn bytes" << std::endl;
+        std::error_code ec;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            file.close();   // Windows cannot shrink a mapped file
+            std::filesystem::resize_file(path, validEnd, ec);
+            if (!ec)
+                file.open(path);
+        }
+        if (ec || !file.data() || scan() != validEnd)
+            validEnd = 0;
+    }
+    return validEnd;
+}
+
+// ============================
+// File replacement
+// ============================
+bool replace_file(const std::string& tmp, const std::string& path) {
+#ifdef _WIN32
+    return MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+#endif
+}
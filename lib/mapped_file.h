@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+// ============================
+// Read-only memory-mapped file
+// ============================
+// The whole file is mapped once; the bytes stay valid until close() or
+// destruction. Bytes appended to the file later are not visible.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // false if the file is missing or empty
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+
+private:
+    const char* base = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mapHandle = nullptr;
+#endif
+};
+
+// ============================
+// Append-only record files
+// ============================
+// The metadata cache and the play history append checksummed records to a
+// file that is mapped on start.
+
+uint32_t fnv1a(const char* p, size_t n);
+
+// Maps path into file and has scan() index it; scan returns the end of the
+// last whole record, 0 if the file is not of this kind. A torn tail after
+// that (a crash mid-append) is cut off, so appends line up, and the file is
+// scanned again. Returns the valid length: 0 if the file is missing, not of
+// this kind or could not be repaired. file is only (re)opened under lock;
+// log is the "[tag]" prefix, kind the "not a ..." name for messages.
+size_t map_record_file(MappedFile& file, const std::string& path, std::mutex& lock,
+                       const char* log, const char* kind, const std::function<size_t()>& scan);
+
+// ============================
+// File replacement
+// ============================
+// Moves tmp over path in one step, for the write-a-temp-then-rename saves:
+// path is either the old file or the new one, never missing. false on error
+// (tmp is left in place).
+bool replace_file(const std::string& tmp, const std::string& path);
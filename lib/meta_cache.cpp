@@ -0,0 +1,251 @@
+#include "meta_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// ============================
+// File format
+// ============================
+// "SPMC", version, then records: u32 payload size, u32 FNV-1a of the
+// payload, payload = uri, title, artists, album, cover (u16-length strings)
+// and the duration (i32). Integers are little-endian.
+
+static const char FILE_MAGIC[4] = {'S', 'P', 'M', 'C'};
+static constexpr size_t RECORD_HEADER = 8;
+
+static uint32_t read_u32(const char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+static void append_u32(std::string& out, uint32_t v) {
+    out.append((const char*)&v, 4);
+}
+
+static void append_str(std::string& out, const std::string& s) {
+    uint16_t n = (uint16_t)std::min<size_t>(s.size(), 0xFFFF);
+    out.append((const char*)&n, 2);
+    out.append(s.data(), n);
+}
+
+namespace {
+struct Reader {
+    const char* p;
+    const char* end;
+    bool ok = true;
+    std::string_view str() {
+        uint16_t n = 0;
+        if (!ok || end - p < 2) { ok = false; return {}; }
+        std::memcpy(&n, p, 2);
+        p += 2;
+        if ((size_t)(end - p) < n) { ok = false; return {}; }
+        std::string_view s(p, n);
+        p += n;
+        return s;
+    }
+};
+}
+
+bool MetaCache::decode(const char* p, size_t size, TrackMeta& out) {
+    Reader r{p, p + size};
+    std::string_view f[5];
+    for (std::string_view& s : f)
+        s = r.str();
+    if (!r.ok || r.end - r.p != 4)
+        return false;
+    out.uri.assign(f[0]);
+    out.title.assign(f[1]);
+    out.artists.assign(f[2]);
+    out.album.assign(f[3]);
+    out.coverUrl.assign(f[4]);
+    int32_t d;
+    std::memcpy(&d, r.p, 4);
+    out.durationMs = d;
+    return true;
+}
+
+static bool same_meta(const TrackMeta& a, const TrackMeta& b) {
+    return a.title == b.title && a.artists == b.artists && a.album == b.album &&
+           a.coverUrl == b.coverUrl && a.durationMs == b.durationMs;
+}
+
+// ============================
+// MetaCache
+// ============================
+MetaCache::MetaCache(const std::string& path_) : path(path_) {
+}
+
+MetaCache::~MetaCache() {
+    stop();
+}
+
+void MetaCache::start() {
+    running = true;
+    thread = std::thread(&MetaCache::threadFunc, this);
+}
+
+void MetaCache::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running)
+            return;
+        running = false;
+    }
+    cv.notify_all();
+    if (thread.joinable())
+        thread.join();
+}
+
+bool MetaCache::get(std::string_view uri, TrackMeta& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto r = recent.find(uri);
+    if (r != recent.end()) {
+        out = recentItems[r->second];
+        return true;
+    }
+    auto it = index.find(uri);
+    if (it == index.end())
+        return false;
+    const char* rec = file.data() + it->second;
+    return decode(rec + RECORD_HEADER, read_u32(rec), out);
+}
+
+void MetaCache::put(const TrackMeta& meta) {
+    if (meta.uri.empty())
+        return;
+    TrackMeta known;
+    if (get(meta.uri, known) && same_meta(known, meta))
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto r = recent.find(meta.uri);
+        if (r != recent.end()) {
+            // keep the uri string: it backs the map key
+            TrackMeta& m = recentItems[r->second];
+            m.title = meta.title;
+            m.artists = meta.artists;
+            m.album = meta.album;
+            m.coverUrl = meta.coverUrl;
+            m.durationMs = meta.durationMs;
+        } else {
+            recentItems.push_back(meta);
+            recent.emplace(recentItems.back().uri, recentItems.size() - 1);
+        }
+        pending.push_back(meta);
+    }
+    cv.notify_one();
+}
+
+size_t MetaCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t n = index.size();
+    for (const auto& kv : recent)
+        if (!index.count(kv.first))
+            n++;
+    return n;
+}
+
+// Indexes the mapped file; returns where the last intact record ends
+// (0 if the header is missing or of another version)
+size_t MetaCache::scan(std::unordered_map<std::string_view, size_t>& found) const {
+    const char* d = file.data();
+    size_t n = file.size();
+    if (n < HEADER_SIZE || std::memcmp(d, FILE_MAGIC, 4) != 0 || read_u32(d + 4) != VERSION)
+        return 0;
+
+    size_t pos = HEADER_SIZE;
+    while (n - pos >= RECORD_HEADER) {
+        uint32_t size = read_u32(d + pos);
+        if (size > n - pos - RECORD_HEADER || fnv1a(d + pos + RECORD_HEADER, size) != read_u32(d + pos + 4))
+            break;
+        Reader r{d + pos + RECORD_HEADER, d + pos + RECORD_HEADER + size};
+        std::string_view uri = r.str();
+        if (!r.ok || uri.empty())
+            break;
+        found[uri] = pos;   // later records win
+        pos += RECORD_HEADER + size;
+    }
+    return pos;
+}
+
+// Maps and indexes the file, cuts a torn tail, and opens it for appending
+FILE* MetaCache::loadFile() {
+    std::unordered_map<std::string_view, size_t> found;
+    size_t validEnd = map_record_file(file, path, mutex, "[meta]", "a metadata cache", [&] {
+        found.clear();
+        return scan(found);
+    });
+
+    FILE* f = nullptr;
+    if (validEnd == 0) {
+        found.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            file.close();
+        }
+        f = std::fopen(path.c_str(), "wb");
+        if (f) {
+            uint32_t version = VERSION;
+            std::fwrite(FILE_MAGIC, 1, 4, f);
+            std::fwrite(&version, 4, 1, f);
+            std::fflush(f);
+        }
+    } else {
+        f = std::fopen(path.c_str(), "ab");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    index.swap(found);
+    return f;
+}
+
+void MetaCache::threadFunc() {
+    FILE* f = loadFile();
+    if (!f)
+        std::cout << "[meta] could not open " << path << ", nothing will be kept" << std::endl;
+    else
+        std::cout << "[meta] " << index.size() << " tracks cached" << std::endl;
+    ready = true;
+    if (onReady)
+        onReady();
+
+    std::string buf;
+    for (;;) {
+        std::vector<TrackMeta> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return !running || !pending.empty(); });
+            batch.swap(pending);
+        }
+        if (batch.empty())
+            break;   // stopped, everything written
+        if (!f)
+            continue;
+
+        // one write + flush per batch; a record cut short by a crash is
+        // dropped on the next start
+        buf.clear();
+        for (const TrackMeta& m : batch) {
+            size_t at = buf.size();
+            append_u32(buf, 0);
+            append_u32(buf, 0);
+            append_str(buf, m.uri);
+            append_str(buf, m.title);
+            append_str(buf, m.artists);
+            append_str(buf, m.album);
+            append_str(buf, m.coverUrl);
+            append_u32(buf, (uint32_t)m.durationMs);
+            uint32_t size = (uint32_t)(buf.size() - at - RECORD_HEADER);
+            uint32_t sum = fnv1a(buf.data() + at + RECORD_HEADER, size);
+            std::memcpy(&buf[at], &size, 4);
+            std::memcpy(&buf[at + 4], &sum, 4);
+        }
+        if (std::fwrite(buf.data(), 1, buf.size(), f) != buf.size() || std::fflush(f) != 0)
+            std::cout << "[meta] could not write " << path << std::endl;
+    }
+    if (f)
+        std::fclose(f);
+}
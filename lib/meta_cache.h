@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdio>
+#include <cstdint>
+
+#include "mapped_file.h"
+
+struct TrackMeta {
+    std::string uri;
+    std::string title;
+    std::string artists;
+    std::string album;
+    std::string coverUrl;
+    int durationMs = 0;
+};
+
+// ============================
+// Track metadata cache
+// ============================
+// What the player reported about every track it has played, kept across
+// runs so lists can show titles before (or without) playing the track.
+//
+// The file is append-only: a header, then one checksummed record per
+// change. A record for a URI supersedes the earlier ones. The worker maps
+// the file, indexes it (the index keys point into the mapping, nothing is
+// copied) and cuts off a torn tail from a crash; records put after that
+// live in memory and are appended by the worker in batches.
+class MetaCache {
+public:
+    explicit MetaCache(const std::string& path);
+    ~MetaCache();
+
+    // start() loads the file in the background; get() misses until then
+    void start();
+    void stop();
+    bool isReady() const { return ready; }
+
+    bool get(std::string_view uri, TrackMeta& out) const;
+    // Queues a write unless the cached entry is already the same
+    void put(const TrackMeta& meta);
+
+    size_t size() const;
+
+    // Called on the worker once the file is loaded (e.g. to wake the UI)
+    void setOnReady(std::function<void()> fn) { onReady = std::move(fn); }
+
+private:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 8;
+
+    void threadFunc();
+    FILE* loadFile();
+    size_t scan(std::unordered_map<std::string_view, size_t>& found) const;
+    static bool decode(const char* p, size_t size, TrackMeta& out);
+
+    std::string path;
+
+    mutable std::mutex mutex;
+    MappedFile file;
+    std::unordered_map<std::string_view, size_t> index;    // uri -> record offset in file
+    std::deque<TrackMeta> recentItems;                     // put since start
+    std::unordered_map<std::string_view, size_t> recent;   // uri -> recentItems slot
+    std::vector<TrackMeta> pending;                        // not written yet
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> ready{false};
+    std::condition_variable cv;
+    std::function<void()> onReady;
+};
@@ -0,0 +1,408 @@
+#include "play_history.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+// ============================
+// File format
+// ============================
+// "SPHL", version, then records, integers little-endian:
+//   play:  u8 1, u8 flags, u16 uri length, u32 listened ms, i64 start ms,
+//          uri, u32 FNV-1a of everything before it
+//   index: u8 2, 3 zero bytes, u32 plays, i64 min start, i64 max start,
+//          u64 offset of the block's first play, u32 FNV-1a
+// An index record follows every BLOCK_PLAYS plays and covers exactly them.
+
+static const char FILE_MAGIC[4] = {'S', 'P', 'H', 'L'};
+static constexpr uint8_t REC_PLAY = 1;
+static constexpr uint8_t REC_INDEX = 2;
+static constexpr uint8_t FLAG_SKIPPED = 1;
+static constexpr size_t PLAY_FIXED = 16;   // before the uri
+static constexpr size_t INDEX_SIZE = 36;
+
+template <typename T>
+static T read_as(const char* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+template <typename T>
+static void append_as(std::string& out, T v) {
+    out.append((const char*)&v, sizeof(T));
+}
+
+static void sync_file(FILE* f) {
+    std::fflush(f);
+#ifdef _WIN32
+    _commit(_fileno(f));
+#else
+    fsync(fileno(f));
+#endif
+}
+
+void PlayHistory::OpenBlock::extend(int64_t start) {
+    count++;
+    minStart = std::min(minStart, start);
+    maxStart = std::max(maxStart, start);
+}
+
+void PlayHistory::encodePlay(const Play& p, std::string& out) {
+    size_t at = out.size();
+    uint16_t n = (uint16_t)std::min<size_t>(p.uri.size(), 0xFFFF);
+    append_as<uint8_t>(out, REC_PLAY);
+    append_as<uint8_t>(out, p.skipped ? FLAG_SKIPPED : 0);
+    append_as<uint16_t>(out, n);
+    append_as<uint32_t>(out, p.listenedMs);
+    append_as<int64_t>(out, p.startMs);
+    out.append(p.uri.data(), n);
+    append_as<uint32_t>(out, fnv1a(out.data() + at, out.size() - at));
+}
+
+void PlayHistory::encodeIndex(const OpenBlock& b, std::string& out) {
+    size_t at = out.size();
+    append_as<uint32_t>(out, REC_INDEX);   // type + padding
+    append_as<uint32_t>(out, b.count);
+    append_as<int64_t>(out, b.minStart);
+    append_as<int64_t>(out, b.maxStart);
+    append_as<uint64_t>(out, (uint64_t)b.offset);
+    append_as<uint32_t>(out, fnv1a(out.data() + at, out.size() - at));
+}
+
+// ============================
+// PlayHistory
+// ============================
+PlayHistory::PlayHistory(const std::string& path_) : path(path_) {
+}
+
+PlayHistory::~PlayHistory() {
+    stop();
+}
+
+void PlayHistory::start() {
+    running = true;
+    thread = std::thread(&PlayHistory::threadFunc, this);
+}
+
+void PlayHistory::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running)
+            return;
+        running = false;
+    }
+    cv.notify_all();
+    if (thread.joinable())
+        thread.join();
+}
+
+void PlayHistory::add(const Play& play) {
+    if (play.uri.empty())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        recent.push_back(play);
+        pending.push_back(play);
+    }
+    cv.notify_one();
+}
+
+size_t PlayHistory::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t n = recent.size();
+    for (const Block& b : blocks)
+        n += b.count;
+    return n;
+}
+
+// Records were checked when the file was loaded
+void PlayHistory::decodeBlock(const Block& b, std::vector<Play>& out) const {
+    const char* d = file.data();
+    size_t pos = b.offset;
+    while (pos < b.end) {
+        uint16_t n = read_as<uint16_t>(d + pos + 2);
+        Play p;
+        p.skipped = (d[pos + 1] & FLAG_SKIPPED) != 0;
+        p.listenedMs = read_as<uint32_t>(d + pos + 4);
+        p.startMs = read_as<int64_t>(d + pos + 8);
+        p.uri.assign(d + pos + PLAY_FIXED, n);
+        out.push_back(std::move(p));
+        pos += PLAY_FIXED + n + 4;
+    }
+}
+
+size_t PlayHistory::last(size_t n, std::vector<Play>& out) const {
+    out.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = recent.size(); i-- > 0 && out.size() < n;)
+        out.push_back(recent[i]);
+
+    // whole blocks, newest first, until enough
+    std::vector<Play> block;
+    for (size_t b = blocks.size(); b-- > 0 && out.size() < n;) {
+        block.clear();
+        decodeBlock(blocks[b], block);
+        for (size_t i = block.size(); i-- > 0 && out.size() < n;)
+            out.push_back(std::move(block[i]));
+    }
+    return out.size();
+}
+
+size_t PlayHistory::between(int64_t fromMs, int64_t toMs, std::vector<Play>& out) const {
+    out.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Play> block;
+    for (const Block& b : blocks) {
+        if (b.maxStart < fromMs || b.minStart >= toMs)
+            continue;   // the index block says nothing in range
+        block.clear();
+        decodeBlock(b, block);
+        for (Play& p : block)
+            if (p.startMs >= fromMs && p.startMs < toMs)
+                out.push_back(std::move(p));
+    }
+    for (const Play& p : recent)
+        if (p.startMs >= fromMs && p.startMs < toMs)
+            out.push_back(p);
+    return out.size();
+}
+
+// Walks the mapped file; sealed blocks go to found, the plays after the
+// last one are described by open. Returns where the last intact record
+// ends (0 if the header is missing or of another version).
+size_t PlayHistory::scan(std::vector<Block>& found, OpenBlock& open) const {
+    const char* d = file.data();
+    size_t n = file.size();
+    if (n < HEADER_SIZE || std::memcmp(d, FILE_MAGIC, 4) != 0 || read_as<uint32_t>(d + 4) != VERSION)
+        return 0;
+
+    size_t pos = HEADER_SIZE;
+    open = OpenBlock();
+    while (pos < n) {
+        if (d[pos] == REC_PLAY) {
+            if (n - pos < PLAY_FIXED)
+                break;
+            size_t size = PLAY_FIXED + read_as<uint16_t>(d + pos + 2) + 4;
+            if (size > n - pos || fnv1a(d + pos, size - 4) != read_as<uint32_t>(d + pos + size - 4))
+                break;
+            open.extend(read_as<int64_t>(d + pos + 8));
+            pos += size;
+        } else if (d[pos] == REC_INDEX) {
+            if (n - pos < INDEX_SIZE || fnv1a(d + pos, INDEX_SIZE - 4) != read_as<uint32_t>(d + pos + INDEX_SIZE - 4))
+                break;
+            Block b;
+            b.count = read_as<uint32_t>(d + pos + 4);
+            b.minStart = read_as<int64_t>(d + pos + 8);
+            b.maxStart = read_as<int64_t>(d + pos + 16);
+            b.offset = (size_t)read_as<uint64_t>(d + pos + 24);
+            b.end = pos;
+            if (b.count != open.count || b.offset != open.offset || b.count == 0)
+                break;
+            found.push_back(b);
+            pos += INDEX_SIZE;
+            open = OpenBlock();
+            open.offset = pos;
+        } else {
+            break;
+        }
+    }
+    return pos;
+}
+
+// Maps and indexes the file, cuts a torn tail, and opens it for appending
+FILE* PlayHistory::loadFile(size_t& fileEnd) {
+    std::vector<Block> found;
+    OpenBlock open;
+    size_t validEnd = map_record_file(file, path, mutex, "[history]", "a play history", [&] {
+        found.clear();
+        return scan(found, open);
+    });
+
+    FILE* f = nullptr;
+    if (validEnd == 0) {
+        found.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            file.close();
+        }
+        open = OpenBlock();
+        f = std::fopen(path.c_str(), "wb");
+        if (f) {
+            uint32_t version = VERSION;
+            std::fwrite(FILE_MAGIC, 1, 4, f);
+            std::fwrite(&version, 4, 1, f);
+            sync_file(f);
+        }
+        fileEnd = HEADER_SIZE;
+    } else {
+        f = std::fopen(path.c_str(), "ab");
+        fileEnd = validEnd;
+    }
+
+    // the unsealed tail is decoded once; it joins the plays added since
+    std::vector<Play> tail;
+    if (open.count > 0)
+        decodeBlock(Block{open.minStart, open.maxStart, open.offset, validEnd, open.count}, tail);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    blocks.swap(found);
+    recent.insert(recent.begin(), tail.begin(), tail.end());
+    openBlock = open;
+    return f;
+}
+
+void PlayHistory::threadFunc() {
+    size_t fileEnd = 0;
+    FILE* f = loadFile(fileEnd);
+    if (!f)
+        std::cout << "[history] could not open " << path << ", plays will not be kept" << std::endl;
+    else
+        std::cout << "[history] " << size() << " plays" << std::endl;
+    ready = true;
+    if (onReady)
+        onReady();
+
+    // plays are written as they come, but synced to disk at most every
+    // SYNC_DELAY (and on stop)
+    bool unsynced = false;
+    std::chrono::steady_clock::time_point syncDue;
+    std::string buf;
+    for (;;) {
+        std::vector<Play> batch;
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto wake = [&] { return !running || !pending.empty(); };
+            if (unsynced)
+                cv.wait_until(lock, syncDue, wake);
+            else
+                cv.wait(lock, wake);
+            batch.swap(pending);
+            stopping = !running;
+        }
+
+        if (!batch.empty() && f) {
+            buf.clear();
+            for (const Play& p : batch) {
+                encodePlay(p, buf);
+                openBlock.extend(p.startMs);
+                if (openBlock.count == BLOCK_PLAYS) {
+                    encodeIndex(openBlock, buf);
+                    openBlock = OpenBlock();
+                    openBlock.offset = fileEnd + buf.size();
+                }
+            }
+            if (std::fwrite(buf.data(), 1, buf.size(), f) != buf.size() || std::fflush(f) != 0)
+                std::cout << "[history] could not write " << path << std::endl;
+            fileEnd += buf.size();
+            if (!unsynced) {
+                unsynced = true;
+                syncDue = std::chrono::steady_clock::now() + SYNC_DELAY;
+            }
+        }
+        if (unsynced && (stopping || std::chrono::steady_clock::now() >= syncDue)) {
+            sync_file(f);
+            unsynced = false;
+        }
+        if (stopping && batch.empty())
+            break;
+    }
+    if (f)
+        std::fclose(f);
+}
+
+// ============================
+// Benchmark
+// ============================
+void play_history_benchmark(int plays) {
+    using clock = std::chrono::steady_clock;
+    auto ms_since = [](clock::time_point t) { return std::chrono::duration<double, std::milli>(clock::now() - t).count(); };
+
+    if (plays <= 0)
+        plays = 200000;
+    std::mt19937 rng(7);
+
+    // plays spread over five years, 3 minutes apart within listening
+    // sessions, from a library of 5000 tracks
+    const int64_t day = 86400000;
+    const int64_t begin = 1600000000000LL;
+    const int64_t span = 5 * 365 * day;
+    std::vector<std::string> library(5000);
+    for (size_t i = 0; i < library.size(); i++)
+        library[i] = "spotify:track:" + std::to_string(1000000000000000000ULL + i * 7919) + "xxxx";
+
+    std::string file = "spotamp_history_bench.log";
+    std::remove(file.c_str());
+
+    double writeMs;
+    {
+        PlayHistory h(file);
+        h.start();
+        while (!h.isReady())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        int64_t t = begin;
+        int64_t step = span / plays;
+        auto t0 = clock::now();
+        for (int i = 0; i < plays; i++) {
+            Play p;
+            p.uri = library[rng() % library.size()];
+            p.startMs = t;
+            p.listenedMs = 30000 + rng() % 200000;
+            p.skipped = rng() % 5 == 0;
+            h.add(p);
+            t += step / 2 + (int64_t)(rng() % (uint32_t)std::max<int64_t>(1, step));
+        }
+        h.stop();
+        writeMs = ms_since(t0);
+    }
+
+    PlayHistory h(file);
+    auto t0 = clock::now();
+    h.start();
+    while (!h.isReady())
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    double loadMs = ms_since(t0);
+
+    std::vector<Play> out;
+    auto time_queries = [&](const char* name, int64_t length, int runs) {
+        double total = 0, worst = 0;
+        size_t found = 0;
+        for (int i = 0; i < runs; i++) {
+            int64_t from = begin + (int64_t)(rng() % (uint64_t)(span - length));
+            auto q0 = clock::now();
+            found += h.between(from, from + length, out);
+            double ms = ms_since(q0);
+            total += ms;
+            worst = std::max(worst, ms);
+        }
+        std::printf("  %-14s avg %.3f ms, worst %.3f ms, %.0f plays each\n", name, total / runs, worst,
+                    (double)found / runs);
+    };
+
+    std::printf("play history: %d plays over 5 years, %.1f MB\n", plays,
+                std::filesystem::file_size(file) / 1048576.0);
+    std::printf("  write %.0f ms, load %.1f ms\n", writeMs, loadMs);
+
+    double lastTotal = 0;
+    for (int i = 0; i < 100; i++) {
+        auto q0 = clock::now();
+        h.last(100, out);
+        lastTotal += ms_since(q0);
+    }
+    std::printf("  %-14s avg %.3f ms\n", "last 100", lastTotal / 100);
+    time_queries("one day", day, 200);
+    time_queries("one month", 30 * day, 100);
+    time_queries("one year", 365 * day, 10);
+
+    h.stop();
+    std::remove(file.c_str());
+}
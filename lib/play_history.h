@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+#include "mapped_file.h"
+
+struct Play {
+    std::string uri;
+    int64_t startMs = 0;       // unix time
+    uint32_t listenedMs = 0;   // time actually played, pauses excluded
+    bool skipped = false;
+};
+
+// ============================
+// Play history log
+// ============================
+// Every play, appended to a binary log that is never rewritten. Records are
+// checksummed; after every BLOCK_PLAYS plays an index block follows with the
+// block's time range and offset, so range queries skip whole blocks and
+// "last N" only decodes the newest ones.
+//
+// The worker maps the file once at start (cutting off a torn tail) and
+// appends new plays in batches, syncing to disk at most every SYNC_DELAY.
+// Queries read the mapped blocks plus the plays added since start.
+class PlayHistory {
+public:
+    explicit PlayHistory(const std::string& path);
+    ~PlayHistory();
+
+    // start() loads the file in the background; queries see nothing until then
+    void start();
+    void stop();
+    bool isReady() const { return ready; }
+
+    void add(const Play& play);
+
+    // Newest first, at most n
+    size_t last(size_t n, std::vector<Play>& out) const;
+    // Plays started in [fromMs, toMs), oldest first
+    size_t between(int64_t fromMs, int64_t toMs, std::vector<Play>& out) const;
+
+    size_t size() const;
+
+    // Called on the worker once the file is loaded (e.g. to wake the UI)
+    void setOnReady(std::function<void()> fn) { onReady = std::move(fn); }
+
+private:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 8;
+    static constexpr uint32_t BLOCK_PLAYS = 256;
+    static constexpr std::chrono::milliseconds SYNC_DELAY{2000};
+
+    // one sealed block of plays inside the mapping
+    struct Block {
+        int64_t minStart, maxStart;
+        size_t offset;   // first record
+        size_t end;      // its index block
+        uint32_t count;
+    };
+
+    // where the block being filled stands (worker only)
+    struct OpenBlock {
+        size_t offset = HEADER_SIZE;
+        uint32_t count = 0;
+        int64_t minStart = INT64_MAX;
+        int64_t maxStart = INT64_MIN;
+        void extend(int64_t start);
+    };
+
+    void threadFunc();
+    FILE* loadFile(size_t& fileEnd);
+    size_t scan(std::vector<Block>& found, OpenBlock& open) const;
+    void decodeBlock(const Block& b, std::vector<Play>& out) const;
+    static void encodePlay(const Play& p, std::string& out);
+    static void encodeIndex(const OpenBlock& b, std::string& out);
+
+    std::string path;
+
+    mutable std::mutex mutex;
+    MappedFile file;
+    std::vector<Block> blocks;   // sealed blocks in the mapping, in log order
+    std::vector<Play> recent;    // plays after them: the open tail at start + added
+    std::vector<Play> pending;   // not written yet
+    OpenBlock openBlock;
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> ready{false};
+    std::condition_variable cv;
+    std::function<void()> onReady;
+};
+
+// spotamp --bench-history [plays]: load and query latency over a synthetic
+// log of several years
+void play_history_benchmark(int plays);
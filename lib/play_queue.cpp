@@ -0,0 +1,160 @@
+#include "play_queue.h"
+#include "mapped_file.h"
+
+#include <fstream>
+#include <iostream>
+
+PlayQueue::PlayQueue(const std::string& path_)
+    : path(path_)
+{
+}
+
+bool PlayQueue::queueable(const std::string& uri) {
+    return uri.compare(0, 14, "spotify:track:") == 0 || uri.compare(0, 16, "spotify:episode:") == 0;
+}
+
+bool PlayQueue::load() {
+    std::ifstream in(path);
+    if (!in)
+        return true; // nothing saved yet
+
+    std::lock_guard<std::mutex> lock(mutex);
+    uris.clear();
+    index.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (queueable(line) && index.insert(line).second)
+            uris.push_back(line);
+    }
+    changes++;
+    return !in.bad();
+}
+
+bool PlayQueue::save() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return saveLocked();
+}
+
+bool PlayQueue::saveLocked() const {
+    // write a temp file and rename, so a crash never leaves half a queue
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out)
+            return false;
+        for (const std::string& uri : uris)
+            out << uri << '\n';
+        if (!out.flush())
+            return false;
+    }
+    return replace_file(tmp, path);
+}
+
+// under the lock
+void PlayQueue::changed() {
+    changes++;
+    if (!saveLocked())
+        std::cout << "[queue] could not save " << path << std::endl;
+}
+
+size_t PlayQueue::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return uris.size();
+}
+
+bool PlayQueue::empty() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return uris.empty();
+}
+
+std::string PlayQueue::at(size_t i) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return i < uris.size() ? uris[i] : std::string();
+}
+
+std::vector<std::string> PlayQueue::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return uris;
+}
+
+bool PlayQueue::contains(const std::string& uri) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.count(uri) != 0;
+}
+
+bool PlayQueue::add(const std::string& uri) {
+    if (!queueable(uri))
+        return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!index.insert(uri).second)
+        return false;
+    uris.push_back(uri);
+    changed();
+    return true;
+}
+
+size_t PlayQueue::addMany(const std::vector<std::string>& list) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t added = 0;
+    for (const std::string& uri : list) {
+        if (!queueable(uri) || !index.insert(uri).second)
+            continue;
+        uris.push_back(uri);
+        added++;
+    }
+    if (added > 0)
+        changed();
+    return added;
+}
+
+void PlayQueue::remove(size_t i) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (i >= uris.size())
+        return;
+    index.erase(uris[i]);
+    uris.erase(uris.begin() + i);
+    changed();
+}
+
+void PlayQueue::move(size_t from, size_t to) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (from >= uris.size() || to >= uris.size() || from == to)
+        return;
+    std::string uri = std::move(uris[from]);
+    uris.erase(uris.begin() + from);
+    uris.insert(uris.begin() + to, std::move(uri));
+    changed();
+}
+
+void PlayQueue::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (uris.empty())
+        return;
+    uris.clear();
+    index.clear();
+    changed();
+}
+
+std::string PlayQueue::takeNext() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (uris.empty())
+        return std::string();
+    std::string uri = std::move(uris.front());
+    uris.erase(uris.begin());
+    index.erase(uri);
+    changed();
+    return uri;
+}
+
+bool PlayQueue::pushFront(const std::string& uri) {
+    if (!queueable(uri))
+        return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!index.insert(uri).second)
+        return false;
+    uris.insert(uris.begin(), uri);
+    changed();
+    return true;
+}
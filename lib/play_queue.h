@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// ============================
+// Client-side play queue
+// ============================
+// Ordered list of Spotify URIs kept by SpotAmp itself. The head is handed to
+// go-librespot's own queue shortly before the current track ends, so the
+// transition is done by librespot (gapless) instead of by a load from us.
+// Persisted as one URI per line. Only tracks and episodes are queued (that
+// is all librespot's queue takes), each at most once. The UI edits it while
+// the queue feeder takes the head, so every call locks; at() returns a copy
+// and an index may be stale by the time it is used.
+class PlayQueue {
+public:
+    explicit PlayQueue(const std::string& path);
+
+    // false if the file could not be read (a missing file is an empty queue)
+    bool load();
+    bool save() const;
+
+    size_t size() const;
+    bool empty() const;
+    // empty string past the end
+    std::string at(size_t i) const;
+    // A copy of the whole queue, for drawing
+    std::vector<std::string> snapshot() const;
+    // Bumped by every change; a snapshot is current while this is unchanged
+    uint64_t version() const { return changes.load(std::memory_order_acquire); }
+
+    bool contains(const std::string& uri) const;
+
+    // spotify:track: / spotify:episode:
+    static bool queueable(const std::string& uri);
+
+    // false if not queueable or already queued
+    bool add(const std::string& uri);
+    // Appends in order, skipping duplicates and anything not queueable;
+    // saves once. Returns how many were added.
+    size_t addMany(const std::vector<std::string>& list);
+    void remove(size_t i);
+    void move(size_t from, size_t to);   // to = index before the move
+    void clear();
+
+    // Removes and returns the head; empty string when the queue is empty
+    std::string takeNext();
+    // Puts a taken head back; false if not queueable or already queued
+    bool pushFront(const std::string& uri);
+
+private:
+    bool saveLocked() const;
+    void changed();
+
+    mutable std::mutex mutex;
+    std::string path;
+    std::vector<std::string> uris;
+    std::unordered_set<std::string> index;
+    std::atomic<uint64_t> changes{0};
+};
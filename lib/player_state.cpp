@@ -0,0 +1,47 @@
+#include "player_state.h"
+
+uint32_t player_state_diff(const PlayerState& a, const PlayerState& b) {
+    uint32_t mask = 0;
+    if (a.trackUri != b.trackUri || a.trackName != b.trackName || a.artistName != b.artistName ||
+        a.albumName != b.albumName || a.coverUrl != b.coverUrl)
+        mask |= FIELD_TRACK;
+    // positionTime alone is not a change: a paused track re-reported at the
+    // same position must not look like news
+    if (a.positionMs != b.positionMs || a.seekKnown != b.seekKnown)
+        mask |= FIELD_POSITION;
+    if (a.durationMs != b.durationMs)
+        mask |= FIELD_DURATION;
+    if (a.volume != b.volume || a.volumeMax != b.volumeMax || a.volumeKnown != b.volumeKnown)
+        mask |= FIELD_VOLUME;
+    if (a.shuffle != b.shuffle || a.shuffleKnown != b.shuffleKnown)
+        mask |= FIELD_SHUFFLE;
+    if (a.paused != b.paused)
+        mask |= FIELD_PAUSED;
+    return mask;
+}
+
+PlayerStateStore::PlayerStateStore()
+    : current(std::make_shared<PlayerState>())
+{
+}
+
+uint32_t PlayerStateStore::update(const std::function<void(PlayerState&)>& fn) {
+    uint32_t mask;
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        auto old = std::atomic_load(&current);
+        auto next = std::make_shared<PlayerState>(*old);
+        fn(*next);
+
+        mask = player_state_diff(*old, *next);
+        if (mask == 0)
+            return 0;
+
+        next->version = old->version + 1;
+        std::atomic_store(&current, std::shared_ptr<const PlayerState>(std::move(next)));
+        publishedVersion.store(old->version + 1, std::memory_order_release);
+    }
+    if (onPublish)
+        onPublish();
+    return mask;
+}
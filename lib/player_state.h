@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+
+// ============================
+// Player state snapshot
+// ============================
+// Server-side truth about playback, as last reported by go-librespot.
+struct PlayerState {
+    uint64_t version = 0;
+
+    std::string trackUri;
+    std::string trackName  = "N/A";
+    std::string artistName = "N/A";
+    std::string albumName;
+    std::string coverUrl;
+
+    int positionMs = 0;
+    int durationMs = 0;
+    std::chrono::steady_clock::time_point positionTime; // when positionMs was reported
+    uint64_t positionFrames = 0;                        // audio clock at that moment
+    bool seekKnown = false;
+
+    int volume    = 0;
+    int volumeMax = 100;
+    bool volumeKnown = false;
+
+    bool shuffle = false;
+    bool shuffleKnown = false;
+
+    bool paused = true;
+};
+
+// Bit mask of what differs between two snapshots
+enum PlayerField : uint32_t {
+    FIELD_TRACK    = 1 << 0, // uri, name, artists, album, cover
+    FIELD_POSITION = 1 << 1,
+    FIELD_DURATION = 1 << 2,
+    FIELD_VOLUME   = 1 << 3,
+    FIELD_SHUFFLE  = 1 << 4,
+    FIELD_PAUSED   = 1 << 5
+};
+
+uint32_t player_state_diff(const PlayerState& a, const PlayerState& b);
+
+// ============================
+// Versioned state store
+// ============================
+// RCU-style handoff: writers (control lane, event stream) copy the current
+// snapshot, modify the copy and publish it with one atomic pointer swap;
+// readers grab the current pointer without blocking writers and keep a
+// consistent snapshot for as long as they hold it. The version only
+// increments when a field actually changed.
+class PlayerStateStore {
+public:
+    PlayerStateStore();
+
+    using Snapshot = std::shared_ptr<const PlayerState>;
+
+    Snapshot snapshot() const { return std::atomic_load(&current); }
+    uint64_t version() const { return publishedVersion.load(std::memory_order_acquire); }
+
+    // Runs fn on a private copy and publishes it if anything changed.
+    // Returns the changed-field mask.
+    uint32_t update(const std::function<void(PlayerState&)>& fn);
+
+    // Called (on the writer's thread) after each publish, e.g. to wake the UI
+    void setOnPublish(std::function<void()> fn) { onPublish = std::move(fn); }
+
+private:
+    std::mutex writerMutex;
+    std::shared_ptr<const PlayerState> current;
+    std::atomic<uint64_t> publishedVersion{0};
+    std::function<void()> onPublish;
+};
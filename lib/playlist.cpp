@@ -0,0 +1,328 @@
+#include "playlist.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+// ============================
+// Playlist
+// ============================
+Playlist::Playlist(const std::string& path_)
+    : path(path_),
+      pool(std::make_shared<StringPool>())
+{
+}
+
+Playlist::~Playlist() {
+    stop();
+}
+
+void Playlist::start() {
+    running = true;
+    thread = std::thread(&Playlist::threadFunc, this);
+    refresh(false);
+}
+
+void Playlist::stop() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        if (!running)
+            return;
+        running = false;
+    }
+    jobCv.notify_all();
+    if (thread.joinable())
+        thread.join();
+}
+
+// file: uri \t title \t artist \t duration per line
+bool Playlist::load() {
+    std::ifstream in(path);
+    if (!in)
+        return true; // nothing saved yet
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        std::string_view f[4];
+        size_t start = 0;
+        for (int i = 0; i < 4; i++) {
+            size_t tab = i < 3 ? line.find('\t', start) : std::string::npos;
+            f[i] = std::string_view(line).substr(start, tab == std::string::npos ? std::string::npos : tab - start);
+            if (tab == std::string::npos)
+                break;
+            start = tab + 1;
+        }
+        if (f[0].empty())
+            continue;
+
+        StringPool::Handle u = pool->intern(f[0]);
+        if (!uriSet.insert(u).second)
+            continue;
+        cols.uri.push_back(u);
+        cols.title.push_back(pool->intern(f[1]));
+        cols.artist.push_back(pool->intern(f[2]));
+        cols.duration.push_back(f[3].empty() ? 0 : std::atoi(std::string(f[3]).c_str()));
+    }
+    structureVersion++;
+    refresh(false);
+    return !in.bad();
+}
+
+bool Playlist::add(std::string_view uri) {
+    if (uri.empty())
+        return false;
+    StringPool::Handle u = pool->intern(uri);
+    if (!uriSet.insert(u).second)
+        return false;
+    cols.uri.push_back(u);
+    cols.title.push_back(0);
+    cols.artist.push_back(0);
+    cols.duration.push_back(0);
+    refresh(true);
+    return true;
+}
+
+size_t Playlist::addMany(const std::vector<std::string>& uris) {
+    size_t added = 0;
+    for (const std::string& s : uris) {
+        if (s.empty())
+            continue;
+        StringPool::Handle u = pool->intern(s);
+        if (!uriSet.insert(u).second)
+            continue;
+        cols.uri.push_back(u);
+        cols.title.push_back(0);
+        cols.artist.push_back(0);
+        cols.duration.push_back(0);
+        added++;
+    }
+    if (added > 0)
+        refresh(true);
+    return added;
+}
+
+void Playlist::remove(uint32_t row) {
+    if (row >= cols.uri.size())
+        return;
+    uriSet.erase(cols.uri[row]);
+    cols.uri.erase(cols.uri.begin() + row);
+    cols.title.erase(cols.title.begin() + row);
+    cols.artist.erase(cols.artist.begin() + row);
+    cols.duration.erase(cols.duration.begin() + row);
+    structureVersion++;
+    refresh(true);
+}
+
+void Playlist::clear() {
+    cols = Columns();
+    uriSet.clear();
+    // a fresh pool; the worker may still hold the old one for a moment
+    pool = std::make_shared<StringPool>();
+    structureVersion++;
+    refresh(true);
+}
+
+void Playlist::setMeta(std::string_view uri, std::string_view title, std::string_view artist, int durationMs) {
+    // tracks that are not in the playlist must not grow the pool
+    StringPool::Handle u;
+    if (!pool->find(uri, u) || !uriSet.count(u))
+        return;
+
+    StringPool::Handle t = pool->intern(title);
+    StringPool::Handle a = pool->intern(artist);
+    bool changed = false;
+    for (size_t i = 0; i < cols.uri.size(); i++) {
+        if (cols.uri[i] != u)
+            continue;
+        if (cols.title[i] != t || cols.artist[i] != a || cols.duration[i] != durationMs) {
+            cols.title[i] = t;
+            cols.artist[i] = a;
+            cols.duration[i] = durationMs;
+            changed = true;
+        }
+    }
+    // titles are read live; only the order / filter result may be stale
+    if (changed)
+        refresh(true);
+}
+
+size_t Playlist::fillMissing(const MetaLookup& lookup, size_t firstRow) {
+    size_t filled = 0;
+    std::string title, artist;
+    for (size_t i = firstRow; i < cols.uri.size(); i++) {
+        if (cols.title[i] != 0)
+            continue;
+        int durationMs = 0;
+        title.clear();
+        artist.clear();
+        if (!lookup(pool->get(cols.uri[i]), title, artist, durationMs) || title.empty())
+            continue;
+        cols.title[i] = pool->intern(title);
+        cols.artist[i] = pool->intern(artist);
+        cols.duration[i] = durationMs;
+        filled++;
+    }
+    if (filled > 0)
+        refresh(true);
+    return filled;
+}
+
+void Playlist::setOrder(SortKey key, bool ascending) {
+    if (key == sortKey && ascending == sortAscending)
+        return;
+    sortKey = key;
+    sortAscending = ascending;
+    refresh(false);
+}
+
+void Playlist::setFilter(const std::string& text) {
+    if (text == filter)
+        return;
+    filter = text;
+    refresh(false);
+}
+
+// Hands the worker a copy of the columns; a newer request replaces an
+// unstarted one (a pending save is kept)
+void Playlist::refresh(bool save) {
+    std::unique_ptr<Job> job(new Job{cols, pool, sortKey, sortAscending, filter, structureVersion, save});
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        if (pending && pending->save)
+            job->save = true;
+        pending = std::move(job);
+    }
+    jobCv.notify_one();
+}
+
+void Playlist::threadFunc() {
+    // saves are held back until edits pause for SAVE_DELAY (or stop()), so
+    // a burst of edits rewrites the file once
+    std::unique_ptr<Job> unsaved;
+    for (;;) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            auto ready = [&] { return !running || pending; };
+            if (unsaved)
+                jobCv.wait_for(lock, SAVE_DELAY, ready);
+            else
+                jobCv.wait(lock, ready);
+            job = std::move(pending);
+        }
+
+        if (job) {
+            buildView(*job);
+            if (onReady)
+                onReady();
+            if (job->save || unsaved)
+                unsaved = std::move(job);
+            continue;
+        }
+
+        if (unsaved) {
+            if (!saveFile(*unsaved))
+                std::cout << "[playlist] could not save " << path << std::endl;
+            unsaved.reset();
+        }
+        if (!running)
+            return;
+    }
+}
+
+static char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+// ASCII case-insensitive substring; needle is already lowercase
+static bool contains(std::string_view hay, const std::string& needle) {
+    if (needle.size() > hay.size())
+        return false;
+    for (size_t i = 0; i + needle.size() <= hay.size(); i++) {
+        size_t k = 0;
+        while (k < needle.size() && lower(hay[i + k]) == needle[k])
+            k++;
+        if (k == needle.size())
+            return true;
+    }
+    return false;
+}
+
+static int compare_text(std::string_view a, std::string_view b) {
+    size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; i++) {
+        char x = lower(a[i]), y = lower(b[i]);
+        if (x != y)
+            return x < y ? -1 : 1;
+    }
+    return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+void Playlist::buildView(const Job& job) {
+    const Columns& c = job.cols;
+    const StringPool& p = *job.pool;
+    auto v = std::make_shared<View>();
+
+    // ---- Filter ----
+    std::string needle = job.filter;
+    for (char& ch : needle)
+        ch = lower(ch);
+
+    uint32_t n = (uint32_t)c.uri.size();
+    v->rows.reserve(n);
+    for (uint32_t i = 0; i < n; i++) {
+        if (needle.empty() || contains(p.get(c.title[i]), needle) ||
+            contains(p.get(c.artist[i]), needle) || contains(p.get(c.uri[i]), needle))
+            v->rows.push_back(i);
+    }
+
+    // ---- Sort (stable, so ties keep playlist order) ----
+    auto text_key = [&](const std::vector<StringPool::Handle>& col) {
+        std::stable_sort(v->rows.begin(), v->rows.end(), [&](uint32_t a, uint32_t b) {
+            int r = compare_text(p.get(col[a]), p.get(col[b]));
+            return job.ascending ? r < 0 : r > 0;
+        });
+    };
+    switch (job.key) {
+        case SORT_TITLE:  text_key(c.title);  break;
+        case SORT_ARTIST: text_key(c.artist); break;
+        case SORT_URI:    text_key(c.uri);    break;
+        case SORT_DURATION:
+            std::stable_sort(v->rows.begin(), v->rows.end(), [&](uint32_t a, uint32_t b) {
+                return job.ascending ? c.duration[a] < c.duration[b] : c.duration[a] > c.duration[b];
+            });
+            break;
+        default:
+            break;
+    }
+
+    v->structure = job.structure;
+    v->seq = ++viewSeq;
+    std::atomic_store(&published, std::shared_ptr<const View>(std::move(v)));
+}
+
+bool Playlist::saveFile(const Job& job) const {
+    // temp file + rename, so a crash never leaves half a playlist
+    std::string tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f)
+        return false;
+
+    const Columns& c = job.cols;
+    const StringPool& p = *job.pool;
+    for (size_t i = 0; i < c.uri.size(); i++) {
+        std::string_view u = p.get(c.uri[i]), t = p.get(c.title[i]), a = p.get(c.artist[i]);
+        std::fprintf(f, "%.*s\t%.*s\t%.*s\t%d\n", (int)u.size(), u.data(), (int)t.size(), t.data(),
+                     (int)a.size(), a.data(), c.duration[i]);
+    }
+    bool ok = std::fclose(f) == 0;
+    if (!ok)
+        return false;
+    return replace_file(tmp, path);
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_set>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+#include "string_pool.h"
+
+// ============================
+// Playlist store
+// ============================
+// Winamp-style playlist of Spotify URIs with cached titles, kept as
+// struct-of-arrays columns of pool handles (16 bytes per entry). Edits
+// happen on the UI thread; sorting, filtering and saving run on a worker
+// that works on a copy of the columns and publishes a finished row order
+// with one atomic pointer swap, so the UI never waits on them. The file is
+// rewritten once edits settle.
+class Playlist {
+public:
+    enum SortKey { SORT_NONE, SORT_TITLE, SORT_ARTIST, SORT_URI, SORT_DURATION };
+
+    // Rows (column indices) in display order for one sort / filter setting
+    struct View {
+        std::vector<uint32_t> rows;
+        uint64_t structure;   // Playlist::structure() the rows were made for
+        uint64_t seq;         // increments with every published view
+    };
+
+    explicit Playlist(const std::string& path);
+    ~Playlist();
+
+    void start();
+    void stop();
+
+    bool load();
+
+    size_t size() const { return cols.uri.size(); }
+
+    // Duplicates are refused (as in the queue)
+    bool add(std::string_view uri);
+    size_t addMany(const std::vector<std::string>& uris);
+    void remove(uint32_t row);
+    void clear();
+
+    // Caches display metadata for every entry with this URI
+    void setMeta(std::string_view uri, std::string_view title, std::string_view artist, int durationMs);
+    // Asks lookup for every entry from firstRow on without a title (one
+    // pass, one refresh); lookup returns false when it knows nothing about
+    // the URI
+    using MetaLookup = std::function<bool(std::string_view uri, std::string& title, std::string& artist, int& durationMs)>;
+    size_t fillMissing(const MetaLookup& lookup, size_t firstRow = 0);
+
+    std::string_view uri(uint32_t row) const    { return pool->get(cols.uri[row]); }
+    std::string_view title(uint32_t row) const  { return pool->get(cols.title[row]); }
+    std::string_view artist(uint32_t row) const { return pool->get(cols.artist[row]); }
+    int duration(uint32_t row) const            { return cols.duration[row]; }
+
+    void setOrder(SortKey key, bool ascending);
+    void setFilter(const std::string& text);
+    const std::string& getFilter() const { return filter; }
+
+    // Latest finished view; stale (structure() mismatch) right after a removal
+    std::shared_ptr<const View> view() const { return std::atomic_load(&published); }
+    // bumped when rows are removed / reordered (old views' indices are invalid)
+    uint64_t structure() const { return structureVersion; }
+
+    // Called on the worker after a view was published (e.g. to wake the UI)
+    void setOnReady(std::function<void()> fn) { onReady = std::move(fn); }
+
+private:
+    struct Columns {
+        std::vector<StringPool::Handle> uri;
+        std::vector<StringPool::Handle> title;
+        std::vector<StringPool::Handle> artist;
+        std::vector<int32_t> duration;
+    };
+
+    struct Job {
+        Columns cols;
+        std::shared_ptr<const StringPool> pool;
+        SortKey key;
+        bool ascending;
+        std::string filter;
+        uint64_t structure;
+        bool save;
+    };
+
+    static constexpr std::chrono::milliseconds SAVE_DELAY{1000};
+
+    void refresh(bool save);
+    void threadFunc();
+    void buildView(const Job& job);
+    bool saveFile(const Job& job) const;
+
+    std::string path;
+
+    // UI thread state
+    std::shared_ptr<StringPool> pool;
+    Columns cols;
+    std::unordered_set<StringPool::Handle> uriSet;
+    SortKey sortKey = SORT_NONE;
+    bool sortAscending = true;
+    std::string filter;
+    uint64_t structureVersion = 1;
+
+    // worker
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::mutex jobMutex;
+    std::condition_variable jobCv;
+    std::unique_ptr<Job> pending;
+    uint64_t viewSeq = 0;
+
+    std::shared_ptr<const View> published;
+    std::function<void()> onReady;
+};
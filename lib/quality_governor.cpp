@@ -0,0 +1,129 @@
+#include "quality_governor.h"
+#include "audio_engine.h"
+#include "audio_fft.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+static constexpr int WINDOW_MS = 1000;
+
+QualityGovernor::QualityGovernor(AudioFFT* fft_, int baseFps_)
+    : fft(fft_),
+      baseFps(baseFps_),
+      baseFftSize(fft_ ? fft_->getFftSize() : 0),
+      baseHopMs(fft_ ? fft_->getHopMs() : 0),
+      windowStart(std::chrono::steady_clock::now()),
+      windowCpuStart(processCpuSeconds())
+{
+    lastUnderruns = audio_get_stats().underruns;
+}
+
+const char* QualityGovernor::levelName(int level) {
+    switch (level) {
+        case LEVEL_FULL:          return "full";
+        case LEVEL_FFT_RATE:      return "fft rate";
+        case LEVEL_FFT_SIZE:      return "fft size";
+        case LEVEL_DISPLAY_FPS:   return "display fps";
+        case LEVEL_ANALYZERS_OFF: return "analyzers off";
+        default:                  return "?";
+    }
+}
+
+int QualityGovernor::getTargetFps() const {
+    return level >= LEVEL_DISPLAY_FPS ? baseFps / 2 : baseFps;
+}
+
+double QualityGovernor::processCpuSeconds() const {
+#ifdef _WIN32
+    FILETIME create, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &create, &exit, &kernel, &user))
+        return 0.0;
+    auto to100ns = [](const FILETIME& f) {
+        return ((unsigned long long)f.dwHighDateTime << 32) | f.dwLowDateTime;
+    };
+    return (to100ns(kernel) + to100ns(user)) * 1e-7;
+#else
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0.0;
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 +
+           ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+#endif
+}
+
+void QualityGovernor::frameDone(double frameWorkMs) {
+    frameMsSum += frameWorkMs;
+    frames++;
+    update();
+}
+
+void QualityGovernor::update() {
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(now - windowStart).count() >= WINDOW_MS)
+        evaluate();
+}
+
+void QualityGovernor::evaluate() {
+    auto now = std::chrono::steady_clock::now();
+    double wall = std::chrono::duration<double>(now - windowStart).count();
+    double cpu = processCpuSeconds();
+
+    AudioStats audio = audio_get_stats();
+
+    metrics.audioLoad  = audio.callbackLoad;
+    metrics.underruns  = audio.underruns - lastUnderruns;
+    metrics.frameMs    = frames > 0 ? (float)(frameMsSum / frames) : 0.0f;
+    metrics.processCpu = wall > 0.0 ? (float)((cpu - windowCpuStart) / wall) : 0.0f;
+
+    lastUnderruns  = audio.underruns;
+    windowStart    = now;
+    windowCpuStart = cpu;
+    frameMsSum     = 0.0;
+    frames         = 0;
+
+    // judged against the full-rate interval, otherwise halving the FPS would
+    // immediately look like "pressure cleared" and the level would oscillate
+    float frameBudgetMs = 1000.0f / baseFps;
+    bool pressure =
+        metrics.audioLoad  > maxAudioLoad ||
+        metrics.frameMs    > frameBudgetMs * maxFrameShare ||
+        metrics.processCpu > maxProcessCpu;
+
+    if (pressure) {
+        clear = 0;
+        if (++pressured >= downWindows && level < LEVEL_COUNT - 1) {
+            apply(level + 1);
+            metrics.stepDowns++;
+            pressured = 0;
+        }
+    } else {
+        pressured = 0;
+        if (++clear >= upWindows && level > LEVEL_FULL) {
+            apply(level - 1);
+            metrics.stepUps++;
+            clear = 0;
+        }
+    }
+}
+
+void QualityGovernor::apply(int newLevel) {
+    std::cout << "[governor] " << levelName(level) << " -> " << levelName(newLevel)
+              << " (audio load " << metrics.audioLoad
+              << ", frame " << metrics.frameMs << " ms"
+              << ", cpu " << metrics.processCpu * 100.0f << "%)" << std::endl;
+
+    level = newLevel;
+    metrics.level = level;
+
+    if (!fft)
+        return;
+
+    fft->setHopMs(level >= LEVEL_FFT_RATE ? baseHopMs * 2 : baseHopMs);
+    fft->setFftSize(level >= LEVEL_FFT_SIZE ? baseFftSize / 2 : baseFftSize);
+    fft->setAnalysisEnabled(level < LEVEL_ANALYZERS_OFF);
+}
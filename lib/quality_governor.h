@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+class AudioFFT;
+
+// ============================
+// Adaptive quality governor
+// ============================
+// Watches audio callback headroom, UI frame time and process CPU once per
+// window and sheds visual work in stages before the audio can suffer:
+//   FULL -> FFT rate halved -> FFT size halved -> display FPS halved -> analyzers off
+// Steps down quickly under pressure, steps back up slowly once it clears.
+class QualityGovernor {
+public:
+    enum Level {
+        LEVEL_FULL = 0,
+        LEVEL_FFT_RATE,
+        LEVEL_FFT_SIZE,
+        LEVEL_DISPLAY_FPS,
+        LEVEL_ANALYZERS_OFF,
+        LEVEL_COUNT
+    };
+
+    struct Metrics {
+        int level;
+        uint32_t stepDowns;
+        uint32_t stepUps;
+        float audioLoad;     // worst callback time / period in the last window
+        uint32_t underruns;  // new short reads in the last window
+        float frameMs;       // average UI work per frame (excluding sleep)
+        float processCpu;    // process CPU time / wall time, in cores
+    };
+
+    QualityGovernor(AudioFFT* fft, int baseFps = 60);
+
+    // Call once per rendered frame with the time spent building and drawing it
+    void frameDone(double frameWorkMs);
+    // Call on every loop wakeup so windows still close while no frames are drawn
+    void update();
+
+    int getLevel() const { return level; }
+    int getTargetFps() const;
+    const Metrics& getMetrics() const { return metrics; }
+    static const char* levelName(int level);
+
+    // Thresholds (defaults are conservative for a small player)
+    float maxAudioLoad  = 0.9f;
+    float maxFrameShare = 0.75f; // frame work as a share of the frame interval
+    float maxProcessCpu = 0.5f;
+    int downWindows = 2;         // consecutive pressured windows before stepping down
+    int upWindows   = 5;         // consecutive clear windows before stepping up
+
+private:
+    void evaluate();
+    void apply(int newLevel);
+    double processCpuSeconds() const;
+
+    AudioFFT* fft;
+    int baseFps;
+    int baseFftSize;
+    int baseHopMs;
+
+    int level = LEVEL_FULL;
+    int pressured = 0;
+    int clear = 0;
+    Metrics metrics{};
+
+    std::chrono::steady_clock::time_point windowStart;
+    double windowCpuStart;
+    double frameMsSum = 0.0;
+    int frames = 0;
+    uint32_t lastUnderruns = 0;
+};
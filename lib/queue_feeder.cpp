@@ -0,0 +1,107 @@
+#include "queue_feeder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+QueueFeeder::QueueFeeder(PlayQueue& queue_, int leadMs_)
+    : queue(queue_), leadMs(leadMs_)
+{
+}
+
+QueueFeeder::~QueueFeeder() {
+    stop();
+}
+
+void QueueFeeder::start() {
+    running = true;
+    thread = std::thread(&QueueFeeder::threadFunc, this);
+}
+
+void QueueFeeder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running)
+            return;
+        running = false;
+    }
+    cv.notify_all();
+    if (thread.joinable())
+        thread.join();
+}
+
+void QueueFeeder::wake() {
+    // through the lock, so a wake between planning and waiting is not lost
+    { std::lock_guard<std::mutex> lock(mutex); }
+    cv.notify_all();
+}
+
+void QueueFeeder::trackChanged(const std::string& uri) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fed.empty())
+            return;
+        if (uri != fed)
+            std::cout << "[queue] librespot moved to " << (uri.empty() ? "nothing" : uri)
+                      << " instead of " << fed << std::endl;
+        fed.clear();
+    }
+    cv.notify_all();
+}
+
+void QueueFeeder::sendFailed(const std::string& uri) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fed != uri)
+            return;
+        std::cout << "[queue] librespot did not take " << uri << ", dropped" << std::endl;
+        fed.clear();
+    }
+    cv.notify_all();
+}
+
+void QueueFeeder::cancel() {
+    {
+        // under the lock, so the thread cannot take a newer head in between
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fed.empty())
+            return;
+        queue.pushFront(fed);
+        fed.clear();
+    }
+    cv.notify_all();
+}
+
+std::string QueueFeeder::handedOver() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fed;
+}
+
+void QueueFeeder::threadFunc() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        // ms until the head should go; -1 = nothing to do until woken
+        int dueMs = -1;
+        if (fed.empty() && !queue.empty()) {
+            int left = msLeft ? msLeft() : -1;
+            if (left >= 0)
+                dueMs = std::max(0, left - leadMs);
+        }
+
+        if (dueMs == 0) {
+            std::string uri = queue.takeNext();
+            if (uri.empty())
+                continue;
+            fed = uri;
+            std::cout << "[queue] up next: " << uri << std::endl;
+            // unlocked: a refusal may come back through sendFailed() at once
+            lock.unlock();
+            send(uri);
+            lock.lock();
+        } else if (dueMs < 0) {
+            cv.wait(lock);
+        } else {
+            cv.wait_for(lock, std::chrono::milliseconds(dueMs));
+        }
+    }
+}
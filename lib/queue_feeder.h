@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "play_queue.h"
+
+// ============================
+// Queue feeder
+// ============================
+// Hands the PlayQueue head to go-librespot's queue leadMs before the current
+// track ends, so librespot does the transition itself. Runs on its own
+// thread with a timer, so the queue keeps playing while the window is
+// minimized; msLeft() (time to the end of the current track, -1 while
+// paused or unknown) is read again on every wake, so the timing follows the
+// audio clock rather than the timer.
+//
+// One URI is handed over at a time. The handover ends when the track
+// changes (to it or to anything else), when librespot refuses it, or when a
+// load cancels it, which puts it back at the head of the PlayQueue.
+class QueueFeeder {
+public:
+    // Posts uri to librespot's queue; must report a refusal with sendFailed()
+    using Send = std::function<void(const std::string& uri)>;
+
+    QueueFeeder(PlayQueue& queue, int leadMs);
+    ~QueueFeeder();
+
+    // Before start()
+    void setMsLeft(std::function<int()> fn) { msLeft = std::move(fn); }
+    void setSend(Send fn) { send = std::move(fn); }
+
+    void start();
+    void stop();
+
+    // The queue grew, or the position / pause state moved: re-plan
+    void wake();
+    // The player moved to another track (uri may be empty)
+    void trackChanged(const std::string& uri);
+    // librespot did not take uri; it is dropped, the next one may go
+    void sendFailed(const std::string& uri);
+    // A load replaced librespot's queue: what was handed over goes back to
+    // the head of the PlayQueue
+    void cancel();
+
+    // Handed over and not started yet; empty if none
+    std::string handedOver() const;
+
+private:
+    void threadFunc();
+
+    PlayQueue& queue;
+    int leadMs;
+    std::function<int()> msLeft;
+    Send send;
+
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    bool running = false;
+    std::string fed;
+};
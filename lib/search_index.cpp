@@ -0,0 +1,754 @@
+#include "search_index.h"
+#include "spotify_uri.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+static constexpr uint32_t FILE_MAGIC = 0x58495053; // "SPIX"
+static constexpr uint32_t FILE_VERSION = 1;
+static constexpr size_t MAX_QUERY_GRAMS = 48;
+static constexpr size_t MAX_USED_GRAMS = 16;
+static constexpr size_t MAX_CANDIDATES = 50000;
+
+// ============================
+// Text helpers
+// ============================
+
+// " " + lowercase words separated by single spaces; bytes >= 0x80 (UTF-8)
+// are kept as word characters
+static void normalize(std::string_view in, std::string& out) {
+    out.clear();
+    out.push_back(' ');
+    for (unsigned char c : in) {
+        if (c >= 'A' && c <= 'Z')
+            c = (unsigned char)(c - 'A' + 'a');
+        bool word = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80;
+        if (word)
+            out.push_back((char)c);
+        else if (out.back() != ' ')
+            out.push_back(' ');
+    }
+    if (out.size() > 1 && out.back() == ' ')
+        out.pop_back();
+}
+
+static uint32_t gram_at(const std::string& s, size_t i) {
+    return (uint32_t)(unsigned char)s[i] << 16 | (uint32_t)(unsigned char)s[i + 1] << 8 | (unsigned char)s[i + 2];
+}
+
+static void doc_text(std::string_view title, std::string_view artist, std::string& out) {
+    std::string joined;
+    joined.reserve(title.size() + artist.size() + 1);
+    joined.append(title.data(), title.size());
+    joined.push_back(' ');
+    joined.append(artist.data(), artist.size());
+    normalize(joined, out);
+}
+
+// ============================
+// Posting lists
+// ============================
+void SearchIndex::Postings::append(uint32_t id) {
+    if (count > 0 && id == last)
+        return; // trigram repeated within one entry
+    if (count % SKIP_EVERY == 0) {
+        skips.push_back(Skip{id, (uint32_t)bytes.size()});
+    } else {
+        uint32_t delta = id - last;
+        while (delta >= 0x80) {
+            bytes.push_back((uint8_t)(delta | 0x80));
+            delta >>= 7;
+        }
+        bytes.push_back((uint8_t)delta);
+    }
+    if (!bits.empty()) {
+        if ((id >> 6) >= bits.size())
+            bits.resize((id >> 6) + 1, 0);
+        bits[id >> 6] |= (uint64_t)1 << (id & 63);
+    }
+    last = id;
+    count++;
+}
+
+// Walks a list one decoded block (SKIP_EVERY ids) at a time, either way
+class SearchIndex::Cursor {
+public:
+    // starts at the last (newest) id; use first() for the other end
+    explicit Cursor(const Postings& list) : p(&list) {
+        valid = p->count > 0;
+        if (valid) {
+            load((int)p->skips.size() - 1);
+            at = n - 1;
+            id = buf[at];
+        }
+    }
+
+    bool valid = false;
+    uint32_t id = 0;
+
+    void first() {
+        if (!valid) return;
+        load(0);
+        at = 0;
+        id = buf[0];
+    }
+
+    void next() {
+        if (++at >= n) {
+            if (block + 1 >= (int)p->skips.size()) { valid = false; return; }
+            load(block + 1);
+            at = 0;
+        }
+        id = buf[at];
+    }
+
+    void prev() {
+        if (--at < 0) {
+            if (block == 0) { valid = false; return; }
+            load(block - 1);
+            at = n - 1;
+        }
+        id = buf[at];
+    }
+
+    // moves back to the largest id <= target
+    void seekDown(uint32_t target) {
+        if (!valid || id <= target)
+            return;
+        if (p->skips[block].id > target) {
+            // target is in an earlier block, usually a near one: gallop back,
+            // then binary search the last step
+            int hi = block, step = 1;
+            while (hi - step > 0 && p->skips[hi - step].id > target) {
+                hi -= step;
+                step *= 2;
+            }
+            auto it = std::upper_bound(p->skips.begin() + std::max(0, hi - step), p->skips.begin() + hi, target,
+                                       [](uint32_t t, const Skip& s) { return t < s.id; });
+            if (it == p->skips.begin()) { valid = false; return; }
+            // only decode up to target: later seeks / prev() go lower still
+            at = load((int)(it - p->skips.begin()) - 1, target);
+            id = buf[at];
+            return;
+        }
+        while (buf[at] > target)
+            at--;
+        id = buf[at];
+    }
+
+private:
+    using Skip = Postings::Skip;
+
+    // Decodes block b, stopping after the last id <= upTo; returns its index
+    int load(int b, uint32_t upTo = UINT32_MAX) {
+        block = b;
+        n = std::min<int>(SKIP_EVERY, (int)(p->count - (uint32_t)b * SKIP_EVERY));
+        const uint8_t* bytes = p->bytes.data() + p->skips[b].offset;
+        uint32_t v = p->skips[b].id;
+        buf[0] = v;
+        for (int i = 1; i < n; i++) {
+            uint32_t delta = 0;
+            int shift = 0;
+            uint8_t c;
+            do {
+                c = *bytes++;
+                delta |= (uint32_t)(c & 0x7F) << shift;
+                shift += 7;
+            } while (c & 0x80);
+            v += delta;
+            if (v > upTo)
+                return i - 1;
+            buf[i] = v;
+        }
+        return n - 1;
+    }
+
+    const Postings* p;
+    int block = 0;
+    int at = 0;
+    int n = 0;
+    uint32_t buf[SKIP_EVERY];
+};
+
+// ============================
+// SearchIndex
+// ============================
+SearchIndex::SearchIndex(const std::string& path_)
+    : path(path_)
+{
+}
+
+SearchIndex::~SearchIndex() = default;
+
+uint32_t SearchIndex::addDoc(StringPool::Handle uri, StringPool::Handle title, StringPool::Handle artist, uint8_t sources) {
+    uint32_t id = (uint32_t)docs.size();
+    docs.push_back(Doc{uri, title, artist, sources, true});
+    byUri[uri] = id;
+
+    doc_text(pool.get(title), pool.get(artist), scratch);
+    for (size_t i = 0; i + 3 <= scratch.size(); i++) {
+        Postings& list = lists[gram_at(scratch, i)];
+        list.append(id);
+        updateDense(list);
+    }
+    return id;
+}
+
+// Gives a list its bitmap once it covers 1 in DENSE_RATIO entries
+void SearchIndex::updateDense(Postings& p) const {
+    if (!p.bits.empty() || p.count < DENSE_MIN || (size_t)p.count * DENSE_RATIO < docs.size())
+        return;
+    p.bits.assign((docs.size() + 63) / 64, 0);
+    Cursor c(p);
+    for (c.first(); c.valid; c.next())
+        p.bits[c.id >> 6] |= (uint64_t)1 << (c.id & 63);
+}
+
+void SearchIndex::add(std::string_view uri, std::string_view title, std::string_view artist, uint8_t sources) {
+    if (uri.empty())
+        return;
+    StringPool::Handle u = pool.intern(uri);
+    auto it = byUri.find(u);
+    if (it == byUri.end()) {
+        addDoc(u, pool.intern(title), pool.intern(artist), sources);
+        dirty = true;
+        return;
+    }
+
+    Doc& doc = docs[it->second];
+    StringPool::Handle t = title.empty() ? doc.title : pool.intern(title);
+    StringPool::Handle a = artist.empty() ? doc.artist : pool.intern(artist);
+    if (t == doc.title && a == doc.artist) {
+        if ((doc.sources | sources) != doc.sources) {
+            doc.sources |= sources;
+            dirty = true;
+        }
+        return;
+    }
+
+    // new text: retire the old id, its postings are skipped until compact()
+    uint8_t merged = doc.sources | sources;
+    doc.alive = false;
+    deadCount++;
+    addDoc(u, t, a, merged);
+    dirty = true;
+
+    if (deadCount > 4096 && deadCount * 2 > docs.size())
+        compact();
+}
+
+void SearchIndex::compact() {
+    if (deadCount == 0)
+        return;
+
+    std::vector<uint32_t> remap(docs.size(), UINT32_MAX);
+    std::vector<Doc> kept;
+    kept.reserve(docs.size() - deadCount);
+    for (uint32_t i = 0; i < docs.size(); i++) {
+        if (!docs[i].alive)
+            continue;
+        remap[i] = (uint32_t)kept.size();
+        kept.push_back(docs[i]);
+    }
+
+    // ids keep their order, so every list stays sorted
+    for (auto it = lists.begin(); it != lists.end();) {
+        Postings fresh;
+        Cursor c(it->second);
+        for (c.first(); c.valid; c.next()) {
+            if (remap[c.id] != UINT32_MAX)
+                fresh.append(remap[c.id]);
+        }
+        if (fresh.count == 0) {
+            it = lists.erase(it);
+        } else {
+            fresh.bytes.shrink_to_fit();
+            fresh.skips.shrink_to_fit();
+            it->second = std::move(fresh);
+            ++it;
+        }
+    }
+
+    docs.swap(kept);
+    for (auto& kv : lists)
+        updateDense(kv.second);
+    byUri.clear();
+    for (uint32_t i = 0; i < docs.size(); i++)
+        byUri[docs[i].uri] = i;
+    deadCount = 0;
+}
+
+void SearchIndex::clearAll() {
+    pool = StringPool();
+    docs.clear();
+    byUri.clear();
+    lists.clear();
+    deadCount = 0;
+}
+
+size_t SearchIndex::search(std::string_view query, size_t limit, std::vector<Result>& out) {
+    out.clear();
+    if (limit == 0)
+        return 0;
+
+    // ---- A pasted link: that exact entry ----
+    SpotifyRef ref;
+    if (spotify_parse(query.data(), query.size(), ref)) {
+        char uri[40];
+        size_t len = spotify_format(ref, uri, sizeof(uri));
+        StringPool::Handle u;
+        if (pool.find(std::string_view(uri, len), u)) {
+            auto it = byUri.find(u);
+            if (it != byUri.end()) {
+                const Doc& d = docs[it->second];
+                out.push_back(Result{pool.get(d.uri), pool.get(d.title), pool.get(d.artist), d.sources, 2000});
+            }
+        }
+        return out.size();
+    }
+
+    // ---- Query trigrams, rarest list first ----
+    normalize(query, scratch);
+    grams.clear();
+    for (size_t i = 0; i + 3 <= scratch.size() && grams.size() < MAX_QUERY_GRAMS; i++)
+        grams.push_back(gram_at(scratch, i));
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    if (grams.empty())
+        return 0;
+
+    static const Postings empty;
+    const Postings* ls[MAX_QUERY_GRAMS];
+    for (size_t k = 0; k < grams.size(); k++) {
+        auto it = lists.find(grams[k]);
+        ls[k] = it != lists.end() ? &it->second : &empty;
+    }
+    std::sort(ls, ls + grams.size(), [](const Postings* a, const Postings* b) { return a->count < b->count; });
+
+    // a long query is matched on its rarest trigrams only; the common ones
+    // add little but cost the most
+    size_t total = std::min(grams.size(), MAX_USED_GRAMS);
+
+    // an entry must share `need` trigrams (a typo costs up to three), so it
+    // is in at least one of the (total - need + 1) rarest lists: only those
+    // produce candidates, the common lists are just probed at their ids
+    size_t need = total <= 2 ? total : std::max((2 * total + 2) / 3, total - 3);
+    size_t rare = total - need + 1;
+
+    cursors.clear();
+    for (size_t k = 0; k < total; k++)
+        cursors.emplace_back(*ls[k]);
+
+    // ---- Candidates newest first ----
+    // The shortlist is the best overlap, newest first; once it is full of
+    // entries that have every trigram, nothing older can get in, so short
+    // (common) queries stop early.
+    size_t shortlist = std::max<size_t>(limit * 4, 64);
+    size_t complete = 0;
+    hits.clear();
+    // a query of only very common words could visit most of the library;
+    // past the budget it settles for the newest matches
+    for (size_t visited = 0; visited < MAX_CANDIDATES; visited++) {
+        uint32_t high = 0;
+        bool any = false;
+        for (size_t k = 0; k < rare; k++) {
+            if (cursors[k].valid && (!any || cursors[k].id > high)) {
+                high = cursors[k].id;
+                any = true;
+            }
+        }
+        if (!any)
+            break;
+
+        size_t n = 0;
+        for (size_t k = 0; k < rare; k++) {
+            Cursor& c = cursors[k];
+            if (c.valid && c.id == high) {
+                n++;
+                c.prev();
+            }
+        }
+        for (size_t k = rare; k < total && n + (total - k) >= need; k++) {
+            if (!ls[k]->bits.empty()) {
+                n += ls[k]->has(high);
+                continue;
+            }
+            Cursor& c = cursors[k];
+            c.seekDown(high);
+            if (c.valid && c.id == high)
+                n++;
+        }
+
+        if (n < need || !docs[high].alive)
+            continue;
+        hits.emplace_back(high, (uint16_t)n);
+        if (n == total && ++complete >= shortlist)
+            break;
+    }
+
+    // ---- Rank: trigram overlap first, then a closer look at the best ----
+    auto by_overlap = [](const std::pair<uint32_t, uint16_t>& a, const std::pair<uint32_t, uint16_t>& b) {
+        return a.second != b.second ? a.second > b.second : a.first > b.first; // newer first
+    };
+    if (shortlist < hits.size()) {
+        std::nth_element(hits.begin(), hits.begin() + shortlist, hits.end(), by_overlap);
+        hits.resize(shortlist);
+    }
+
+    std::string q = scratch.substr(1);   // query without the word-start marker
+    std::string text;
+    for (auto& h : hits) {
+        const Doc& d = docs[h.first];
+        doc_text(pool.get(d.title), pool.get(d.artist), text);
+        int score = (int)(1000 * h.second / total);
+        size_t at = text.find(q);
+        if (at != std::string::npos) {
+            score += 600;                               // contains the query as typed
+            if (at > 0 && text[at - 1] == ' ') score += 200;   // ... at a word start
+        }
+        if (d.sources & SRC_HISTORY) score += 20;       // played before
+        score -= (int)std::min<size_t>(text.size(), 200) / 10;
+        out.push_back(Result{pool.get(d.uri), pool.get(d.title), pool.get(d.artist), d.sources, std::max(score, 0)});
+    }
+
+    std::sort(out.begin(), out.end(), [](const Result& a, const Result& b) { return a.score > b.score; });
+    if (out.size() > limit)
+        out.resize(limit);
+    return out.size();
+}
+
+size_t SearchIndex::memoryBytes() const {
+    size_t total = pool.bytes() + docs.capacity() * sizeof(Doc) + byUri.size() * 32;
+    for (const auto& kv : lists)
+        total += sizeof(kv) + 16 + kv.second.bytes.capacity() + kv.second.skips.capacity() * sizeof(Postings::Skip) +
+                 kv.second.bits.capacity() * sizeof(uint64_t);
+    return total;
+}
+
+// ============================
+// Persistence
+// ============================
+// "SPIX", version, entries (sources, uri, title, artist as u16-length
+// strings), then the posting lists as stored in memory. Saved compacted, so
+// entry ids are the file order.
+
+namespace {
+struct Writer {
+    FILE* f;
+    bool ok = true;
+    void raw(const void* p, size_t n) { if (ok && n && std::fwrite(p, 1, n, f) != n) ok = false; }
+    void u8(uint8_t v) { raw(&v, 1); }
+    void u32(uint32_t v) { raw(&v, 4); }
+    void str(std::string_view s) { uint16_t n = (uint16_t)s.size(); raw(&n, 2); raw(s.data(), n); }
+};
+
+struct Reader {
+    const char* p;
+    const char* end;
+    bool ok = true;
+    bool raw(void* out, size_t n) {
+        if (!ok || (size_t)(end - p) < n) return ok = false;
+        std::memcpy(out, p, n);
+        p += n;
+        return true;
+    }
+    uint8_t u8() { uint8_t v = 0; raw(&v, 1); return v; }
+    uint32_t u32() { uint32_t v = 0; raw(&v, 4); return v; }
+    std::string_view str() {
+        uint16_t n = 0;
+        if (!raw(&n, 2) || (size_t)(end - p) < n) { ok = false; return {}; }
+        std::string_view s(p, n);
+        p += n;
+        return s;
+    }
+};
+}
+
+bool SearchIndex::save() {
+    if (!dirty)
+        return true;
+    compact();
+
+    std::string tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f)
+        return false;
+
+    Writer w{f};
+    w.u32(FILE_MAGIC);
+    w.u32(FILE_VERSION);
+    w.u32((uint32_t)docs.size());
+    for (const Doc& d : docs) {
+        w.u8(d.sources);
+        w.str(pool.get(d.uri));
+        w.str(pool.get(d.title));
+        w.str(pool.get(d.artist));
+    }
+    w.u32((uint32_t)lists.size());
+    for (const auto& kv : lists) {
+        const Postings& p = kv.second;
+        w.u32(kv.first);
+        w.u32(p.count);
+        w.u32(p.last);
+        w.u32((uint32_t)p.skips.size());
+        w.raw(p.skips.data(), p.skips.size() * sizeof(Postings::Skip));
+        w.u32((uint32_t)p.bytes.size());
+        w.raw(p.bytes.data(), p.bytes.size());
+    }
+
+    bool ok = (std::fclose(f) == 0) && w.ok;
+    if (!ok)
+        return false;
+    if (!replace_file(tmp, path))
+        return false;
+    dirty = false;
+    return true;
+}
+
+// Walks a list read from disk: ids ascending and in range, skips at their
+// offsets, no varint running off the end
+bool SearchIndex::validList(const Postings& p, uint32_t docCount) {
+    uint32_t id = 0;
+    size_t pos = 0;
+    for (uint32_t i = 0; i < p.count; i++) {
+        if (i % SKIP_EVERY == 0) {
+            const Postings::Skip& s = p.skips[i / SKIP_EVERY];
+            if ((i > 0 && s.id <= id) || s.offset != pos)
+                return false;
+            id = s.id;
+        } else {
+            uint32_t delta = 0;
+            int shift = 0;
+            uint8_t b;
+            do {
+                if (pos >= p.bytes.size() || shift > 28)
+                    return false;
+                b = p.bytes[pos++];
+                delta |= (uint32_t)(b & 0x7F) << shift;
+                shift += 7;
+            } while (b & 0x80);
+            if (delta == 0 || id + delta < id)
+                return false;
+            id += delta;
+        }
+        if (id >= docCount)
+            return false;
+    }
+    return pos == p.bytes.size() && id == p.last;
+}
+
+bool SearchIndex::load() {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return true; // nothing saved yet
+    in.seekg(0, std::ios::end);
+    std::streamoff size = in.tellg();
+    in.seekg(0, std::ios::beg);
+    if (size < 0)
+        return false;
+    std::string data((size_t)size, '\0');
+    in.read(&data[0], size);
+    data.resize((size_t)in.gcount());
+
+    clearAll();
+    Reader r{data.data(), data.data() + data.size()};
+    if (r.u32() != FILE_MAGIC || r.u32() != FILE_VERSION) {
+        std::cout << "[search] ignoring " << path << " (unknown format)" << std::endl;
+        return false;
+    }
+
+    uint32_t docCount = r.u32();
+    if (!r.ok || docCount > data.size() / 7) {
+        clearAll();
+        return false;
+    }
+    docs.reserve(docCount);
+    byUri.reserve(docCount);
+    pool.reserve(docCount * 2);
+    for (uint32_t i = 0; i < docCount && r.ok; i++) {
+        uint8_t sources = r.u8();
+        std::string_view u = r.str(), t = r.str(), a = r.str();
+        if (!r.ok)
+            break;
+        StringPool::Handle h = pool.intern(u);
+        docs.push_back(Doc{h, pool.intern(t), pool.intern(a), sources, true});
+        byUri[h] = i;
+    }
+
+    uint32_t listCount = r.u32();
+    if (r.ok && listCount <= data.size() / 16)
+        lists.reserve(listCount);
+    for (uint32_t i = 0; i < listCount && r.ok; i++) {
+        uint32_t key = r.u32();
+        Postings p;
+        p.count = r.u32();
+        p.last = r.u32();
+        uint32_t skipCount = r.u32();
+        // the counts must agree with each other before anything is sized by them
+        if (!r.ok || p.count == 0 || skipCount != (p.count + SKIP_EVERY - 1) / SKIP_EVERY ||
+            p.last >= docCount || (size_t)(r.end - r.p) / sizeof(Postings::Skip) < skipCount) {
+            r.ok = false;
+            break;
+        }
+        p.skips.resize(skipCount);
+        r.raw(p.skips.data(), skipCount * sizeof(Postings::Skip));
+        uint32_t byteCount = r.u32();
+        if (!r.ok || (size_t)(r.end - r.p) < byteCount) {
+            r.ok = false;
+            break;
+        }
+        p.bytes.assign((const uint8_t*)r.p, (const uint8_t*)r.p + byteCount);
+        r.p += byteCount;
+
+        if (!validList(p, docCount)) {
+            r.ok = false;
+            break;
+        }
+        lists.emplace(key, std::move(p));
+    }
+
+    if (!r.ok || docs.size() != docCount) {
+        std::cout << "[search] " << path << " is damaged, starting empty" << std::endl;
+        clearAll();
+        return false;
+    }
+    for (auto& kv : lists)
+        updateDense(kv.second);
+    dirty = false;
+    return true;
+}
+
+// ============================
+// Benchmark
+// ============================
+void search_index_benchmark(int entries) {
+    using clock = std::chrono::steady_clock;
+    auto ms_since = [](clock::time_point t) { return std::chrono::duration<double, std::milli>(clock::now() - t).count(); };
+
+    if (entries <= 0)
+        entries = 1000000;
+    std::mt19937 rng(42);
+
+    // Zipf-distributed words: a few very common ones ("the", "love", ...)
+    // and a long tail of pseudo-words, so posting lists range from huge to
+    // tiny as in real titles
+    static const char* common[] = {"the", "love", "you", "me", "my", "in", "of", "night", "heart", "baby",
+                                   "time", "day", "life", "world", "feat", "remix", "live", "version",
+                                   "remastered", "girl", "dance", "home", "song", "blue", "fire"};
+    static const char consonants[] = "bcdfghjklmnprstvwyz";
+    static const char vowels[] = "aeiou";
+    std::vector<std::string> vocab(std::begin(common), std::end(common));
+    while (vocab.size() < 50000) {
+        std::string word;
+        int parts = 1 + (int)(rng() % 3);
+        for (int k = 0; k < parts; k++) {
+            word += consonants[rng() % 19];
+            word += vowels[rng() % 5];
+            if (rng() % 3 == 0) word += consonants[rng() % 19];
+        }
+        vocab.push_back(word);
+    }
+    std::vector<double> cdf(vocab.size());
+    double acc = 0;
+    for (size_t r = 0; r < vocab.size(); r++) cdf[r] = acc += 1.0 / (double)(r + 1);
+    std::uniform_real_distribution<double> pick(0.0, acc);
+    auto words = [&](int n) {
+        std::string s;
+        for (int k = 0; k < n; k++) {
+            if (k) s += ' ';
+            std::string w = vocab[std::upper_bound(cdf.begin(), cdf.end(), pick(rng)) - cdf.begin()];
+            w[0] = (char)(w[0] - 'a' + 'A');
+            s += w;
+        }
+        return s;
+    };
+    std::vector<std::string> artists(std::max(1, entries / 10));
+    for (std::string& a : artists) a = words(1 + (int)(rng() % 2));
+
+    static const char base62[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    std::vector<std::string> uris(entries), titles(entries);
+    std::vector<uint32_t> artistOf(entries);
+    for (int i = 0; i < entries; i++) {
+        uris[i] = "spotify:track:";
+        for (int k = 0; k < SpotifyRef::ID_LENGTH; k++) uris[i] += base62[rng() % 62];
+        titles[i] = words(1 + (int)(rng() % 4));
+        artistOf[i] = (uint32_t)(rng() % artists.size());
+    }
+
+    std::string file = "spotamp_search_bench.idx";
+    SearchIndex index(file);
+    auto t0 = clock::now();
+    for (int i = 0; i < entries; i++)
+        index.add(uris[i], titles[i], artists[artistOf[i]], SearchIndex::SRC_PLAYLIST);
+    double build = ms_since(t0);
+
+    t0 = clock::now();
+    bool saved = index.save();
+    double saveMs = ms_since(t0);
+    SearchIndex loaded(file);
+    t0 = clock::now();
+    bool ok = saved && loaded.load();
+    double loadMs = ms_since(t0);
+    std::remove(file.c_str());
+
+    std::printf("search index: %d entries\n", entries);
+    std::printf("  build %.0f ms, %.1f MB in memory\n", build, index.memoryBytes() / 1048576.0);
+    std::printf("  save %.0f ms, load %.0f ms%s\n", saveMs, loadMs, ok ? "" : " (FAILED)");
+
+    // queries as typed: word prefixes, whole titles, titles with a typo
+    struct Query { std::string text; int target; };
+    std::vector<Query> queries;
+    for (int i = 0; i < 3000; i++) {
+        int target = (int)(rng() % entries);
+        std::string q = titles[target] + " " + artists[artistOf[target]];
+        switch (i % 3) {
+            case 0: q = q.substr(0, 2 + rng() % 6); break;               // typing the first letters
+            case 1: break;                                                // full title + artist
+            case 2: {                                                     // one typo
+                size_t at = rng() % q.size();
+                q[at] = (char)('a' + rng() % 26);
+                break;
+            }
+        }
+        queries.push_back(Query{q, target});
+    }
+
+    std::vector<SearchIndex::Result> results;
+    std::vector<double> times;
+    int found[3] = {0, 0, 0};
+    for (size_t i = 0; i < queries.size(); i++) {
+        auto t = clock::now();
+        loaded.search(queries[i].text, 20, results);
+        times.push_back(std::chrono::duration<double, std::micro>(clock::now() - t).count());
+        for (const auto& r : results) {
+            if (r.uri == uris[queries[i].target]) { found[i % 3]++; break; }
+        }
+    }
+    std::sort(times.begin(), times.end());
+    double sum = 0;
+    for (double t : times) sum += t;
+    std::printf("  query: avg %.0f us, p50 %.0f us, p99 %.0f us, max %.0f us\n", sum / times.size(),
+                times[times.size() / 2], times[times.size() * 99 / 100], times.back());
+    std::printf("  target in top 20: full %d%%, with typo %d%% (prefixes are ambiguous: %d%%)\n",
+                found[1] * 100 / 1000, found[2] * 100 / 1000, found[0] * 100 / 1000);
+
+    // what a plain substring scan over the same entries costs
+    std::string needle, text;
+    t0 = clock::now();
+    int scans = 5, matched = 0;
+    for (int s = 0; s < scans; s++) {
+        normalize(queries[s * 3 + 1].text, needle);
+        needle.erase(0, 1);
+        for (int i = 0; i < entries; i++) {
+            doc_text(titles[i], artists[artistOf[i]], text);
+            if (text.find(needle) != std::string::npos) matched++;
+        }
+    }
+    std::printf("  linear substring scan: %.1f ms per query (%d match)\n", ms_since(t0) / scans, matched);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "string_pool.h"
+
+// ============================
+// Fuzzy search index
+// ============================
+// Everything SpotAmp has seen (played tracks, queue and playlist entries),
+// one entry per URI, searchable by title / artist with typo tolerance.
+//
+// Text is normalized (ASCII lowercase, punctuation -> single space, leading
+// space) and cut into trigrams, so " be" marks a word start. Each trigram
+// has a posting list of entry ids, delta + varint coded with a skip entry
+// every SKIP_EVERY ids. Ids only grow, so adding an entry is an append to
+// each of its lists; changing an entry's text retires the old id and
+// appends a new one. A query keeps entries that share most of its
+// trigrams: candidates come from the rarest lists only, the common lists
+// are merely probed, and candidates are walked newest first so the walk
+// can stop as soon as the shortlist is settled.
+class SearchIndex {
+public:
+    enum Source : uint8_t {
+        SRC_HISTORY  = 1,
+        SRC_QUEUE    = 2,
+        SRC_PLAYLIST = 4
+    };
+
+    struct Result {
+        std::string_view uri;
+        std::string_view title;
+        std::string_view artist;
+        uint8_t sources;
+        int score;   // 0..2000, higher is better
+    };
+
+    explicit SearchIndex(const std::string& path);
+    ~SearchIndex();
+
+    // Reads the saved index; false if it was unreadable (starts empty)
+    bool load();
+    // Writes the index (compacted) if anything changed since load / save
+    bool save();
+
+    // Adds or updates the entry for uri. Empty title / artist keep what is
+    // already known; sources are OR-ed in.
+    void add(std::string_view uri, std::string_view title, std::string_view artist, uint8_t sources);
+
+    // Best matches first, at most limit; the views stay valid until the next
+    // add() / load(). A Spotify link as query finds that exact entry.
+    size_t search(std::string_view query, size_t limit, std::vector<Result>& out);
+
+    size_t size() const { return docs.size() - deadCount; }
+    size_t memoryBytes() const;
+
+private:
+    static constexpr int SKIP_EVERY = 64;
+    static constexpr size_t DENSE_RATIO = 8;
+    static constexpr uint32_t DENSE_MIN = 4096;
+
+    struct Doc {
+        StringPool::Handle uri, title, artist;
+        uint8_t sources;
+        bool alive;
+    };
+
+    // Ascending ids: a skip {id, byte offset} starts every block, the other
+    // ids of the block are varint deltas. Lists holding at least 1 in
+    // DENSE_RATIO entries also keep a bitmap, so probing them is one bit test.
+    struct Postings {
+        struct Skip { uint32_t id; uint32_t offset; };
+        std::vector<uint8_t> bytes;
+        std::vector<Skip> skips;
+        std::vector<uint64_t> bits;
+        uint32_t count = 0;
+        uint32_t last = 0;
+
+        void append(uint32_t id);
+        bool has(uint32_t id) const {
+            return (id >> 6) < bits.size() && (bits[id >> 6] >> (id & 63) & 1);
+        }
+    };
+    class Cursor;
+
+    uint32_t addDoc(StringPool::Handle uri, StringPool::Handle title, StringPool::Handle artist, uint8_t sources);
+    void compact();
+    void clearAll();
+    void updateDense(Postings& p) const;
+    static bool validList(const Postings& p, uint32_t docCount);
+
+    std::string path;
+    StringPool pool;
+    std::vector<Doc> docs;
+    std::unordered_map<StringPool::Handle, uint32_t> byUri;
+    std::unordered_map<uint32_t, Postings> lists;
+    size_t deadCount = 0;
+    bool dirty = false;
+
+    // query scratch, reused to keep typing allocation-free
+    std::vector<uint32_t> grams;
+    std::vector<Cursor> cursors;
+    std::vector<std::pair<uint32_t, uint16_t>> hits;
+    std::string scratch;
+};
+
+// spotamp --bench-search [entries]: build, save / load and query latency over
+// a synthetic library
+void search_index_benchmark(int entries);
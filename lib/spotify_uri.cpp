@@ -0,0 +1,392 @@
+#include "spotify_uri.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <string>
+
+// ============================
+// Character helpers
+// ============================
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static bool is_base62(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool is_alpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// case-insensitive compare of s[0..n) against a lowercase literal
+static bool equals(const char* s, size_t n, const char* lit) {
+    size_t i = 0;
+    for (; i < n && lit[i]; i++)
+        if (to_lower(s[i]) != lit[i])
+            return false;
+    return i == n && lit[i] == '\0';
+}
+
+static bool starts_with(const char* s, size_t n, const char* lit) {
+    size_t i = 0;
+    for (; lit[i]; i++)
+        if (i >= n || to_lower(s[i]) != lit[i])
+            return false;
+    return true;
+}
+
+// ============================
+// Grammar
+// ============================
+static const char* const typeNames[] = {
+    "", "track", "album", "playlist", "artist", "episode", "show"
+};
+
+static SpotifyType type_from(const char* s, size_t n) {
+    for (int t = SPOTIFY_TRACK; t <= SPOTIFY_SHOW; t++)
+        if (equals(s, n, typeNames[t]))
+            return (SpotifyType)t;
+    return SPOTIFY_NONE;
+}
+
+static bool read_id(const char* s, size_t n, SpotifyRef& out) {
+    if (n != SpotifyRef::ID_LENGTH)
+        return false;
+    for (size_t i = 0; i < n; i++)
+        if (!is_base62(s[i]))
+            return false;
+    std::memcpy(out.id, s, n);
+    out.id[n] = '\0';
+    return true;
+}
+
+// Walks sep-separated segments of [p, end)
+struct Segments {
+    const char* p;
+    const char* end;
+    char sep;
+
+    bool next(const char*& s, size_t& n) {
+        if (p > end) return false;
+        s = p;
+        while (p < end && *p != sep) p++;
+        n = (size_t)(p - s);
+        p++; // past the separator (or one past end: no more segments)
+        return true;
+    }
+};
+
+static bool accept(SpotifyType type, const char* id, size_t idLen, SpotifyRef& out) {
+    if (type == SPOTIFY_NONE || !read_id(id, idLen, out))
+        return false;
+    out.type = type;
+    return true;
+}
+
+// after "spotify:" -> <type>:<id>  |  user:<name>:playlist:<id>
+static bool parse_uri(const char* p, const char* end, SpotifyRef& out) {
+    Segments seg{p, end, ':'};
+    const char *s, *id;
+    size_t n, idLen;
+
+    if (!seg.next(s, n)) return false;
+    if (equals(s, n, "user")) {
+        if (!seg.next(s, n) || n == 0) return false;  // user name
+        if (!seg.next(s, n)) return false;
+    }
+    SpotifyType type = type_from(s, n);
+    if (!seg.next(id, idLen) || seg.p <= end) return false; // id must be the last segment
+    return accept(type, id, idLen, out);
+}
+
+// [http[s]://](open|play).spotify.com/[intl-xx/][embed/][user/<name>/]<type>/<id>[/]
+static bool parse_url(const char* p, const char* end, SpotifyRef& out) {
+    size_t n = (size_t)(end - p);
+    if (starts_with(p, n, "https://")) p += 8;
+    else if (starts_with(p, n, "http://")) p += 7;
+
+    Segments seg{p, end, '/'};
+    const char *s, *id;
+    size_t len, idLen;
+
+    if (!seg.next(s, len)) return false;
+    if (!equals(s, len, "open.spotify.com") && !equals(s, len, "play.spotify.com")) return false;
+
+    if (!seg.next(s, len)) return false;
+    if (len > 5 && starts_with(s, len, "intl-")) {
+        for (size_t i = 5; i < len; i++)
+            if (!is_alpha(s[i]) && s[i] != '-') return false;
+        if (!seg.next(s, len)) return false;
+    }
+    if (equals(s, len, "embed")) {
+        if (!seg.next(s, len)) return false;
+    }
+    if (equals(s, len, "user")) {
+        if (!seg.next(s, len) || len == 0) return false; // user name
+        if (!seg.next(s, len)) return false;
+    }
+    SpotifyType type = type_from(s, len);
+    if (!seg.next(id, idLen)) return false;
+
+    // at most a trailing slash after the id
+    if (seg.p < end) return false;
+    return accept(type, id, idLen, out);
+}
+
+static bool parse_token(const char* p, const char* end, SpotifyRef& out) {
+    // pasted links are often wrapped in quotes / brackets or end a sentence
+    while (p < end && std::strchr("\"'<([", *p)) p++;
+    while (end > p && std::strchr("\"'>)].,;!", end[-1])) end--;
+
+    // query string and fragment never matter
+    const char* q = p;
+    while (q < end && *q != '?' && *q != '#') q++;
+    end = q;
+
+    size_t n = (size_t)(end - p);
+    if (starts_with(p, n, "spotify:"))
+        return parse_uri(p + 8, end, out);
+    return parse_url(p, end, out);
+}
+
+bool spotify_parse(const char* text, size_t len, SpotifyRef& out) {
+    const char* p = text;
+    const char* end = text + len;
+
+    while (p < end) {
+        while (p < end && is_space(*p)) p++;
+        const char* tokenEnd = p;
+        while (tokenEnd < end && !is_space(*tokenEnd)) tokenEnd++;
+
+        if (tokenEnd > p && parse_token(p, tokenEnd, out))
+            return true;
+        p = tokenEnd;
+    }
+    out.type = SPOTIFY_NONE;
+    return false;
+}
+
+size_t spotify_format(const SpotifyRef& ref, char* out, size_t cap) {
+    if (ref.type == SPOTIFY_NONE)
+        return 0;
+    const char* type = typeNames[ref.type];
+    size_t typeLen = std::strlen(type);
+    size_t len = 8 + typeLen + 1 + SpotifyRef::ID_LENGTH;
+    if (len + 1 > cap)
+        return 0;
+
+    std::memcpy(out, "spotify:", 8);
+    std::memcpy(out + 8, type, typeLen);
+    out[8 + typeLen] = ':';
+    std::memcpy(out + 9 + typeLen, ref.id, SpotifyRef::ID_LENGTH);
+    out[len] = '\0';
+    return len;
+}
+
+const char* spotify_type_name(SpotifyType type) {
+    return typeNames[type];
+}
+
+// ============================
+// Benchmark
+// ============================
+// What handle_paste() did per keystroke
+static std::string regex_handle_paste(const std::string& input) {
+    std::regex rgx(R"(https?://open\.spotify\.com/(track|playlist|album)/([a-zA-Z0-9]+))");
+    std::smatch match;
+    if (std::regex_search(input, match, rgx) && match.size() >= 3)
+        return "spotify:" + std::string(match[1]) + ":" + std::string(match[2]);
+    return input;
+}
+
+void spotify_uri_benchmark(int n) {
+    const char* inputs[] = {
+        "https://open.spotify.com/track/7FKUc1mFraEOl4k6sdcwfb?si=a3555da3e9444ef1",
+        "https://open.spotify.com/playlist/0iAeUtwINlqfjwAyQ4ykur?si=jrwFsnk8RzCNZb4-xI19uw",
+        "spotify:track:6mfOyqROx7tnXkL9pNAp75",
+        "Listen to this! https://open.spotify.com/intl-de/album/4aawyAB9vmqN3uQ7FjRGTy?si=x",
+        "spotify:track:6mfOyqROx7tn",  // half typed
+    };
+
+    std::cout << "link parse x" << n << " (ns per call)" << std::endl;
+    for (const char* in : inputs) {
+        std::string s = in;
+        size_t len = s.size();
+        volatile size_t sink = 0;
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < n; i++)
+            sink = sink + regex_handle_paste(s).size();
+        auto t1 = std::chrono::steady_clock::now();
+        for (int i = 0; i < n; i++) {
+            SpotifyRef ref;
+            char uri[40];
+            if (spotify_parse(s.data(), len, ref))
+                sink = sink + spotify_format(ref, uri, sizeof(uri));
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        double re = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+        double hand = std::chrono::duration<double, std::nano>(t2 - t1).count() / n;
+        std::cout << "  regex " << re << "  parser " << hand << "  (" << (hand > 0 ? re / hand : 0.0)
+                  << "x)  " << in << std::endl;
+    }
+}
+
+// ============================
+// Fuzzing
+// ============================
+// Reference grammar for generated inputs (lowercase, no legacy user paths)
+static bool regex_reference(const std::string& input, SpotifyType& type, std::string& id) {
+    static const std::regex rgx(
+        R"((?:^|\s)(?:(?:https?://)?(?:open|play)\.spotify\.com/(?:intl-[a-zA-Z-]+/)?(?:embed/)?)"
+        R"((track|album|playlist|artist|episode|show)/([0-9A-Za-z]{22})/?(?=[?#\s]|$))"
+        R"(|spotify:(track|album|playlist|artist|episode|show):([0-9A-Za-z]{22})(?=[?#\s]|$)))");
+    std::smatch m;
+    if (!std::regex_search(input, m, rgx))
+        return false;
+    std::string t = m[1].matched ? m[1].str() : m[3].str();
+    id = m[2].matched ? m[2].str() : m[4].str();
+    type = type_from(t.data(), t.size());
+    return true;
+}
+
+static bool check_invariants(const std::string& input, std::string& why) {
+    SpotifyRef ref;
+    if (!spotify_parse(input.data(), input.size(), ref))
+        return true;
+
+    if (ref.type == SPOTIFY_NONE) { why = "no type"; return false; }
+    if (std::strlen(ref.id) != (size_t)SpotifyRef::ID_LENGTH) { why = "id length"; return false; }
+    for (int i = 0; i < SpotifyRef::ID_LENGTH; i++)
+        if (!is_base62(ref.id[i])) { why = "id charset"; return false; }
+
+    // canonical form must parse back to itself
+    char uri[40];
+    size_t len = spotify_format(ref, uri, sizeof(uri));
+    SpotifyRef again;
+    if (len == 0 || !spotify_parse(uri, len, again) || again.type != ref.type ||
+        std::strcmp(again.id, ref.id) != 0) {
+        why = "round trip";
+        return false;
+    }
+    return true;
+}
+
+int spotify_uri_fuzz(int n) {
+    std::mt19937 rng(12345);
+    auto pick = [&](int k) { return (int)(rng() % (unsigned)k); };
+
+    const char* base62 = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const char* types[] = { "track", "album", "playlist", "artist", "episode", "show", "user", "tracks", "" };
+    const char* words[] = { "listen", "to", "this:", "spotify", "open", "com/track", "ok", "" };
+    // no quotes / brackets / '.': the parser trims those around a link on purpose
+    const char* junk = "/:?#-_ \t%&=abcXYZ019";
+
+    auto make_id = [&]() {
+        int len = 22;
+        switch (pick(8)) { case 0: len = 21; break; case 1: len = 23; break; case 2: len = pick(30); break; }
+        std::string id;
+        for (int i = 0; i < len; i++)
+            id += pick(40) == 0 ? junk[pick((int)std::strlen(junk))] : base62[pick(62)];
+        return id;
+    };
+
+    // structured input from the grammar, with plausible mistakes
+    auto generate = [&]() {
+        std::string s;
+        if (pick(3) == 0) { s += words[pick(8)]; s += ' '; }
+        const char* type = types[pick(9)];
+        if (pick(2) == 0) {
+            s += "spotify:";
+            s += type;
+            s += ':';
+        } else {
+            const char* schemes[] = { "https://", "http://", "", "htps://" };
+            const char* hosts[] = { "open.spotify.com", "play.spotify.com", "open.spotify.co", "spotify.com" };
+            s += schemes[pick(4)];
+            s += hosts[pick(4)];
+            s += '/';
+            switch (pick(4)) {
+                case 0: s += "intl-de/"; break;
+                case 1: s += "intl-pt-BR/"; break;
+                case 2: s += pick(2) ? "intl-/" : "intl-1/"; break;
+            }
+            if (pick(4) == 0) s += "embed/";
+            s += type;
+            s += '/';
+        }
+        s += make_id();
+        switch (pick(5)) {
+            case 0: s += "?si=" + make_id(); break;
+            case 1: s += "#frag"; break;
+            case 2: s += '/'; break;
+        }
+        if (pick(3) == 0) { s += ' '; s += words[pick(8)]; }
+        return s;
+    };
+
+    int failures = 0;
+    auto fail = [&](const char* what, const std::string& input) {
+        if (++failures <= 20)
+            std::cout << "  FAIL (" << what << "): \"" << input << "\"" << std::endl;
+    };
+
+    for (int i = 0; i < n; i++) {
+        std::string why;
+
+        // 1) grammar-generated: must agree with the regex reference
+        std::string s = generate();
+        SpotifyRef ref;
+        bool got = spotify_parse(s.data(), s.size(), ref);
+        SpotifyType refType = SPOTIFY_NONE;
+        std::string refId;
+        bool want = regex_reference(s, refType, refId);
+        if (got != want || (got && (ref.type != refType || refId != ref.id)))
+            fail("differs from reference", s);
+        if (!check_invariants(s, why))
+            fail(why.c_str(), s);
+
+        // 2) mutated: flip, insert or delete bytes; invariants only
+        std::string m = s;
+        for (int k = 1 + pick(4); k > 0; k--) {
+            size_t at = m.empty() ? 0 : (size_t)pick((int)m.size());
+            switch (pick(3)) {
+                case 0: if (!m.empty()) m[at] = (char)pick(256); break;
+                case 1: m.insert(m.begin() + at, (char)pick(256)); break;
+                case 2: if (!m.empty()) m.erase(m.begin() + at); break;
+            }
+        }
+        if (!check_invariants(m, why))
+            fail(why.c_str(), m);
+
+        // 3) random bytes
+        std::string r;
+        for (int k = pick(64); k > 0; k--)
+            r += (char)pick(256);
+        if (!check_invariants(r, why))
+            fail(why.c_str(), r);
+    }
+
+    // legacy forms the reference does not cover
+    const char* legacy[] = {
+        "spotify:user:someone:playlist:37i9dQZF1DXcBWIGoYBM5M",
+        "https://open.spotify.com/user/someone/playlist/37i9dQZF1DXcBWIGoYBM5M",
+    };
+    for (const char* l : legacy) {
+        SpotifyRef ref;
+        if (!spotify_parse(l, std::strlen(l), ref) || ref.type != SPOTIFY_PLAYLIST)
+            fail("legacy playlist", l);
+    }
+
+    std::cout << "link fuzz x" << n << ": " << failures << " failure(s)" << std::endl;
+    return failures;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+// ============================
+// Spotify link parser
+// ============================
+// Recognizes every form a Spotify item reference is pasted in, without
+// allocating:
+//
+//   spotify:track:<id>                       (also spotify:user:<name>:playlist:<id>)
+//   https://open.spotify.com/album/<id>?si=...
+//   open.spotify.com/intl-de/artist/<id>     (scheme optional, intl-xx prefix)
+//   https://open.spotify.com/embed/show/<id>
+//   "Song by Artist https://open.spotify.com/episode/<id>"  (link inside text)
+//
+// Types: track, album, playlist, artist, episode, show. IDs are 22
+// base62 characters.
+enum SpotifyType {
+    SPOTIFY_NONE,
+    SPOTIFY_TRACK,
+    SPOTIFY_ALBUM,
+    SPOTIFY_PLAYLIST,
+    SPOTIFY_ARTIST,
+    SPOTIFY_EPISODE,
+    SPOTIFY_SHOW
+};
+
+struct SpotifyRef {
+    static constexpr int ID_LENGTH = 22;
+
+    SpotifyType type = SPOTIFY_NONE;
+    char id[ID_LENGTH + 1] = {};
+};
+
+// Finds the first Spotify reference in text[0..len)
+bool spotify_parse(const char* text, size_t len, SpotifyRef& out);
+
+// Writes "spotify:<type>:<id>" with a terminator; returns the length, or 0
+// if it does not fit (the longest URI is 39 characters)
+size_t spotify_format(const SpotifyRef& ref, char* out, size_t cap);
+
+const char* spotify_type_name(SpotifyType type);
+
+// spotamp --bench-uri [n]: std::regex (as handle_paste used to) vs this parser
+void spotify_uri_benchmark(int n);
+// spotamp --fuzz-uri [n]: random and mutated inputs against invariants and a
+// regex reference; returns the number of failures
+int spotify_uri_fuzz(int n);
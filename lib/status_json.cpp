@@ -0,0 +1,643 @@
+#include "status_json.h"
+#include "cJSON.h"
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// ============================
+// JsonPull
+// ============================
+static constexpr int MAX_DEPTH = 32;
+
+JsonPull::JsonPull(const char* text, size_t len)
+    : p(text),
+      end(text + len)
+{
+}
+
+void JsonPull::ws() {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        p++;
+}
+
+bool JsonPull::expect(char c) {
+    ws();
+    if (p >= end || *p != c)
+        return fail();
+    p++;
+    return true;
+}
+
+JsonPull::Type JsonPull::peek() {
+    ws();
+    if (error) return INVALID;
+    if (p >= end) return END;
+    switch (*p) {
+        case '{': return OBJECT;
+        case '[': return ARRAY;
+        case '"': return STRING;
+        case 't': case 'f': return BOOL;
+        case 'n': return NUL;
+        case '-': return NUMBER;
+        default:  return (*p >= '0' && *p <= '9') ? NUMBER : INVALID;
+    }
+}
+
+bool JsonPull::beginObject() {
+    if (!expect('{')) return false;
+    first = true;
+    return true;
+}
+
+bool JsonPull::nextKey(const char*& key, size_t& keyLen) {
+    ws();
+    if (p >= end) return fail();
+    if (*p == '}') {
+        p++;
+        first = false;
+        return false;
+    }
+    if (first) {
+        first = false;
+    } else if (*p == ',') {
+        p++;
+        ws();
+    } else {
+        return fail();
+    }
+
+    // keys are matched raw; none of ours need unescaping
+    if (p >= end || *p != '"') return fail();
+    key = ++p;
+    while (p < end && *p != '"') {
+        if (*p == '\\') p++;
+        p++;
+    }
+    if (p >= end) return fail();
+    keyLen = (size_t)(p - key);
+    p++;
+    return expect(':');
+}
+
+bool JsonPull::beginArray() {
+    if (!expect('[')) return false;
+    first = true;
+    return true;
+}
+
+bool JsonPull::nextElement() {
+    ws();
+    if (p >= end) return fail();
+    if (*p == ']') {
+        p++;
+        first = false;
+        return false;
+    }
+    if (first) {
+        first = false;
+        return true;
+    }
+    if (*p != ',') return fail();
+    p++;
+    return true;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back((char)cp);
+    } else if (cp < 0x800) {
+        out.push_back((char)(0xC0 | (cp >> 6)));
+        out.push_back((char)(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back((char)(0xE0 | (cp >> 12)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back((char)(0xF0 | (cp >> 18)));
+        out.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+bool JsonPull::readString(std::string& out) {
+    if (!expect('"')) return false;
+    out.clear();
+
+    for (;;) {
+        // copy unescaped runs in one go
+        const char* run = p;
+        while (p < end && *p != '"' && *p != '\\')
+            p++;
+        out.append(run, (size_t)(p - run));
+        if (p >= end) return fail();
+        if (*p == '"') {
+            p++;
+            return true;
+        }
+
+        if (++p >= end) return fail();
+        char c = *p++;
+        switch (c) {
+            case '"':  out.push_back('"');  break;
+            case '\\': out.push_back('\\'); break;
+            case '/':  out.push_back('/');  break;
+            case 'b':  out.push_back('\b'); break;
+            case 'f':  out.push_back('\f'); break;
+            case 'n':  out.push_back('\n'); break;
+            case 'r':  out.push_back('\r'); break;
+            case 't':  out.push_back('\t'); break;
+            case 'u': {
+                uint32_t cp = 0;
+                for (int pass = 0; pass < 2; pass++) {
+                    if (end - p < 4) return fail();
+                    uint32_t unit = 0;
+                    for (int i = 0; i < 4; i++) {
+                        int h = hex_value(p[i]);
+                        if (h < 0) return fail();
+                        unit = unit * 16 + (uint32_t)h;
+                    }
+                    p += 4;
+
+                    if (pass == 0) {
+                        cp = unit;
+                        // high surrogate: the low half must follow as \uXXXX
+                        if (unit < 0xD800 || unit > 0xDBFF)
+                            break;
+                        if (end - p < 2 || p[0] != '\\' || p[1] != 'u')
+                            return fail();
+                        p += 2;
+                    } else {
+                        if (unit < 0xDC00 || unit > 0xDFFF)
+                            return fail();
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (unit - 0xDC00);
+                    }
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                return fail();
+        }
+    }
+}
+
+bool JsonPull::readInt(int& out) {
+    ws();
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        p++;
+    }
+    if (p >= end || *p < '0' || *p > '9') return fail();
+
+    long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (v < INT_MAX) v = v * 10 + (*p - '0');
+        p++;
+    }
+    // fraction / exponent: consumed, not applied
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') p++;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) p++;
+        while (p < end && *p >= '0' && *p <= '9') p++;
+    }
+
+    if (v > INT_MAX) v = INT_MAX;
+    out = negative ? -(int)v : (int)v;
+    return true;
+}
+
+bool JsonPull::readLiteral(const char* lit, size_t n) {
+    if ((size_t)(end - p) < n || std::memcmp(p, lit, n) != 0)
+        return fail();
+    p += n;
+    return true;
+}
+
+bool JsonPull::readBool(bool& out) {
+    ws();
+    if (p < end && *p == 't') {
+        out = true;
+        return readLiteral("true", 4);
+    }
+    out = false;
+    return readLiteral("false", 5);
+}
+
+bool JsonPull::skipString() {
+    if (!expect('"')) return false;
+    while (p < end && *p != '"') {
+        if (*p == '\\') p++;
+        p++;
+    }
+    if (p >= end) return fail();
+    p++;
+    return true;
+}
+
+bool JsonPull::skipValue(int depth) {
+    if (depth > MAX_DEPTH) return fail();
+
+    const char* key;
+    size_t keyLen;
+    bool b;
+    int n;
+
+    switch (peek()) {
+        case OBJECT:
+            if (!beginObject()) return false;
+            while (nextKey(key, keyLen))
+                if (!skipValue(depth + 1)) return false;
+            return !error;
+        case ARRAY:
+            if (!beginArray()) return false;
+            while (nextElement())
+                if (!skipValue(depth + 1)) return false;
+            return !error;
+        case STRING: return skipString();
+        case NUMBER: return readInt(n);
+        case BOOL:   return readBool(b);
+        case NUL:    return readLiteral("null", 4);
+        default:     return fail();
+    }
+}
+
+bool JsonPull::skip() {
+    return skipValue(0);
+}
+
+// ============================
+// Message schema
+// ============================
+enum FieldId {
+    F_TYPE, F_TRACK, F_URI, F_NAME, F_ARTISTS, F_ALBUM, F_COVER, F_POSITION,
+    F_DURATION, F_VOLUME, F_VOLUME_MAX, F_VALUE, F_SHUFFLE, F_PAUSED, F_STOPPED
+};
+
+struct FieldSpec {
+    const char* key;
+    size_t len;
+    FieldId id;
+};
+
+#define FIELD(k, id) { k, sizeof(k) - 1, id }
+
+// Every key SpotAmp reads from /status, /player/volume and /events;
+// anything else is skipped without being decoded
+static const FieldSpec schema[] = {
+    FIELD("type",            F_TYPE),
+    FIELD("track",           F_TRACK),
+    FIELD("data",            F_TRACK),
+    FIELD("uri",             F_URI),
+    FIELD("name",            F_NAME),
+    FIELD("artist_names",    F_ARTISTS),
+    FIELD("album_name",      F_ALBUM),
+    FIELD("album_cover_url", F_COVER),
+    FIELD("position",        F_POSITION),
+    FIELD("duration",        F_DURATION),
+    FIELD("volume",          F_VOLUME),
+    FIELD("volume_steps",    F_VOLUME_MAX),
+    FIELD("max",             F_VOLUME_MAX),
+    FIELD("value",           F_VALUE),
+    FIELD("shuffle_context", F_SHUFFLE),
+    FIELD("paused",          F_PAUSED),
+    FIELD("stopped",         F_STOPPED),
+};
+
+#undef FIELD
+
+static const FieldSpec* find_field(const char* key, size_t len) {
+    for (const FieldSpec& f : schema)
+        if (f.len == len && std::memcmp(f.key, key, len) == 0)
+            return &f;
+    return nullptr;
+}
+
+ApiMessage::ApiMessage() {
+    // sized for typical track metadata so steady-state parses never grow them
+    type.reserve(32);
+    uri.reserve(64);
+    name.reserve(128);
+    artists.reserve(128);
+    album.reserve(128);
+    cover.reserve(128);
+}
+
+// Wrong-typed values (e.g. "track": null) are skipped, like a failed
+// cJSON_IsX() check
+static bool read_string(JsonPull& in, std::string& out, ApiMessage& msg, uint32_t flag) {
+    if (in.peek() != JsonPull::STRING) return in.skip();
+    if (!in.readString(out)) return false;
+    msg.has |= flag;
+    return true;
+}
+
+static bool read_int(JsonPull& in, int& out, ApiMessage& msg, uint32_t flag) {
+    if (in.peek() != JsonPull::NUMBER) return in.skip();
+    if (!in.readInt(out)) return false;
+    msg.has |= flag;
+    return true;
+}
+
+static bool read_bool(JsonPull& in, bool& out, ApiMessage& msg, uint32_t flag) {
+    if (in.peek() != JsonPull::BOOL) return in.skip();
+    if (!in.readBool(out)) return false;
+    msg.has |= flag;
+    return true;
+}
+
+static bool read_artists(JsonPull& in, ApiMessage& msg) {
+    if (in.peek() != JsonPull::ARRAY) return in.skip();
+    if (!in.beginArray()) return false;
+
+    // join in place; a thread_local scratch keeps its capacity too
+    static thread_local std::string one;
+    msg.artists.clear();
+    while (in.nextElement()) {
+        if (in.peek() != JsonPull::STRING) {
+            if (!in.skip()) return false;
+            continue;
+        }
+        if (!in.readString(one)) return false;
+        if (!msg.artists.empty()) msg.artists += ", ";
+        msg.artists += one;
+    }
+    msg.has |= ApiMessage::HAS_ARTISTS;
+    return !in.failed();
+}
+
+static bool read_object(JsonPull& in, ApiMessage& msg, int depth) {
+    if (!in.beginObject()) return false;
+
+    const char* key;
+    size_t keyLen;
+    while (in.nextKey(key, keyLen)) {
+        const FieldSpec* f = find_field(key, keyLen);
+        if (!f) {
+            if (!in.skip()) return false;
+            continue;
+        }
+
+        bool ok;
+        switch (f->id) {
+            case F_TYPE:       ok = read_string(in, msg.type,    msg, ApiMessage::HAS_TYPE);    break;
+            case F_TRACK:
+                // only one level: /status.track or event.data
+                if (depth == 0 && in.peek() == JsonPull::OBJECT) {
+                    msg.has |= ApiMessage::HAS_TRACK;
+                    ok = read_object(in, msg, depth + 1);
+                } else {
+                    ok = in.skip();
+                }
+                break;
+            case F_URI:        ok = read_string(in, msg.uri,     msg, ApiMessage::HAS_URI);     break;
+            case F_NAME:       ok = read_string(in, msg.name,    msg, ApiMessage::HAS_NAME);    break;
+            case F_ARTISTS:    ok = read_artists(in, msg);                                      break;
+            case F_ALBUM:      ok = read_string(in, msg.album,   msg, ApiMessage::HAS_ALBUM);   break;
+            case F_COVER:      ok = read_string(in, msg.cover,   msg, ApiMessage::HAS_COVER);   break;
+            case F_POSITION:   ok = read_int(in, msg.position,   msg, ApiMessage::HAS_POSITION); break;
+            case F_DURATION:   ok = read_int(in, msg.duration,   msg, ApiMessage::HAS_DURATION); break;
+            case F_VOLUME:     ok = read_int(in, msg.volume,     msg, ApiMessage::HAS_VOLUME);  break;
+            case F_VOLUME_MAX: ok = read_int(in, msg.volumeMax,  msg, ApiMessage::HAS_VOLUME_MAX); break;
+            case F_VALUE:
+                // volume events carry a number, shuffle events a bool
+                ok = in.peek() == JsonPull::BOOL
+                    ? read_bool(in, msg.shuffle, msg, ApiMessage::HAS_SHUFFLE)
+                    : read_int(in, msg.volume, msg, ApiMessage::HAS_VOLUME);
+                break;
+            case F_SHUFFLE:    ok = read_bool(in, msg.shuffle,   msg, ApiMessage::HAS_SHUFFLE); break;
+            case F_PAUSED:     ok = read_bool(in, msg.paused,    msg, ApiMessage::HAS_PAUSED);  break;
+            case F_STOPPED:    ok = read_bool(in, msg.stopped,   msg, ApiMessage::HAS_STOPPED); break;
+            default:           ok = in.skip();                                                  break;
+        }
+        if (!ok) return false;
+    }
+    return !in.failed();
+}
+
+bool json_read_message(const char* text, size_t len, ApiMessage& msg) {
+    msg.reset();
+    JsonPull in(text, len);
+    if (in.peek() != JsonPull::OBJECT) return false;
+    if (!read_object(in, msg, 0)) return false;
+    return in.peek() == JsonPull::END;
+}
+
+// ============================
+// JsonWriter
+// ============================
+JsonWriter::JsonWriter(char* buf_, size_t cap_)
+    : buf(buf_),
+      cap(cap_)
+{
+    put('{');
+}
+
+void JsonWriter::put(char c) {
+    // one byte is always kept for the terminator, and one for the closing
+    // brace until c_str() writes it, so ok() holds for the finished object
+    size_t spare = closed ? 1 : 2;
+    if (len + spare < cap) buf[len++] = c;
+    else overflow = true;
+}
+
+void JsonWriter::put(const char* s) {
+    while (*s) put(*s++);
+}
+
+void JsonWriter::key(const char* k) {
+    if (len > 1) put(',');
+    put('"');
+    put(k);
+    put('"');
+    put(':');
+}
+
+JsonWriter& JsonWriter::field(const char* k, int value) {
+    key(k);
+    char digits[16];
+    std::snprintf(digits, sizeof(digits), "%d", value);
+    put(digits);
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* k, bool value) {
+    key(k);
+    put(value ? "true" : "false");
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* k, const char* value) {
+    key(k);
+    put('"');
+    for (const char* s = value; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            put('\\');
+            put((char)c);
+        } else if (c < 0x20) {
+            char esc[8];
+            std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+            put(esc);
+        } else {
+            put((char)c);
+        }
+    }
+    put('"');
+    return *this;
+}
+
+const char* JsonWriter::c_str() {
+    if (!closed) {
+        closed = true;
+        put('}');
+    }
+    if (cap > 0) buf[len < cap ? len : cap - 1] = '\0';
+    return buf;
+}
+
+// ============================
+// Benchmark
+// ============================
+// Recorded go-librespot payloads
+static const char* benchStatus =
+    "{\"username\":\"spotamp\",\"device_id\":\"5f1c0e4f3a6b2d9e8c7b6a5f4e3d2c1b0a998877\","
+    "\"device_type\":\"computer\",\"device_name\":\"go-librespot\",\"volume_steps\":100,"
+    "\"volume\":64,\"repeat_context\":false,\"repeat_track\":false,\"shuffle_context\":true,"
+    "\"stopped\":false,\"paused\":false,\"buffering\":false,\"play_origin\":\"go-librespot\","
+    "\"track\":{\"uri\":\"spotify:track:4uLU6hMCjMI75M1A2tKUQC\",\"name\":\"Never Gonna Give You Up\","
+    "\"artist_names\":[\"Rick Astley\"],\"album_name\":\"Whenever You Need Somebody\","
+    "\"album_cover_url\":\"https://i.scdn.co/image/ab67616d0000b2735755e164993798e0c9ef7d7a\","
+    "\"position\":73214,\"duration\":213573,\"release_date\":\"1987-11-12\","
+    "\"track_number\":1,\"disc_number\":1}}";
+
+static const char* benchMetadata =
+    "{\"type\":\"metadata\",\"data\":{\"context_uri\":\"spotify:playlist:37i9dQZF1DXcBWIGoYBM5M\","
+    "\"uri\":\"spotify:track:0VjIjW4GlUZAMYd2vXMi3b\",\"name\":\"Blinding Lights\","
+    "\"artist_names\":[\"The Weeknd\"],\"album_name\":\"After Hours\","
+    "\"album_cover_url\":\"https://i.scdn.co/image/ab67616d0000b2738863bc11d2aa12b54f5aeb36\","
+    "\"position\":0,\"duration\":200040,\"release_date\":\"2020-03-20\",\"track_number\":9,"
+    "\"disc_number\":1}}";
+
+static const char* benchVolume = "{\"type\":\"volume\",\"data\":{\"value\":42,\"max\":100}}";
+
+// What the cJSON path did per payload: full DOM, then lookups
+static void cjson_read_message(const char* text, ApiMessage& msg) {
+    msg.reset();
+    cJSON* root = cJSON_Parse(text);
+    if (!root) return;
+
+    cJSON* type = cJSON_GetObjectItem(root, "type");
+    if (cJSON_IsString(type)) { msg.type = type->valuestring; msg.has |= ApiMessage::HAS_TYPE; }
+
+    cJSON* track = cJSON_GetObjectItem(root, "track");
+    if (!track) track = cJSON_GetObjectItem(root, "data");
+    if (cJSON_IsObject(track)) {
+        msg.has |= ApiMessage::HAS_TRACK;
+        cJSON* item;
+        if (cJSON_IsString(item = cJSON_GetObjectItem(track, "uri")))  { msg.uri = item->valuestring;  msg.has |= ApiMessage::HAS_URI; }
+        if (cJSON_IsString(item = cJSON_GetObjectItem(track, "name"))) { msg.name = item->valuestring; msg.has |= ApiMessage::HAS_NAME; }
+        if (cJSON_IsArray(item = cJSON_GetObjectItem(track, "artist_names"))) {
+            msg.artists.clear();
+            int n = cJSON_GetArraySize(item);
+            for (int i = 0; i < n; i++) {
+                cJSON* a = cJSON_GetArrayItem(item, i);
+                if (!cJSON_IsString(a)) continue;
+                if (!msg.artists.empty()) msg.artists += ", ";
+                msg.artists += a->valuestring;
+            }
+            msg.has |= ApiMessage::HAS_ARTISTS;
+        }
+        if (cJSON_IsString(item = cJSON_GetObjectItem(track, "album_name")))      { msg.album = item->valuestring; msg.has |= ApiMessage::HAS_ALBUM; }
+        if (cJSON_IsString(item = cJSON_GetObjectItem(track, "album_cover_url"))) { msg.cover = item->valuestring; msg.has |= ApiMessage::HAS_COVER; }
+        if (cJSON_IsNumber(item = cJSON_GetObjectItem(track, "position"))) { msg.position = item->valueint; msg.has |= ApiMessage::HAS_POSITION; }
+        if (cJSON_IsNumber(item = cJSON_GetObjectItem(track, "duration"))) { msg.duration = item->valueint; msg.has |= ApiMessage::HAS_DURATION; }
+        if (cJSON_IsNumber(item = cJSON_GetObjectItem(track, "value")))    { msg.volume = item->valueint;   msg.has |= ApiMessage::HAS_VOLUME; }
+        if (cJSON_IsNumber(item = cJSON_GetObjectItem(track, "max")))      { msg.volumeMax = item->valueint; msg.has |= ApiMessage::HAS_VOLUME_MAX; }
+    }
+
+    cJSON* item;
+    if (cJSON_IsNumber(item = cJSON_GetObjectItem(root, "volume")))       { msg.volume = item->valueint;    msg.has |= ApiMessage::HAS_VOLUME; }
+    if (cJSON_IsNumber(item = cJSON_GetObjectItem(root, "volume_steps"))) { msg.volumeMax = item->valueint; msg.has |= ApiMessage::HAS_VOLUME_MAX; }
+    if (cJSON_IsBool(item = cJSON_GetObjectItem(root, "shuffle_context"))) { msg.shuffle = cJSON_IsTrue(item); msg.has |= ApiMessage::HAS_SHUFFLE; }
+    if (cJSON_IsBool(item = cJSON_GetObjectItem(root, "paused")))  { msg.paused = cJSON_IsTrue(item);  msg.has |= ApiMessage::HAS_PAUSED; }
+    if (cJSON_IsBool(item = cJSON_GetObjectItem(root, "stopped"))) { msg.stopped = cJSON_IsTrue(item); msg.has |= ApiMessage::HAS_STOPPED; }
+
+    cJSON_Delete(root);
+}
+
+static bool same_message(const ApiMessage& a, const ApiMessage& b) {
+    return a.has == b.has && a.type == b.type && a.uri == b.uri && a.name == b.name &&
+           a.artists == b.artists && a.album == b.album && a.cover == b.cover &&
+           a.position == b.position && a.duration == b.duration && a.volume == b.volume &&
+           a.volumeMax == b.volumeMax && a.shuffle == b.shuffle && a.paused == b.paused &&
+           a.stopped == b.stopped;
+}
+
+template <typename Fn>
+static double time_ns(int n, Fn fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        fn();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+}
+
+void json_parse_benchmark(int n) {
+    struct Payload { const char* name; const char* text; };
+    const Payload payloads[] = {
+        { "/status        ", benchStatus },
+        { "metadata event ", benchMetadata },
+        { "volume event   ", benchVolume },
+    };
+
+    ApiMessage a, b;
+    std::cout << "JSON parse x" << n << " (ns per payload)" << std::endl;
+    for (const Payload& pl : payloads) {
+        size_t len = std::strlen(pl.text);
+
+        cjson_read_message(pl.text, a);
+        bool ok = json_read_message(pl.text, len, b);
+        if (!ok || !same_message(a, b))
+            std::cout << "  " << pl.name << " MISMATCH between parsers" << std::endl;
+
+        double dom  = time_ns(n, [&] { cjson_read_message(pl.text, a); });
+        double pull = time_ns(n, [&] { json_read_message(pl.text, len, b); });
+        std::cout << "  " << pl.name << " cJSON " << dom << "  pull " << pull
+                  << "  (" << (pull > 0 ? dom / pull : 0.0) << "x)" << std::endl;
+    }
+
+    // command bodies: DOM + print + free vs stack buffer
+    volatile size_t sink = 0;
+    double dom = time_ns(n, [&] {
+        cJSON* root = cJSON_CreateObject();
+        cJSON_AddNumberToObject(root, "position", 73214);
+        cJSON_AddBoolToObject(root, "relative", false);
+        char* json = cJSON_PrintUnformatted(root);
+        sink = sink + std::strlen(json);
+        cJSON_free(json);
+        cJSON_Delete(root);
+    });
+    double stack = time_ns(n, [&] {
+        char buf[64];
+        JsonWriter w(buf, sizeof(buf));
+        w.field("position", 73214).field("relative", false);
+        sink = sink + std::strlen(w.c_str());
+    });
+    std::cout << "  seek body       cJSON " << dom << "  stack " << stack
+              << "  (" << (stack > 0 ? dom / stack : 0.0) << "x)" << std::endl;
+}
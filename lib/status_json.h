@@ -0,0 +1,134 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// ============================
+// Pull parser
+// ============================
+// Forward-only tokenizer over a JSON text. Nothing is built: the caller asks
+// for the next key / value and skips whatever it does not care about. Keys
+// are returned as views into the input, strings are unescaped into a
+// caller-owned std::string (cleared, capacity kept), so parsing into
+// long-lived buffers allocates nothing once they have grown.
+class JsonPull {
+public:
+    enum Type { END, OBJECT, ARRAY, STRING, NUMBER, BOOL, NUL, INVALID };
+
+    JsonPull(const char* text, size_t len);
+
+    Type peek();
+    bool failed() const { return error; }
+
+    // Objects: beginObject(), then nextKey() until it returns false
+    bool beginObject();
+    bool nextKey(const char*& key, size_t& keyLen);
+
+    // Arrays: beginArray(), then nextElement() until it returns false
+    bool beginArray();
+    bool nextElement();
+
+    bool readString(std::string& out);
+    bool readInt(int& out);        // fractions are truncated like cJSON's valueint
+    bool readBool(bool& out);
+    bool skip();                   // any value, including nested containers
+
+private:
+    void ws();
+    bool fail() { error = true; return false; }
+    bool expect(char c);
+    bool skipString();
+    bool skipValue(int depth);
+    bool readLiteral(const char* lit, size_t n);
+
+    const char* p;
+    const char* end;
+    bool error = false;
+    bool first = false;            // no separator expected before the next member
+};
+
+// ============================
+// go-librespot messages
+// ============================
+// The subset of /status, /player/volume and /events payloads SpotAmp uses,
+// flattened into one preallocated record. `has` tells which fields the
+// payload carried; the caller decides what they mean (e.g. an event's
+// "value" is a volume or a shuffle flag depending on its type).
+struct ApiMessage {
+    enum Field : uint32_t {
+        HAS_TYPE       = 1 << 0,
+        HAS_TRACK      = 1 << 1,  // a track / data object was present
+        HAS_URI        = 1 << 2,
+        HAS_NAME       = 1 << 3,
+        HAS_ARTISTS    = 1 << 4,
+        HAS_ALBUM      = 1 << 5,
+        HAS_COVER      = 1 << 6,
+        HAS_POSITION   = 1 << 7,
+        HAS_DURATION   = 1 << 8,
+        HAS_VOLUME     = 1 << 9,  // "volume" or a numeric "value"
+        HAS_VOLUME_MAX = 1 << 10, // "volume_steps" or "max"
+        HAS_SHUFFLE    = 1 << 11, // "shuffle_context" or a boolean "value"
+        HAS_PAUSED     = 1 << 12,
+        HAS_STOPPED    = 1 << 13
+    };
+
+    uint32_t has = 0;
+
+    std::string type;
+    std::string uri;
+    std::string name;
+    std::string artists;          // artist_names joined with ", "
+    std::string album;
+    std::string cover;
+
+    int position  = 0;
+    int duration  = 0;
+    int volume    = 0;
+    int volumeMax = 0;
+    bool shuffle  = false;
+    bool paused   = false;
+    bool stopped  = false;
+
+    ApiMessage();
+
+    // forget the previous payload but keep the string buffers
+    void reset() { has = 0; }
+};
+
+// Parses any of the three payload shapes into msg. False on malformed JSON,
+// in which case msg must not be applied.
+bool json_read_message(const char* text, size_t len, ApiMessage& msg);
+
+// ============================
+// Stack-buffer writer
+// ============================
+// Builds small flat command bodies ({"volume":40,"relative":false}) in a
+// caller-provided buffer. ok() is false if the buffer was too small.
+class JsonWriter {
+public:
+    JsonWriter(char* buf, size_t cap);
+
+    JsonWriter& field(const char* key, int value);
+    JsonWriter& field(const char* key, bool value);
+    JsonWriter& field(const char* key, const char* value);
+
+    const char* c_str();
+    size_t size() const { return len; }
+    bool ok() const { return !overflow; }
+
+private:
+    void put(char c);
+    void put(const char* s);
+    void key(const char* k);
+
+    char* buf;
+    size_t cap;
+    size_t len = 0;
+    bool overflow = false;
+    bool closed = false;
+};
+
+// Times the cJSON DOM path against the pull parser on recorded payloads and
+// prints both (spotamp --bench-json [n])
+void json_parse_benchmark(int n);
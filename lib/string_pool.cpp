@@ -0,0 +1,61 @@
+#include "string_pool.h"
+
+#include <cstring>
+
+// ============================
+// StringPool
+// ============================
+StringPool::StringPool()
+    : chunks(new std::unique_ptr<char[]>[MAX_CHUNKS])
+{
+    // handle 0: the empty string at the start of chunk 0
+    chunks[0].reset(new char[CHUNK_SIZE]);
+    chunkCount = 1;
+    std::memset(chunks[0].get(), 0, 2);
+    used = 2;
+    lookup.emplace(std::string_view(), 0);
+}
+
+StringPool::Handle StringPool::intern(std::string_view s) {
+    if (s.size() > MAX_LENGTH)
+        s = s.substr(0, MAX_LENGTH);
+
+    auto it = lookup.find(s);
+    if (it != lookup.end())
+        return it->second;
+
+    // [u16 length][bytes]
+    uint32_t need = (uint32_t)(2 + s.size());
+    if (used + need > CHUNK_SIZE) {
+        if (chunkCount >= MAX_CHUNKS)
+            return 0;
+        chunks[chunkCount].reset(new char[CHUNK_SIZE]);
+        chunkCount++;
+        used = 0;
+    }
+
+    char* at = chunks[chunkCount - 1].get() + used;
+    uint16_t len = (uint16_t)s.size();
+    std::memcpy(at, &len, 2);
+    std::memcpy(at + 2, s.data(), s.size());
+
+    Handle h = ((Handle)(chunkCount - 1) << CHUNK_BITS) | used;
+    used += need;
+    lookup.emplace(std::string_view(at + 2, s.size()), h);
+    return h;
+}
+
+bool StringPool::find(std::string_view s, Handle& out) const {
+    auto it = lookup.find(s.substr(0, MAX_LENGTH));
+    if (it == lookup.end())
+        return false;
+    out = it->second;
+    return true;
+}
+
+std::string_view StringPool::get(Handle h) const {
+    const char* at = chunks[h >> CHUNK_BITS].get() + (h & (CHUNK_SIZE - 1));
+    uint16_t len;
+    std::memcpy(&len, at, 2);
+    return std::string_view(at + 2, len);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string_view>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+// ============================
+// Interned string pool
+// ============================
+// Append-only: every distinct string is stored once in fixed 1 MiB chunks
+// and named by a 32-bit handle (chunk << 20 | offset). Bytes never move, so
+// other threads may read any handle they were given while the owner thread
+// keeps interning. Handle 0 is the empty string.
+class StringPool {
+public:
+    using Handle = uint32_t;
+
+    StringPool();
+
+    // owner thread only
+    Handle intern(std::string_view s);
+    // owner thread only; false if s was never interned
+    bool find(std::string_view s, Handle& out) const;
+
+    // any thread
+    std::string_view get(Handle h) const;
+
+    // expected number of distinct strings (avoids rehashing on bulk loads)
+    void reserve(size_t n) { lookup.reserve(n); }
+
+    size_t bytes() const { return (size_t)chunkCount << CHUNK_BITS; }
+
+private:
+    static constexpr int CHUNK_BITS = 20;
+    static constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+    static constexpr int MAX_CHUNKS = 1 << (32 - CHUNK_BITS);
+    static constexpr size_t MAX_LENGTH = 0xFFFF;  // longer strings are truncated
+
+    std::unique_ptr<std::unique_ptr<char[]>[]> chunks;
+    int chunkCount = 0;
+    uint32_t used = 0;
+
+    std::unordered_map<std::string_view, Handle> lookup;
+};
@@ -0,0 +1,194 @@
+#include "waveform_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+// ============================
+// File format
+// ============================
+// "SPWF", u32 version, u32 duration ms, u32 buckets, then per bucket int8 lo,
+// int8 hi (sample / 256) and u8 RMS (full scale = 255). Little-endian.
+
+static const char FILE_MAGIC[4] = {'S', 'P', 'W', 'F'};
+static constexpr int DURATION_SLACK_MS = 1000;   // same track, re-encoded
+
+static uint32_t read_u32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+WaveformCache::WaveformCache(const std::string& dir_) : dir(dir_) {
+}
+
+WaveformCache::~WaveformCache() {
+    save();
+}
+
+// <dir>/<track id>.wave; only plain ids, so a URI cannot name a path
+std::string WaveformCache::filePath(const std::string& u) const {
+    size_t colon = u.rfind(':');
+    std::string id = colon == std::string::npos ? u : u.substr(colon + 1);
+    if (id.empty() || id.size() > 64)
+        return std::string();
+    for (char c : id)
+        if (!std::isalnum((unsigned char)c))
+            return std::string();
+    return dir + "/" + id + ".wave";
+}
+
+void WaveformCache::setTrack(const std::string& u, int duration) {
+    if (u == uri) {
+        if (duration > 0 && duration != durationMs) {
+            // the file was mapped before the duration was known
+            if (stored && stored != merged.data() &&
+                std::abs((int)read_u32((const uint8_t*)file.data() + 8) - duration) > DURATION_SLACK_MS) {
+                file.close();
+                stored = nullptr;
+            }
+            durationMs = duration;
+        }
+        return;
+    }
+
+    save();
+    uri = u;
+    durationMs = duration;
+    path = filePath(u);
+    file.close();
+    stored = nullptr;
+    merged.clear();
+    lo.assign(BUCKETS, 32767);
+    hi.assign(BUCKETS, -32768);
+    sumSquares.assign(BUCKETS, 0.0f);
+    blocks.assign(BUCKETS, 0);
+    dirty = false;
+
+    if (path.empty() || !file.open(path))
+        return;
+    const uint8_t* d = (const uint8_t*)file.data();
+    bool valid = file.size() == HEADER_SIZE + 3 * (size_t)BUCKETS && std::memcmp(d, FILE_MAGIC, 4) == 0 &&
+                 read_u32(d + 4) == VERSION && read_u32(d + 12) == (uint32_t)BUCKETS &&
+                 (duration <= 0 || std::abs((int)read_u32(d + 8) - duration) <= DURATION_SLACK_MS);
+    if (valid)
+        stored = d + HEADER_SIZE;
+    else
+        file.close();
+}
+
+void WaveformCache::add(int positionMs, int16_t blockLo, int16_t blockHi, float meanSquare) {
+    if (durationMs <= 0 || positionMs < 0 || positionMs >= durationMs)
+        return;
+    int i = (int)((int64_t)positionMs * BUCKETS / durationMs);
+    if (stored && (int8_t)stored[i * 3] <= (int8_t)stored[i * 3 + 1])
+        return; // already known from an earlier play
+    lo[i] = std::min(lo[i], blockLo);
+    hi[i] = std::max(hi[i], blockHi);
+    sumSquares[i] += meanSquare;
+    blocks[i]++;
+    dirty = true;
+}
+
+bool WaveformCache::bucket(int i, float& l, float& h, float& rms) const {
+    if (blocks[i] > 0) {
+        l = lo[i] / 32768.0f;
+        h = hi[i] / 32768.0f;
+        rms = std::sqrt(sumSquares[i] / blocks[i]);
+        return true;
+    }
+    if (!stored)
+        return false;
+    int8_t sl = (int8_t)stored[i * 3], sh = (int8_t)stored[i * 3 + 1];
+    if (sl > sh)
+        return false;
+    l = sl / 128.0f;
+    h = sh / 128.0f;
+    rms = stored[i * 3 + 2] / 255.0f;
+    return true;
+}
+
+bool WaveformCache::columns(int width, std::vector<Column>& out) const {
+    out.resize(std::max(0, width));
+    if (uri.empty() || width <= 0)
+        return false;
+    bool any = false;
+    for (int c = 0; c < width; c++) {
+        int b0 = c * BUCKETS / width;
+        int b1 = std::max(b0 + 1, (c + 1) * BUCKETS / width);
+        Column col{1.0f, -1.0f, 0.0f};
+        int n = 0;
+        for (int b = b0; b < b1 && b < BUCKETS; b++) {
+            float l, h, r;
+            if (!bucket(b, l, h, r))
+                continue;
+            col.lo = std::min(col.lo, l);
+            col.hi = std::max(col.hi, h);
+            col.rms += r;
+            n++;
+        }
+        if (n > 0) {
+            col.rms /= n;
+            any = true;
+        }
+        out[c] = col;
+    }
+    return any;
+}
+
+float WaveformCache::coverage() const {
+    if (uri.empty())
+        return 0.0f;
+    int known = 0;
+    float l, h, r;
+    for (int i = 0; i < BUCKETS; i++)
+        if (bucket(i, l, h, r))
+            known++;
+    return known / (float)BUCKETS;
+}
+
+bool WaveformCache::save() {
+    if (!dirty || path.empty() || durationMs <= 0)
+        return true;
+
+    std::vector<uint8_t> out(HEADER_SIZE + 3 * (size_t)BUCKETS);
+    uint32_t header[3] = {VERSION, (uint32_t)durationMs, (uint32_t)BUCKETS};
+    std::memcpy(out.data(), FILE_MAGIC, 4);
+    std::memcpy(out.data() + 4, header, sizeof(header));
+    uint8_t* b = out.data() + HEADER_SIZE;
+    for (int i = 0; i < BUCKETS; i++, b += 3) {
+        if (blocks[i] > 0) {
+            b[0] = (uint8_t)(int8_t)(lo[i] >> 8);
+            b[1] = (uint8_t)(int8_t)(hi[i] >> 8);
+            b[2] = (uint8_t)std::min(255.0f, std::sqrt(sumSquares[i] / blocks[i]) * 255.0f + 0.5f);
+        } else if (stored) {
+            std::memcpy(b, stored + i * 3, 3);
+        } else {
+            b[0] = UNKNOWN_LO;
+            b[1] = 0x80;
+            b[2] = 0;
+        }
+    }
+
+    // the merged copy replaces the mapping (Windows cannot replace a mapped file)
+    merged.assign(out.begin() + HEADER_SIZE, out.end());
+    stored = merged.data();
+    file.close();
+    std::fill(blocks.begin(), blocks.end(), 0);
+    dirty = false;
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    std::string tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f)
+        return false;
+    bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok)
+        return false;
+    return replace_file(tmp, path);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "mapped_file.h"
+
+// ============================
+// Track waveform cache
+// ============================
+// A whole-track overview for the seek bar: BUCKETS slices of the track, each
+// with min / max / RMS, learned from the PCM as it plays. Each track's
+// summary is a 3 KB file named after its Spotify id; playing the track again
+// maps the file and shows the overview at once, and slices that were not
+// heard before (skipped parts) are filled in and saved with it.
+class WaveformCache {
+public:
+    static constexpr int BUCKETS = 1024;
+
+    // lo / hi in -1..1, rms in 0..1; lo > hi where nothing is known
+    struct Column {
+        float lo, hi, rms;
+    };
+
+    explicit WaveformCache(const std::string& dir);
+    ~WaveformCache();
+
+    // Switches to uri, saving what was learned about the previous track.
+    // Same uri with a new duration only updates the duration.
+    void setTrack(const std::string& uri, int durationMs);
+    // Folds in one audio block that started playing at positionMs
+    void add(int positionMs, int16_t lo, int16_t hi, float meanSquare);
+    // Writes the current track's summary if it learned anything
+    bool save();
+
+    // Summary squeezed into width columns; false if nothing is known yet
+    bool columns(int width, std::vector<Column>& out) const;
+    // Share of the track's buckets known, 0..1
+    float coverage() const;
+
+private:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 16;
+    static constexpr uint8_t UNKNOWN_LO = 0x7F;   // stored lo > hi: not heard
+
+    std::string filePath(const std::string& uri) const;
+    bool bucket(int i, float& lo, float& hi, float& rms) const;
+
+    std::string dir;
+    std::string uri;
+    std::string path;   // empty: not a track we can name a file after
+    int durationMs = 0;
+
+    // what is on disk: 3 bytes per bucket (int8 lo, int8 hi, u8 rms)
+    MappedFile file;
+    const uint8_t* stored = nullptr;
+    std::vector<uint8_t> merged;   // stored after a save, once unmapped
+
+    // heard in this session
+    std::vector<int16_t> lo, hi;
+    std::vector<float> sumSquares;
+    std::vector<uint32_t> blocks;
+    bool dirty = false;
+};
@@ -6,13 +6,13 @@ SpotAmp v0.2
 backend: glfw with opengl2
 
 for linux:
-sudo apt install libglfw3-dev
+sudo apt install libglfw3-dev libjpeg-dev
 
 compile with:
-g++ main.cpp lib/audio_engine.cpp lib/audio_fft.cpp lib/cJSON.c \
+g++ main.cpp lib/audio_engine.cpp lib/audio_fft.cpp lib/quality_governor.cpp lib/frame_pacer.cpp lib/api_connection.cpp lib/control_queue.cpp lib/api_health.cpp lib/event_stream.cpp lib/player_state.cpp lib/status_json.cpp lib/latency_probe.cpp lib/play_queue.cpp lib/queue_feeder.cpp lib/spotify_uri.cpp lib/link_import.cpp lib/playlist.cpp lib/string_pool.cpp lib/search_index.cpp lib/meta_cache.cpp lib/mapped_file.cpp lib/play_history.cpp lib/album_art.cpp lib/waveform_cache.cpp lib/loudness.cpp lib/dynamics.cpp lib/convolver.cpp lib/cJSON.c \
     lib/imgui.cpp lib/imgui_draw.cpp lib/imgui_tables.cpp lib/imgui_widgets.cpp \
     lib/backends/imgui_impl_glfw.cpp lib/backends/imgui_impl_opengl2.cpp \
-    -Ilib -lGL -lglfw -lssl -lcrypto -pthread -lpthread -lm -o spotamp
+    -Ilib -lGL -lglfw -lssl -lcrypto -ljpeg -pthread -lpthread -lm -o spotamp
 
 ./go-librespot --config_dir .
 
@@ -26,16 +26,21 @@ sh spotamp.sh
 #include <GLFW/glfw3.h>
 #include <string>
 #include <cstring>
-#include <regex>
+#include <cstdlib>
 #include <chrono>
+#include <ctime>
 #include <iostream>
+#include <mutex>
 
-// HTTP
-#define CPPHTTPLIB_OPENSSL_SUPPORT //for SSL/HTTPS
-#include "lib/httplib.h"
+// HTTP (keep-alive connections to go-librespot, driven by a command queue)
+#include "lib/control_queue.h"
+// WebSocket event stream
+#include "lib/event_stream.h"
+// Versioned player state
+#include "lib/player_state.h"
 
-// JSON
-#include "lib/cJSON.h"
+// JSON (pull parser / stack writer for API payloads)
+#include "lib/status_json.h"
 
 // ImGui
 #include "lib/imgui.h"
@@ -44,8 +49,33 @@ sh spotamp.sh
 
 // Audio player thread
 #include "lib/audio_engine.h"
+#include "lib/latency_probe.h"
+
+// Local play queue / playlist
+#include "lib/play_queue.h"
+#include "lib/queue_feeder.h"
+#include "lib/playlist.h"
+#include "lib/search_index.h"
+#include "lib/meta_cache.h"
+#include "lib/play_history.h"
+// Cover art
+#include "lib/album_art.h"
+// Seek bar waveform
+#include "lib/waveform_cache.h"
+// Loudness normalization, output compressor / limiter
+#include "lib/loudness.h"
+#include "lib/dynamics.h"
+// Room correction / headphone FIR (--ir)
+#include "lib/convolver.h"
+// Spotify link parsing / bulk import
+#include "lib/spotify_uri.h"
+#include "lib/link_import.h"
 // FFT
 #include "lib/audio_fft.h"
+// Quality governor
+#include "lib/quality_governor.h"
+// Frame pacing
+#include "lib/frame_pacer.h"
 
 // ============================
 // Spotify state
@@ -60,7 +90,108 @@ bool shuffle_initialized = false;
 int track_position_ms = 0;   // current position
 int track_duration_ms = 0;   // total duration
 bool seek_initialized = false;
+bool playback_paused = true;
 
+// Position follows the audio clock (frames actually played) from the last
+// server-reported anchor. Wall-clock extrapolation is the fallback while no
+// audio has come through the pipe (e.g. SpotAmp is not the output device).
+int position_anchor_ms = 0;
+uint64_t position_anchor_frames = 0;
+auto position_anchor_time = std::chrono::steady_clock::now();
+const int drift_snap_ms = 250; // larger server/audio disagreement: jump, smaller: slew
+
+bool audio_clock_running() { return audio_get_frames_played() > 0; }
+
+int frames_to_ms(int64_t frames) {
+    return (int)(frames * 1000 / audio_get_sample_rate());
+}
+
+void set_position(int pos_ms) {
+    track_position_ms = pos_ms;
+    position_anchor_ms = pos_ms;
+    position_anchor_frames = audio_get_frames_played();
+    position_anchor_time = std::chrono::steady_clock::now();
+}
+
+void set_paused(bool paused) {
+    if (paused == playback_paused) return;
+    set_position(track_position_ms); // freeze / restart extrapolation from here
+    playback_paused = paused;
+}
+
+void advance_position() {
+    if (playback_paused || track_duration_ms <= 0) return;
+    int pos;
+    if (audio_clock_running()) {
+        pos = position_anchor_ms + frames_to_ms(audio_get_frames_played() - position_anchor_frames);
+    } else {
+        auto elapsed = std::chrono::steady_clock::now() - position_anchor_time;
+        pos = position_anchor_ms + (int)std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    }
+    track_position_ms = std::min(pos, track_duration_ms);
+}
+
+// Where a snapshot's track is by now: the reported position moved on by the
+// audio clock (wall clock without audio) unless paused
+int snapshot_position_ms(const PlayerState &st) {
+    int pos = st.positionMs;
+    if (!st.paused) {
+        if (audio_clock_running())
+            pos += frames_to_ms((int64_t)(audio_get_frames_played() - st.positionFrames));
+        else
+            pos += (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - st.positionTime).count();
+    }
+    return st.durationMs > 0 ? std::min(pos, st.durationMs) : pos;
+}
+
+// Folds a server position (measured at frames/time) into the anchor
+void correct_position(int server_ms, uint64_t frames, std::chrono::steady_clock::time_point time, bool snap) {
+    int server_now;
+    if (audio_clock_running()) {
+        server_now = server_ms + frames_to_ms(audio_get_frames_played() - frames);
+    } else {
+        server_now = server_ms + (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - time).count();
+    }
+    if (playback_paused)
+        server_now = server_ms;
+
+    advance_position();
+    int error = server_now - track_position_ms;
+    if (snap || error > drift_snap_ms || error < -drift_snap_ms) {
+        set_position(server_now);
+    } else {
+        // small drift: slew a quarter of the way so the bar never jumps
+        position_anchor_ms += error / 4;
+        advance_position();
+    }
+}
+
+// ============================
+// Seek bar waveform
+// ============================
+// Overview of the whole track, learned from the audio as it plays and kept
+// per track, so a replayed track shows it from the start
+WaveformCache waveform("spotamp_waves");
+std::vector<WaveformCache::Column> wave_columns;
+
+// Folds the audio played since the last call into the current track's
+// waveform. Audio played before the position anchor was set (before a seek
+// or track change) cannot be placed and is dropped.
+void feed_waveform() {
+    AudioLevels levels[256];
+    size_t n;
+    while ((n = audio_read_levels(levels, 256)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            const AudioLevels &l = levels[i];
+            if (l.firstFrame < position_anchor_frames)
+                continue;
+            int ms = position_anchor_ms + frames_to_ms((int64_t)(l.firstFrame - position_anchor_frames));
+            waveform.add(ms, l.min, l.max, l.meanSquare);
+        }
+    }
+}
 
 std::string full_text;
 std::string display_text;
@@ -69,165 +200,1133 @@ size_t display_width = 43;
 auto scroll_last = std::chrono::steady_clock::now();
 const int scroll_ms = 300;
 
+// ============================
+// Power saving
+// ============================
+// When the window is hidden nothing is rendered; when it is visible but
+// unfocused the visualizer is frozen and the UI only redraws a few times per
+// second (enough for the scroller and seek time). Audio is never touched.
+bool power_saving = true;
+const int background_fps = 4;
+
+// ============================
+// Redraw tracking
+// ============================
+// Frames are only rendered when something visible changed: input, new
+// status data, a scroller tick or a new visualizer block. Idle and paused,
+// the loop just sleeps until the next status poll.
+bool redraw = true;
+auto last_input = std::chrono::steady_clock::now();
+const int input_grace_ms = 500; // keep drawing briefly after input (hover, tooltips)
+
+// ============================
+// Frame pacing
+// ============================
+FramePacer pacer;
+bool show_pacing_overlay = false; // toggled with F2
+
+void draw_pacing_overlay() {
+    FramePacer::Stats st = pacer.getStats();
+
+    ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 4, 4), ImGuiCond_Always, ImVec2(1, 0));
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    ImGui::Begin("##pacing", nullptr,
+        ImGuiWindowFlags_NoDecoration |
+        ImGuiWindowFlags_AlwaysAutoResize |
+        ImGuiWindowFlags_NoSavedSettings |
+        ImGuiWindowFlags_NoFocusOnAppearing);
+
+    int mode = pacer.getMode();
+    ImGui::SetNextItemWidth(90.0f);
+    if (ImGui::Combo("##mode", &mode, "vsync\0timer\0adaptive\0"))
+        pacer.setMode((FramePacer::Mode)mode);
+    ImGui::SameLine();
+    ImGui::Text("%d fps  p50 %.2f  p99 %.2f  max %.2f ms  (%llu)",
+        pacer.getTargetFps(), st.p50Ms, st.p99Ms, st.maxMs, (unsigned long long)st.frames);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("reset"))
+        pacer.resetStats();
+
+    // frame-time histogram, 0..40 ms
+    const std::vector<float> &hist = pacer.getHistogram();
+    int buckets = std::min((int)hist.size(), (int)(40.0 / pacer.getBucketMs()));
+    ImGui::PlotHistogram("##frametimes", hist.data(), buckets, 0, nullptr, 0.0f, FLT_MAX, ImVec2(300, 30));
+
+    ImGui::End();
+}
+
+void note_input() {
+    redraw = true;
+    last_input = std::chrono::steady_clock::now();
+}
+
+// chained in front of the ImGui GLFW callbacks
+void on_cursor_pos(GLFWwindow*, double, double)        { note_input(); }
+void on_mouse_button(GLFWwindow*, int, int, int)       { note_input(); }
+void on_scroll(GLFWwindow*, double, double)            { note_input(); }
+void on_key(GLFWwindow*, int, int, int, int)           { note_input(); }
+void on_char(GLFWwindow*, unsigned int)                { note_input(); }
+void on_cursor_enter(GLFWwindow*, int)                 { note_input(); }
+void on_focus(GLFWwindow*, int)                        { note_input(); }
+void on_refresh(GLFWwindow*)                           { redraw = true; }
+
 // ============================
 // FFT
 // ============================
 
 AudioFFT* gAudioFFT = nullptr;
+SpectrumAnalyzer* gSpectrum = nullptr;
+QualityGovernor* gGovernor = nullptr;
+bool show_spectrum = false;
+std::vector<float> spectrum_bars;
+
+// ============================
+// Loudness normalization
+// ============================
+// Every track is metered (EBU R128) as it plays and brought towards -14 LUFS
+// in the audio callback. A track measured on an earlier play gets its gain
+// as soon as the change of track is reported (event or poll, not sample
+// exact); a new one adapts slowly while it plays.
+LoudnessNormalizer* gLoudness = nullptr;
+LoudnessCache loudness_cache("spotamp_loudness.txt");
+std::string loudness_uri;                               // track gLoudness is metering
+static constexpr double loudness_min_seconds = 30.0;    // measured at least this much before it is kept
+static constexpr double loudness_slack_seconds = 5.0;   // pipe backlog, late track-change reports
+
+// Keeps what was measured of the previous track (ended_ms long, 0 = unknown)
+// and sets the gain for uri. A measurement longer than the track itself
+// spans more than one track and is dropped. Track-change thread only.
+void loudness_track_changed(const std::string &uri, int ended_ms) {
+    if (!gLoudness || uri == loudness_uri)
+        return;
+    double seconds = gLoudness->measuredSeconds();
+    if (!loudness_uri.empty() && seconds >= loudness_min_seconds) {
+        if (ended_ms > 0 && seconds <= ended_ms / 1000.0 + loudness_slack_seconds)
+            loudness_cache.put(loudness_uri, gLoudness->measuredLufs(), seconds);
+        else
+            std::cout << "[loudness] not keeping " << (int)seconds << " s measured for " << loudness_uri << std::endl;
+    }
+    loudness_uri = uri;
+    gLoudness->startTrack(uri.empty() ? NAN : loudness_cache.get(uri));
+}
+
+// ============================
+// Output dynamics
+// ============================
+// Optional compressor and the true-peak limiter at the end of the audio
+// chain; the limiter is what lets the gain stages before it boost safely
+Dynamics* gDynamics = nullptr;
+
+// ============================
+// FIR convolution (--ir file.wav)
+// ============================
+// Impulse response applied to the output, e.g. room correction or a
+// headphone EQ; off (nullptr) unless a WAV is given on the command line.
+Convolver* gConvolver = nullptr;
+
+// ============================
+// Latency probe (--latency-probe)
+// ============================
+// Follows transport commands from the click to the device and logs where
+// the time went; off (nullptr) unless asked for on the command line.
+LatencyProbe* gLatencyProbe = nullptr;
+bool latency_pending = false;
+
+// ============================
+// Play queue
+// ============================
+// Local queue; its head is handed to go-librespot's queue shortly before the
+// current track ends (timed from the audio-clock position) by the feeder
+// thread, so librespot does the transition itself, minimized or not.
+PlayQueue play_queue("spotamp_queue.txt");
+bool show_queue = false;   // the queue / playlist panel
+const int queue_panel_height = 260;
+const int queue_feed_lead_ms = 10000;
+QueueFeeder queue_feeder(play_queue, queue_feed_lead_ms);
+int queue_selected = -1;
+std::vector<std::string> queue_rows;   // the panel's copy of the queue
+uint64_t queue_rows_version = (uint64_t)-1;
+
+// paste / drop / file imports are parsed off the render thread; the queue
+// takes its links there too, the rest is fed a chunk per frame
+LinkImporter importer;
+struct ImportFeed {
+    std::vector<std::string> links;   // drained, [next, end) still to do
+    size_t next = 0;
+    size_t added = 0;
+};
+ImportFeed import_feed[LinkImporter::TARGET_COUNT];
+const size_t import_links_per_frame = 1000;
+bool import_busy_shown = false;
+
+// ============================
+// Playlist
+// ============================
+// Large local list (100k+ entries); only visible rows are drawn, sorting and
+// filtering happen on the playlist's worker thread.
+Playlist playlist("spotamp_playlist.txt");
+uint64_t playlist_seen_seq = 0;
+int64_t playlist_selected = -1;   // playlist row, not display position
+char playlist_filter[128] = {};
+
+// ============================
+// Search
+// ============================
+// Everything played, queued or listed, searchable by title / artist
+SearchIndex search_index("spotamp_search.idx");
+
+struct SearchRow {
+    std::string uri, title, artist;
+    uint8_t sources;
+};
+char search_text[128] = {};
+std::vector<SearchRow> search_rows;
+double search_ms = 0;
+
+// Titles of every track played so far, so lists can name tracks that were
+// only added by link
+MetaCache meta_cache("spotamp_meta.dat");
+bool meta_applied = false;
+
+// "title - artists" for a URI, or the URI itself when nothing is known
+std::string track_label(const std::string &uri) {
+    TrackMeta m;
+    if (!meta_cache.get(uri, m) || m.title.empty())
+        return uri;
+    return m.artists.empty() ? m.title : m.title + " - " + m.artists;
+}
+
+// indexes uri for search under whatever title the cache knows
+void index_uri(const std::string &uri, uint8_t source) {
+    TrackMeta m;
+    if (meta_cache.get(uri, m))
+        search_index.add(uri, m.title, m.artists, source);
+    else
+        search_index.add(uri, "", "", source);
+}
+
+// ============================
+// Play history
+// ============================
+// Every play with how long it was listened to; feeds the History tab
+PlayHistory play_history("spotamp_history.log");
+const int history_min_play_ms = 5000;       // shorter plays are not logged
+const int history_skip_margin_ms = 10000;   // ended earlier than this before the end = skipped
+
+// current_play*: track-change handler only (track_mutex)
+Play current_play;                          // logged when the track changes
+double current_play_listened_ms = 0;
+std::chrono::steady_clock::time_point current_play_mark;
+bool current_play_counting = false;
+
+struct HistoryRow {
+    Play play;
+    std::string label;
+    std::string cover;
+};
+std::vector<HistoryRow> history_rows;       // last plays, newest first
+std::vector<std::pair<std::string, int>> history_top;   // most played, last 30 days
+int history_today = 0, history_week = 0, history_month = 0, history_month_skips = 0;
+size_t history_shown_size = (size_t)-1;
+double history_query_ms = 0;
+
+int64_t unix_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Adds the time since the last call if playback was running, then
+// continues counting only while playing
+void count_listening(bool playing) {
+    auto now = std::chrono::steady_clock::now();
+    if (current_play_counting)
+        current_play_listened_ms += std::chrono::duration<double, std::milli>(now - current_play_mark).count();
+    current_play_mark = now;
+    current_play_counting = playing;
+}
+
+// Logs the play that is ending; ended is the last snapshot of its track.
+// A play cut off by quitting (closing) is not a skip.
+void end_play(const PlayerState &ended, bool closing = false) {
+    count_listening(false);
+    if (!current_play.uri.empty() && current_play_listened_ms >= history_min_play_ms) {
+        current_play.listenedMs = (uint32_t)current_play_listened_ms;
+        current_play.skipped = !closing && ended.durationMs > 0 &&
+                               snapshot_position_ms(ended) < ended.durationMs - history_skip_margin_ms;
+        play_history.add(current_play);
+    }
+    current_play = Play();
+    current_play_listened_ms = 0;
+}
+
+void begin_play(const std::string &uri, bool playing) {
+    current_play.uri = uri;
+    current_play.startMs = unix_ms();
+    current_play_listened_ms = 0;
+    current_play_counting = false;
+    count_listening(playing);
+}
+
+// Re-reads the last plays and the stats shown in the History tab
+void refresh_history() {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Play> plays;
+    play_history.last(100, plays);
+    history_rows.clear();
+    for (Play &p : plays)
+        history_rows.push_back(HistoryRow{std::move(p), {}, {}});
+    for (HistoryRow &row : history_rows) {
+        TrackMeta m;
+        row.label = track_label(row.play.uri);
+        if (meta_cache.get(row.play.uri, m))
+            row.cover = m.coverUrl;
+    }
+
+    // stats: local midnight, 7 and 30 days back
+    std::time_t t = std::time(nullptr);
+    std::tm local = *std::localtime(&t);
+    local.tm_hour = local.tm_min = local.tm_sec = 0;
+    int64_t midnight = (int64_t)std::mktime(&local) * 1000;
+    int64_t now = unix_ms(), day = 86400000;
+
+    play_history.between(now - 30 * day, INT64_MAX, plays);
+    history_today = history_week = history_month_skips = 0;
+    history_month = (int)plays.size();
+    std::unordered_map<std::string, int> counts;
+    for (const Play &p : plays) {
+        if (p.startMs >= midnight) history_today++;
+        if (p.startMs >= now - 7 * day) history_week++;
+        if (p.skipped) history_month_skips++;
+        if (!p.skipped) counts[p.uri]++;
+    }
+    history_top.assign(counts.begin(), counts.end());
+    size_t top = std::min<size_t>(10, history_top.size());
+    std::partial_sort(history_top.begin(), history_top.begin() + top, history_top.end(),
+                      [](const std::pair<std::string, int> &a, const std::pair<std::string, int> &b) {
+                          return a.second != b.second ? a.second > b.second : a.first < b.first;
+                      });
+    history_top.resize(top);
+    history_query_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ============================
+// Album art
+// ============================
+// Covers are fetched and decoded on a worker; the render loop uploads at
+// most art_upload_budget bytes of textures per frame
+AlbumArt album_art("spotamp_covers", 16 << 20);
+const size_t art_upload_budget = 256 * 1024;
+const int cover_tooltip_size = 200;
+
+// Playlist::MetaLookup from the metadata cache
+bool lookup_meta(std::string_view uri, std::string &title, std::string &artist, int &ms) {
+    TrackMeta m;
+    if (!meta_cache.get(uri, m))
+        return false;
+    title = m.title;
+    artist = m.artists;
+    ms = m.durationMs;
+    return true;
+}
+
+// Once the cache is loaded: names for queue / playlist entries that were
+// added by link and never played here
+void apply_meta_cache() {
+    for (size_t i = 0; i < play_queue.size(); i++)
+        index_uri(play_queue.at(i), SearchIndex::SRC_QUEUE);
+    size_t filled = playlist.fillMissing([](std::string_view uri, std::string &title, std::string &artist, int &ms) {
+        if (!lookup_meta(uri, title, artist, ms))
+            return false;
+        search_index.add(uri, title, artist, SearchIndex::SRC_PLAYLIST);
+        return true;
+    });
+    if (filled > 0)
+        std::cout << "[meta] named " << filled << " playlist entries" << std::endl;
+}
+
+void queue_uri(const std::string &uri) {
+    if (!PlayQueue::queueable(uri)) {
+        std::cout << "[queue] only tracks and episodes can be queued: " << uri << std::endl;
+        return;
+    }
+    if (play_queue.add(uri)) {
+        index_uri(uri, SearchIndex::SRC_QUEUE);
+        queue_feeder.wake();
+    }
+}
+
+void playlist_uri(const std::string &uri) {
+    if (playlist.add(uri))
+        index_uri(uri, SearchIndex::SRC_PLAYLIST);
+}
+
+// import thread: the queue locks itself, so imported links join it (and
+// its file is rewritten) here rather than on the render thread
+void queue_imported(const std::vector<std::string> &links) {
+    size_t added = play_queue.addMany(links);
+    if (added > 0)
+        queue_feeder.wake();
+    std::cout << "[queue] imported " << added << " of " << links.size() << " link(s), "
+              << links.size() - added << " already queued or not a track / episode" << std::endl;
+}
+
+// Render thread: indexes the next import_links_per_frame drained links of
+// each list (the playlist also takes them and names just those rows), so a
+// large import is spread over frames. True if anything changed.
+bool feed_imports() {
+    bool changed = false;
+    for (int t = 0; t < LinkImporter::TARGET_COUNT; t++) {
+        ImportFeed &feed = import_feed[t];
+        importer.drain((LinkImporter::Target)t, feed.links);
+        size_t end = std::min(feed.links.size(), feed.next + import_links_per_frame);
+        if (feed.next == end)
+            continue;
+
+        if (t == LinkImporter::PLAYLIST) {
+            std::vector<std::string> chunk(feed.links.begin() + feed.next, feed.links.begin() + end);
+            size_t first = playlist.size();
+            feed.added += playlist.addMany(chunk);
+            if (meta_applied)
+                playlist.fillMissing(lookup_meta, first);
+            for (const std::string &uri : chunk)
+                index_uri(uri, SearchIndex::SRC_PLAYLIST);
+        } else {
+            for (size_t i = feed.next; i < end; i++)
+                if (PlayQueue::queueable(feed.links[i]))
+                    index_uri(feed.links[i], SearchIndex::SRC_QUEUE);
+        }
+        feed.next = end;
+        changed = true;
+
+        if (feed.next == feed.links.size()) {
+            if (t == LinkImporter::PLAYLIST)
+                std::cout << "[playlist] imported " << feed.added << " of " << feed.links.size()
+                          << " link(s), " << feed.links.size() - feed.added << " already listed" << std::endl;
+            feed = ImportFeed();
+        }
+    }
+    return changed;
+}
+
+// files dropped on the window are imported into the queue
+void on_drop(GLFWwindow*, int count, const char **paths) {
+    for (int i = 0; i < count; i++)
+        importer.submitFile(paths[i]);
+    show_queue = true;
+    note_input();
+}
 
 // ============================
 // Spotify API
 // ============================
 auto status_last_refresh = std::chrono::steady_clock::now();
 const int status_refresh_interval_ms = 1000;
+const int status_fallback_interval_ms = 10000; // while the event stream is connected
+
+const char *api_host = "127.0.0.1";
+const int api_port = 3678;
+
+// all control-plane calls run on background lanes, never on the render thread
+ControlQueue control(api_host, api_port);
+
+// a local change wins over status replies that may predate it
+const int local_change_hold_ms = 1500;
+auto volume_hold_until  = std::chrono::steady_clock::now();
+auto seek_hold_until    = std::chrono::steady_clock::now();
+auto shuffle_hold_until = std::chrono::steady_clock::now();
+bool seek_dragging = false;
+const float seek_width = 385.0f; // seek slider width in pixels
 
-bool post_json(const std::string &path, const std::string &body = "{}") {
-    httplib::Client cli("127.0.0.1", 3678);
-    auto res = cli.Post(path.c_str(), body, "application/json");
-    return res && res->status == 200;
+int seek_pixel(int pos_ms) {
+    return track_duration_ms > 0 ? (int)((int64_t)pos_ms * (int64_t)seek_width / track_duration_ms) : 0;
 }
 
-void playpause() { post_json("/player/playpause"); }
-void next()      { post_json("/player/next"); }
-void prev()      { post_json("/player/prev"); }
+// push updates from go-librespot; /status polling is only the fallback
+EventStream events(api_host, api_port, "/events");
+
+// Server-reported player state. The status lane and the event stream
+// publish new snapshots; the UI diffs each one against the last it applied.
+PlayerStateStore player;
+PlayerState player_seen;
+
+// bumped by the health monitor each time go-librespot comes (back) up
+uint64_t api_generation = 0;
+
+// key != nullptr: supersedes a queued command with the same key
+// probed: followed by the latency probe (commands that change what is heard)
+void post_json(const std::string &path, const std::string &body = "{}", const char *key = nullptr, bool probed = false) {
+    uint64_t probe_id = (probed && gLatencyProbe) ? gLatencyProbe->begin(path.c_str()) : 0;
+    control.post(ControlQueue::LANE_PLAYBACK, [path, body, probe_id](ApiConnection &conn) {
+        if (probe_id) gLatencyProbe->sent(probe_id);
+        bool ok = conn.post(path.c_str(), body);
+        if (probe_id) gLatencyProbe->completed(probe_id, ok, audio_get_pipe_backlog_ms());
+    }, key);
+}
+
+void playpause() { post_json("/player/playpause", "{}", nullptr, true); }
+void next()      { post_json("/player/next", "{}", nullptr, true); }
+void prev()      { post_json("/player/prev", "{}", nullptr, true); }
 
 void load_track(const std::string &uri, bool paused = false) {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "uri", uri.c_str());
-    cJSON_AddBoolToObject(root, "paused", paused);
-    char *json = cJSON_PrintUnformatted(root);
-    post_json("/player/play", json);
-    cJSON_free(json);
-    cJSON_Delete(root);
-}
-
-void refresh_status() {
-    httplib::Client cli("127.0.0.1", 3678);
-    auto res = cli.Get("/status");
-    if (!res || res->status != 200) return;
-
-    cJSON *status = cJSON_Parse(res->body.c_str());
-    if (!status) return;
-
-    cJSON *track = cJSON_GetObjectItem(status, "track");
-    if (track) {
-        cJSON *name = cJSON_GetObjectItem(track, "name");
-        if (cJSON_IsString(name)) track_name = name->valuestring;
-
-        cJSON *artists = cJSON_GetObjectItem(track, "artist_names");
-        artist_name.clear();
-        if (cJSON_IsArray(artists)) {
-            int n = cJSON_GetArraySize(artists);
-            for (int i = 0; i < n; i++) {
-                cJSON *a = cJSON_GetArrayItem(artists, i);
-                if (cJSON_IsString(a)) {
-                    if (!artist_name.empty()) artist_name += ", ";
-                    artist_name += a->valuestring;
-                }
-            }
-        }
+    char buf[256];
+    JsonWriter w(buf, sizeof(buf));
+    w.field("uri", uri.c_str()).field("paused", paused);
+    if (!w.ok()) return;
+    post_json("/player/play", w.c_str(), "load", true);
+    queue_feeder.cancel(); // replaces librespot's queue; the handover is queued again
+}
+
+// feeder thread; a refusal ends the handover so the next one may go
+void add_to_remote_queue(const std::string &uri) {
+    char buf[256];
+    JsonWriter w(buf, sizeof(buf));
+    w.field("uri", uri.c_str());
+    if (!w.ok()) {
+        queue_feeder.sendFailed(uri);
+        return;
     }
+    std::string body = w.c_str();
+    control.post(ControlQueue::LANE_PLAYBACK, [uri, body](ApiConnection &conn) {
+        if (!conn.post("/player/add_to_queue", body))
+            queue_feeder.sendFailed(uri);
+    });
+}
 
-    cJSON *vol = cJSON_GetObjectItem(status, "volume");
-    cJSON *vol_max = cJSON_GetObjectItem(status, "volume_steps");
-    if (cJSON_IsNumber(vol))     volume_value = vol->valueint;
-    if (cJSON_IsNumber(vol_max)) volume_max   = vol_max->valueint;
+// ---- JSON -> PlayerState (these run on the writer threads) ----
+// Each writer thread pulls payloads into its own reused message, so parsing
+// reuses its string capacity instead of building a DOM. Publishing still
+// copies the whole PlayerState (PlayerStateStore::update makes a new one).
+ApiMessage &message_buffer() {
+    static thread_local ApiMessage msg;
+    return msg;
+}
 
-    cJSON_Delete(status);
+void read_track(const ApiMessage &m, PlayerState &st) {
+    if (m.has & ApiMessage::HAS_URI)     st.trackUri   = m.uri;
+    if (m.has & ApiMessage::HAS_NAME)    st.trackName  = m.name;
+    if (m.has & ApiMessage::HAS_ARTISTS) st.artistName = m.artists;
+    if (m.has & ApiMessage::HAS_ALBUM)   st.albumName  = m.album;
+    if (m.has & ApiMessage::HAS_COVER)   st.coverUrl   = m.cover;
 }
 
-void get_volume() {
-    httplib::Client cli("127.0.0.1", 3678);
-    auto res = cli.Get("/player/volume");
-    if (!res || res->status != 200) return;
+void read_position(const ApiMessage &m, PlayerState &st) {
+    if (m.has & ApiMessage::HAS_DURATION) st.durationMs = m.duration; // total ms
+    if (m.has & ApiMessage::HAS_POSITION) {                           // current ms
+        st.positionMs = m.position;
+        st.positionTime = std::chrono::steady_clock::now();
+        st.positionFrames = audio_get_frames_played();
+    }
+    st.seekKnown = true;
+}
 
-    cJSON *root = cJSON_Parse(res->body.c_str());
-    if (!root) return;
+void read_volume(const ApiMessage &m, PlayerState &st) {
+    if (m.has & ApiMessage::HAS_VOLUME)     st.volume    = m.volume;
+    if (m.has & ApiMessage::HAS_VOLUME_MAX) st.volumeMax = m.volumeMax;
+}
 
-    cJSON *val = cJSON_GetObjectItem(root, "value");
-    cJSON *max = cJSON_GetObjectItem(root, "max");
+void read_shuffle(const ApiMessage &m, PlayerState &st) {
+    if (m.has & ApiMessage::HAS_SHUFFLE) {
+        st.shuffle = m.shuffle;
+        st.shuffleKnown = true;
+    }
+}
 
-    if (cJSON_IsNumber(val)) volume_value = val->valueint;
-    if (cJSON_IsNumber(max)) volume_max   = max->valueint;
+// /status body
+void parse_status(const std::string &body, PlayerState &st) {
+    ApiMessage &m = message_buffer();
+    if (!json_read_message(body.data(), body.size(), m)) return;
 
-    volume_initialized = true;
-    cJSON_Delete(root);
+    if (m.has & ApiMessage::HAS_TRACK) {
+        read_track(m, st);
+        read_position(m, st);
+    }
+    read_volume(m, st);
+    read_shuffle(m, st);
+
+    st.paused = ((m.has & ApiMessage::HAS_PAUSED) && m.paused) ||
+                ((m.has & ApiMessage::HAS_STOPPED) && m.stopped);
+}
+
+// /player/volume body
+void parse_volume(const std::string &body, PlayerState &st) {
+    ApiMessage &m = message_buffer();
+    if (!json_read_message(body.data(), body.size(), m)) return;
+
+    read_volume(m, st);
+    st.volumeKnown = true;
+}
+
+// One go-librespot event ({"type": ..., "data": {...}})
+void parse_event(const std::string &body, PlayerState &st) {
+    ApiMessage &m = message_buffer();
+    if (!json_read_message(body.data(), body.size(), m)) return;
+
+    const std::string &t = m.type;
+    bool data = (m.has & ApiMessage::HAS_TRACK) != 0;
+
+    if (t == "metadata" && data) {
+        read_track(m, st);
+        read_position(m, st);
+    } else if (t == "seek" && data) {
+        read_position(m, st);
+    } else if (t == "playing") {
+        st.paused = false;
+    } else if (t == "paused" || t == "not_playing" || t == "stopped" || t == "inactive") {
+        st.paused = true;
+    } else if (t == "volume" && data) {
+        read_volume(m, st);
+        st.volumeKnown = true;
+    } else if (t == "shuffle_context" && data) {
+        read_shuffle(m, st);
+    }
 }
 
+// Queues a GET on the status lane; the reply is parsed there and published
+void request_get(const char *path, void (*parse)(const std::string &, PlayerState &)) {
+    std::string p = path;
+    control.post(ControlQueue::LANE_STATUS, [p, parse](ApiConnection &conn) {
+        std::string body;
+        if (!conn.get(p.c_str(), &body)) return;
+        player.update([&](PlayerState &st) { parse(body, st); });
+    }, path);
+}
+
+void request_status() { request_get("/status", parse_status); }
+void request_volume() { request_get("/player/volume", parse_volume); }
+
 void set_volume(int value) {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddNumberToObject(root, "volume", value);
-    cJSON_AddBoolToObject(root, "relative", false);
+    char buf[64];
+    JsonWriter w(buf, sizeof(buf));
+    w.field("volume", value).field("relative", false);
+    post_json("/player/volume", w.c_str(), "volume");
 
-    char *json = cJSON_PrintUnformatted(root);
-    post_json("/player/volume", json);
+    volume_hold_until = std::chrono::steady_clock::now() + std::chrono::milliseconds(local_change_hold_ms);
+}
+
+void set_shuffle(bool enable) {
+    char buf[64];
+    JsonWriter w(buf, sizeof(buf));
+    w.field("shuffle_context", enable);
+    post_json("/player/shuffle_context", w.c_str(), "shuffle");
 
-    cJSON_free(json);
-    cJSON_Delete(root);
+    shuffle_enabled = enable; // keep state in sync
+    shuffle_hold_until = std::chrono::steady_clock::now() + std::chrono::milliseconds(local_change_hold_ms);
 }
 
-void get_shuffle() {
-    httplib::Client cli("127.0.0.1", 3678);
-    auto res = cli.Get("/status");
-    if (!res || res->status != 200) return;
+void set_seek(int pos_ms) {
+    char buf[64];
+    JsonWriter w(buf, sizeof(buf));
+    w.field("position", pos_ms).field("relative", false); // absolute position
+    post_json("/player/seek", w.c_str(), "seek");
 
-    cJSON *root = cJSON_Parse(res->body.c_str());
-    if (!root) return;
+    set_position(pos_ms); // keep state in sync
+    seek_hold_until = std::chrono::steady_clock::now() + std::chrono::milliseconds(local_change_hold_ms);
+}
 
-    cJSON *shuffle = cJSON_GetObjectItem(root, "shuffle_context");
-    if (cJSON_IsBool(shuffle)) {
-        shuffle_enabled = cJSON_IsTrue(shuffle);
-        shuffle_initialized = true;
+// Applies a newer PlayerState snapshot to the UI, touching only the fields
+// that changed. Returns whether anything shown on screen changed.
+bool sync_player_state(GLFWwindow *window) {
+    if (player.version() == player_seen.version) return false;
+
+    PlayerStateStore::Snapshot snap = player.snapshot();
+    const PlayerState &st = *snap;
+    uint32_t changed = player_state_diff(player_seen, st);
+    auto now = std::chrono::steady_clock::now();
+    int shown_second = track_position_ms / 1000;
+
+    if (changed & FIELD_TRACK) {
+        track_name  = st.trackName;
+        artist_name = st.artistName;
+        // playlist entries of this track get their title from the player
+        if (!st.trackUri.empty()) {
+            playlist.setMeta(st.trackUri, st.trackName, st.artistName, st.durationMs);
+            if (st.trackName != "N/A")
+                search_index.add(st.trackUri, st.trackName, st.artistName, SearchIndex::SRC_HISTORY);
+        }
+        if (!st.coverUrl.empty())
+            album_art.texture(st.coverUrl, cover_tooltip_size);   // starts loading it
+        full_text = track_name + " by " + artist_name + "    ";
+        if (track_name != "N/A") {
+            std::string title = "SpotAmp - " + track_name + " by " + artist_name;
+            glfwSetWindowTitle(window, title.c_str());
+        }
+    }
+    if (changed & FIELD_DURATION) {
+        track_duration_ms = st.durationMs;
+    }
+    if (changed & (FIELD_TRACK | FIELD_DURATION)) {
+        feed_waveform();   // the end of the previous track still counts for it
+        waveform.setTrack(st.trackUri, st.durationMs);
+    }
+    // the duration often arrives after the name; keep the fuller record
+    if ((changed & (FIELD_TRACK | FIELD_DURATION)) && !st.trackUri.empty() && st.trackName != "N/A") {
+        TrackMeta m;
+        m.uri = st.trackUri;
+        m.title = st.trackName;
+        m.artists = st.artistName;
+        m.album = st.albumName;
+        m.coverUrl = st.coverUrl;
+        m.durationMs = st.durationMs;
+        meta_cache.put(m);   // unchanged tracks are not written again
+    }
+    if (changed & FIELD_PAUSED) {
+        set_paused(st.paused);
+    }
+    if ((changed & FIELD_POSITION) && !seek_dragging && now >= seek_hold_until) {
+        // a new track always snaps; otherwise only real drift moves the bar
+        correct_position(st.positionMs, st.positionFrames, st.positionTime, (changed & FIELD_TRACK) != 0);
+        seek_initialized = st.seekKnown;
+    }
+    if ((changed & FIELD_VOLUME) && now >= volume_hold_until) {
+        volume_value = st.volume;
+        volume_max = st.volumeMax;
+        volume_initialized = st.volumeKnown || volume_initialized;
+    }
+    if ((changed & FIELD_SHUFFLE) && now >= shuffle_hold_until) {
+        shuffle_enabled = st.shuffle;
+        shuffle_initialized = st.shuffleKnown;
     }
 
-    cJSON_Delete(root);
+    player_seen = st;
+    return (changed & ~FIELD_POSITION) != 0 || track_position_ms / 1000 != shown_second;
 }
 
-void set_shuffle(bool enable) {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddBoolToObject(root, "shuffle_context", enable);
+// ============================
+// Track changes
+// ============================
+// Play logging and loudness follow the player on the writer threads (status
+// lane, event stream) right after each publish rather than in the render
+// loop, which does not run while the window is minimized. Two writers may
+// publish at once; whichever gets here first handles the newest snapshot
+// and the other finds nothing new.
+std::mutex track_mutex;
+PlayerState track_seen;   // last snapshot handled here (track_mutex)
+
+void on_player_publish() {
+    {
+        std::lock_guard<std::mutex> lock(track_mutex);
+        PlayerStateStore::Snapshot snap = player.snapshot();
+        if (snap->version != track_seen.version) {
+            uint32_t changed = player_state_diff(track_seen, *snap);
+            if ((changed & FIELD_TRACK) && snap->trackUri != current_play.uri) {
+                end_play(track_seen);
+                if (!snap->trackUri.empty())
+                    begin_play(snap->trackUri, !snap->paused);
+            }
+            if (changed & FIELD_TRACK)
+                loudness_track_changed(snap->trackUri, track_seen.durationMs);
+            if (changed & FIELD_PAUSED)
+                count_listening(!snap->paused);
+            if (snap->trackUri != track_seen.trackUri)
+                queue_feeder.trackChanged(snap->trackUri);
+            track_seen = *snap;
+            if (changed & (FIELD_TRACK | FIELD_POSITION | FIELD_DURATION | FIELD_PAUSED))
+                queue_feeder.wake();
+        }
+    }
+    glfwPostEmptyEvent();
+}
 
-    char *json = cJSON_PrintUnformatted(root);
-    post_json("/player/shuffle_context", json);
+// ============================
+// Play queue feeding / panel
+// ============================
 
-    cJSON_free(json);
-    cJSON_Delete(root);
+// feeder thread: ms to the end of the current track by the audio clock;
+// -1 while paused or unknown
+int queue_ms_left() {
+    PlayerStateStore::Snapshot snap = player.snapshot();
+    if (snap->paused || snap->trackUri.empty() || snap->durationMs <= 0)
+        return -1;
+    return snap->durationMs - snapshot_position_ms(*snap);
+}
 
-    shuffle_enabled = enable; // keep state in sync
+// Starts the queue head right away (nothing playing, or on demand)
+void play_queue_head() {
+    std::string uri = play_queue.takeNext();
+    if (!uri.empty())
+        load_track(uri);
+}
+
+// path_box: the URI field, used as a file path by "Import file"
+void draw_queue_panel(const char *path_box) {
+    // copied only when it changed; edits below use these indices, which the
+    // feeder may make stale (the queue ignores out of range ones)
+    if (play_queue.version() != queue_rows_version) {
+        queue_rows_version = play_queue.version();
+        queue_rows = play_queue.snapshot();
+    }
+
+    ImGui::Text("Queue (%d)", (int)queue_rows.size());
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Play next")) play_queue_head();
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Clear")) play_queue.clear();
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Paste")) {
+        // every link in the clipboard, one per line or mixed with text
+        if (const char *clip = ImGui::GetClipboardText())
+            importer.submitText(clip);
+    }
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Import file")) importer.submitFile(path_box);
+    if (importer.isBusy()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("importing...");
+    }
+    std::string fed = queue_feeder.handedOver();
+    if (!fed.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("librespot next: %s", fed.c_str());
+    }
+
+    int remove_at = -1, move_from = -1, move_to = -1, play_at = -1;
+
+    ImGui::BeginChild("queue_list", ImVec2(0, 0), true);
+    // only visible rows are drawn (and labelled)
+    ImGuiListClipper clipper;
+    clipper.Begin((int)queue_rows.size());
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            ImGui::PushID(i);
+            if (ImGui::SmallButton("x")) remove_at = i;
+            ImGui::SameLine();
+            std::string label = track_label(queue_rows[i]);
+            if (ImGui::Selectable(label.c_str(), queue_selected == i, ImGuiSelectableFlags_AllowDoubleClick)) {
+                queue_selected = i;
+                if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) play_at = i;
+            }
+
+            // drag a row onto another to reorder
+            if (ImGui::BeginDragDropSource()) {
+                ImGui::SetDragDropPayload("QUEUE_ROW", &i, sizeof(int));
+                ImGui::Text("%s", label.c_str());
+                ImGui::EndDragDropSource();
+            }
+            if (ImGui::BeginDragDropTarget()) {
+                if (const ImGuiPayload *payload = ImGui::AcceptDragDropPayload("QUEUE_ROW")) {
+                    move_from = *(const int *)payload->Data;
+                    move_to = i;
+                }
+                ImGui::EndDragDropTarget();
+            }
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndChild();
+
+    // edits after the loop so indices stay valid while drawing
+    if (move_from >= 0) {
+        play_queue.move(move_from, move_to);
+        queue_selected = move_to;
+    } else if (remove_at >= 0) {
+        play_queue.remove(remove_at);
+        queue_selected = -1;
+    } else if (play_at >= 0) {
+        play_queue.move(play_at, 0);
+        play_queue_head();
+        queue_selected = -1;
+    }
 }
 
-void get_seek() {
-    httplib::Client cli("127.0.0.1", 3678);
-    auto res = cli.Get("/status");
-    if (!res || res->status != 200) return;
+void draw_playlist_panel(const char *path_box) {
+    std::shared_ptr<const Playlist::View> view = playlist.view();
+    // right after a removal the last view's indices are stale: show the
+    // plain order until the worker publishes a new one
+    bool view_valid = view && view->structure == playlist.structure();
+    size_t shown = view_valid ? view->rows.size() : playlist.size();
+
+    ImGui::SetNextItemWidth(160.0f);
+    if (ImGui::InputTextWithHint("##filter", "filter", playlist_filter, sizeof(playlist_filter)))
+        playlist.setFilter(playlist_filter);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Add")) playlist_uri(path_box);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Paste")) {
+        if (const char *clip = ImGui::GetClipboardText())
+            importer.submitText(clip, LinkImporter::PLAYLIST);
+    }
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Import file")) importer.submitFile(path_box, LinkImporter::PLAYLIST);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Clear")) {
+        playlist.clear();
+        playlist_selected = -1;
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("%zu / %zu", shown, playlist.size());
+    if (importer.isBusy()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("importing...");
+    }
+
+    int64_t remove_at = -1, play_at = -1, queue_at = -1;
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                                  ImGuiTableFlags_Sortable | ImGuiTableFlags_SortTristate | ImGuiTableFlags_Resizable;
+    if (ImGui::BeginTable("playlist", 4, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("#", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_NoSort, 44.0f, Playlist::SORT_NONE);
+        ImGui::TableSetupColumn("Title", ImGuiTableColumnFlags_WidthStretch, 0.0f, Playlist::SORT_TITLE);
+        ImGui::TableSetupColumn("Artist", ImGuiTableColumnFlags_WidthStretch, 0.0f, Playlist::SORT_ARTIST);
+        ImGui::TableSetupColumn("Time", ImGuiTableColumnFlags_WidthFixed, 40.0f, Playlist::SORT_DURATION);
+        ImGui::TableHeadersRow();
+
+        // header clicks re-sort on the worker; rows keep their old order until then
+        if (ImGuiTableSortSpecs *specs = ImGui::TableGetSortSpecs()) {
+            if (specs->SpecsDirty) {
+                if (specs->SpecsCount > 0)
+                    playlist.setOrder((Playlist::SortKey)specs->Specs[0].ColumnUserID,
+                                      specs->Specs[0].SortDirection == ImGuiSortDirection_Ascending);
+                else
+                    playlist.setOrder(Playlist::SORT_NONE, true);
+                specs->SpecsDirty = false;
+            }
+        }
+
+        // only the visible rows are submitted
+        ImGuiListClipper clipper;
+        clipper.Begin((int)shown);
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                uint32_t row = view_valid ? view->rows[i] : (uint32_t)i;
+                if (row >= playlist.size())
+                    continue;   // appended after a clear, view not rebuilt yet
+                ImGui::PushID((int)row);
+                ImGui::TableNextRow();
+
+                ImGui::TableNextColumn();
+                char num[16];
+                std::snprintf(num, sizeof(num), "%u", row + 1);
+                if (ImGui::Selectable(num, playlist_selected == row,
+                                      ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick)) {
+                    playlist_selected = row;
+                    if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) play_at = row;
+                }
+                if (ImGui::BeginPopupContextItem()) {
+                    if (ImGui::MenuItem("Play")) play_at = row;
+                    if (ImGui::MenuItem("Add to queue")) queue_at = row;
+                    if (ImGui::MenuItem("Remove")) remove_at = row;
+                    ImGui::EndPopup();
+                }
 
-    cJSON *root = cJSON_Parse(res->body.c_str());
-    if (!root) return;
+                ImGui::TableNextColumn();
+                std::string_view title = playlist.title(row), artist = playlist.artist(row);
+                TrackMeta cached;
+                if (title.empty() && meta_cache.get(playlist.uri(row), cached)) {
+                    // added by hand since the cache was applied
+                    title = cached.title;
+                    artist = cached.artists;
+                }
+                if (title.empty()) title = playlist.uri(row);   // never played
+                ImGui::TextUnformatted(title.data(), title.data() + title.size());
+
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(artist.data(), artist.data() + artist.size());
+
+                ImGui::TableNextColumn();
+                if (int ms = playlist.duration(row))
+                    ImGui::Text("%d:%02d", ms / 60000, (ms / 1000) % 60);
+
+                ImGui::PopID();
+            }
+        }
+        ImGui::EndTable();
+    }
 
-    cJSON *track = cJSON_GetObjectItem(root, "track");
-    if (track) {
-        cJSON *pos = cJSON_GetObjectItem(track, "position");  // current ms
-        cJSON *dur = cJSON_GetObjectItem(track, "duration");  // total ms
-        if (cJSON_IsNumber(pos)) track_position_ms = pos->valueint;
-        if (cJSON_IsNumber(dur)) track_duration_ms = dur->valueint;
-        seek_initialized = true;
+    // edits after the table so rows stay valid while drawing
+    if (play_at >= 0) {
+        load_track(std::string(playlist.uri((uint32_t)play_at)));
+    } else if (queue_at >= 0) {
+        queue_uri(std::string(playlist.uri((uint32_t)queue_at)));
+    } else if (remove_at >= 0) {
+        playlist.remove((uint32_t)remove_at);
+        playlist_selected = -1;
     }
+}
 
-    cJSON_Delete(root);
+void run_search() {
+    std::vector<SearchIndex::Result> results;
+    auto t0 = std::chrono::steady_clock::now();
+    search_index.search(search_text, 100, results);
+    search_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    // copied out: the rows outlive later index updates
+    search_rows.clear();
+    for (const SearchIndex::Result &r : results) {
+        search_rows.push_back(SearchRow{std::string(r.uri), std::string(r.title), std::string(r.artist), r.sources});
+        TrackMeta m;
+        SearchRow &row = search_rows.back();
+        if (row.title.empty() && meta_cache.get(row.uri, m)) {
+            row.title = m.title;
+            row.artist = m.artists;
+        }
+    }
 }
 
-void set_seek(int pos_ms) {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddNumberToObject(root, "position", pos_ms);
-    cJSON_AddBoolToObject(root, "relative", false); // absolute position
+void draw_search_panel() {
+    ImGui::SetNextItemWidth(240.0f);
+    if (ImGui::InputTextWithHint("##search", "title, artist or link", search_text, sizeof(search_text)))
+        run_search();
+    ImGui::SameLine();
+    if (search_text[0])
+        ImGui::TextDisabled("%zu found in %.2f ms", search_rows.size(), search_ms);
+    else
+        ImGui::TextDisabled("%zu tracks known", search_index.size());
+
+    int play_at = -1, queue_at = -1, list_at = -1;
+
+    if (ImGui::BeginTable("search", 3, ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Title", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Artist", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("In", ImGuiTableColumnFlags_WidthFixed, 30.0f);
+        ImGui::TableHeadersRow();
+
+        for (int i = 0; i < (int)search_rows.size(); i++) {
+            const SearchRow &row = search_rows[i];
+            ImGui::PushID(i);
+            ImGui::TableNextRow();
+
+            ImGui::TableNextColumn();
+            const std::string &label = row.title.empty() ? row.uri : row.title;
+            if (ImGui::Selectable(label.c_str(), false,
+                                  ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick) &&
+                ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+                play_at = i;
+            if (ImGui::BeginPopupContextItem()) {
+                if (ImGui::MenuItem("Play")) play_at = i;
+                if (ImGui::MenuItem("Add to queue")) queue_at = i;
+                if (ImGui::MenuItem("Add to playlist")) list_at = i;
+                ImGui::EndPopup();
+            }
+
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(row.artist.c_str());
+
+            // H = played, Q = queued, P = in the playlist
+            ImGui::TableNextColumn();
+            ImGui::TextDisabled("%s%s%s", row.sources & SearchIndex::SRC_HISTORY ? "H" : "",
+                                row.sources & SearchIndex::SRC_QUEUE ? "Q" : "",
+                                row.sources & SearchIndex::SRC_PLAYLIST ? "P" : "");
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+
+    if (play_at >= 0)
+        load_track(search_rows[play_at].uri);
+    else if (queue_at >= 0)
+        queue_uri(search_rows[queue_at].uri);
+    else if (list_at >= 0)
+        playlist_uri(search_rows[list_at].uri);
+}
+
+void draw_history_panel() {
+    if (play_history.size() != history_shown_size) {
+        history_shown_size = play_history.size();
+        refresh_history();
+    }
+    if (!play_history.isReady()) {
+        ImGui::TextDisabled("loading history...");
+        return;
+    }
+    ImGui::Text("%zu plays", history_shown_size);
+    ImGui::SameLine();
+    ImGui::TextDisabled("today %d, 7 days %d, 30 days %d (%d%% skipped)  %.2f ms", history_today, history_week,
+                        history_month, history_month ? history_month_skips * 100 / history_month : 0,
+                        history_query_ms);
+
+    int play_at = -1, queue_at = -1;
+    std::vector<std::string> top_uris;
+
+    if (ImGui::BeginTable("history", 3, ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter,
+                          ImVec2(0, history_top.empty() ? 0.0f : -ImGui::GetTextLineHeightWithSpacing() * 3))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("When", ImGuiTableColumnFlags_WidthFixed, 110.0f);
+        ImGui::TableSetupColumn("Track", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Played", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableHeadersRow();
+
+        // only visible rows, so only their covers are asked for
+        ImGuiListClipper clipper;
+        clipper.Begin((int)history_rows.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                const HistoryRow &row = history_rows[i];
+                ImGui::PushID(i);
+                ImGui::TableNextRow();
+
+                ImGui::TableNextColumn();
+                std::time_t t = (std::time_t)(row.play.startMs / 1000);
+                char when[32];
+                std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M", std::localtime(&t));
+                if (ImGui::Selectable(when, false, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick) &&
+                    ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+                    play_at = i;
+                if (ImGui::BeginPopupContextItem()) {
+                    if (ImGui::MenuItem("Play")) play_at = i;
+                    if (ImGui::MenuItem("Add to queue")) queue_at = i;
+                    ImGui::EndPopup();
+                }
+
+                ImGui::TableNextColumn();
+                float thumb = ImGui::GetTextLineHeight();
+                if (unsigned int tex = album_art.texture(row.cover, (int)thumb)) {
+                    ImGui::Image((ImTextureID)tex, ImVec2(thumb, thumb));
+                    ImGui::SameLine();
+                }
+                ImGui::TextUnformatted(row.label.c_str());
+
+                ImGui::TableNextColumn();
+                int s = (int)(row.play.listenedMs / 1000);
+                ImGui::Text("%d:%02d%s", s / 60, s % 60, row.play.skipped ? " skip" : "");
+                ImGui::PopID();
+            }
+        }
+        ImGui::EndTable();
+    }
 
-    char *json = cJSON_PrintUnformatted(root);
-    post_json("/player/seek", json);
+    // most played in the last 30 days, skips not counted
+    if (!history_top.empty()) {
+        ImGui::TextDisabled("Top 30 days:");
+        for (size_t i = 0; i < history_top.size(); i++) {
+            ImGui::SameLine();
+            ImGui::PushID((int)i);
+            std::string label = track_label(history_top[i].first) + " (" + std::to_string(history_top[i].second) + ")";
+            if (ImGui::SmallButton(label.c_str()))
+                load_track(history_top[i].first);
+            ImGui::PopID();
+        }
+    }
 
-    cJSON_free(json);
-    cJSON_Delete(root);
+    if (play_at >= 0)
+        load_track(history_rows[play_at].play.uri);
+    else if (queue_at >= 0)
+        queue_uri(history_rows[queue_at].play.uri);
+}
 
-    track_position_ms = pos_ms; // keep state in sync
+// The panel under the player: queue, playlist, search and history tabs
+void draw_list_panel(const char *path_box) {
+    ImGui::Separator();
+    if (!ImGui::BeginTabBar("lists"))
+        return;
+    if (ImGui::BeginTabItem("Queue")) {
+        draw_queue_panel(path_box);
+        ImGui::EndTabItem();
+    }
+    if (ImGui::BeginTabItem("Playlist")) {
+        draw_playlist_panel(path_box);
+        ImGui::EndTabItem();
+    }
+    if (ImGui::BeginTabItem("Search")) {
+        draw_search_panel();
+        ImGui::EndTabItem();
+    }
+    if (ImGui::BeginTabItem("History")) {
+        draw_history_panel();
+        ImGui::EndTabItem();
+    }
+    ImGui::EndTabBar();
 }
 
 
@@ -248,34 +1347,93 @@ void update_scroll() {
 // URI handler (from URL spotify share)
 // ============================
 
-// Converts a Spotify share URL into spotify:track:... or spotify:playlist:...
-// If input is already a URI, it returns it unchanged.
-std::string handle_paste(const std::string &input) {
-    std::string uri = input;
-
-    // Regex for open.spotify.com links
-    // Examples:
-    // https://open.spotify.com/track/7FKUc1mFraEOl4k6sdcwfb?si=a3555da3e9444ef1
-    // https://open.spotify.com/playlist/0iAeUtwINlqfjwAyQ4ykur?si=jrwFsnk8RzCNZb4-xI19uw
-    std::regex rgx(R"(https?://open\.spotify\.com/(track|playlist|album)/([a-zA-Z0-9]+))");
-    std::smatch match;
-
-    if (std::regex_search(input, match, rgx)) {
-        if (match.size() >= 3) {
-            std::string type = match[1];
-            std::string id   = match[2];
-            uri = "spotify:" + type + ":" + id;
-        }
-    }
-
-    // Otherwise, return the input as-is
-    return uri;
+// Rewrites a Spotify share link (open.spotify.com URL in any form, or a
+// spotify: URI) in buf as its canonical spotify:<type>:<id> URI.
+// Anything else is left as typed.
+void handle_paste(char *buf, size_t cap) {
+    SpotifyRef ref;
+    if (spotify_parse(buf, std::strlen(buf), ref))
+        spotify_format(ref, buf, cap);
 }
 
 // ============================
 // Main
 // ============================
-int main() {
+int main(int argc, char **argv) {
+    // spotamp --bench-http [n]: compare per-request latency, new client vs keep-alive
+    if (argc > 1 && std::strcmp(argv[1], "--bench-http") == 0) {
+        api_latency_benchmark(api_host, api_port, "/status", argc > 2 ? std::atoi(argv[2]) : 200);
+        return 0;
+    }
+    // spotamp --bench-json [n]: cJSON DOM vs pull parser on recorded payloads
+    if (argc > 1 && std::strcmp(argv[1], "--bench-json") == 0) {
+        json_parse_benchmark(argc > 2 ? std::atoi(argv[2]) : 100000);
+        return 0;
+    }
+
+    // spotamp --bench-uri [n] / --fuzz-uri [n]: link parser vs the old regex, and fuzzing
+    if (argc > 1 && std::strcmp(argv[1], "--bench-uri") == 0) {
+        spotify_uri_benchmark(argc > 2 ? std::atoi(argv[2]) : 20000);
+        return 0;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--fuzz-uri") == 0) {
+        return spotify_uri_fuzz(argc > 2 ? std::atoi(argv[2]) : 100000) == 0 ? 0 : 1;
+    }
+    // spotamp --check-limiter [n]: limiter output against its ceiling
+    if (argc > 1 && std::strcmp(argv[1], "--check-limiter") == 0) {
+        return dynamics_check(argc > 2 ? std::atoi(argv[2]) : 300) == 0 ? 0 : 1;
+    }
+    // spotamp --fake-events [port] [cover port]: stand-in go-librespot API and event stream
+    if (argc > 1 && std::strcmp(argv[1], "--fake-events") == 0) {
+        return event_stream_fake_server(argc > 2 ? std::atoi(argv[2]) : api_port, argc > 3 ? std::atoi(argv[3]) : 3679);
+    }
+    // spotamp --fake-covers [port]: stand-in image server for the cover loader
+    if (argc > 1 && std::strcmp(argv[1], "--fake-covers") == 0) {
+        return album_art_fake_server(argc > 2 ? std::atoi(argv[2]) : 3679);
+    }
+    // spotamp --bench-search [entries]: trigram index build / load / query times
+    if (argc > 1 && std::strcmp(argv[1], "--bench-search") == 0) {
+        search_index_benchmark(argc > 2 ? std::atoi(argv[2]) : 1000000);
+        return 0;
+    }
+    // spotamp --bench-history [plays]: play log load / range query times
+    if (argc > 1 && std::strcmp(argv[1], "--bench-history") == 0) {
+        play_history_benchmark(argc > 2 ? std::atoi(argv[2]) : 200000);
+        return 0;
+    }
+    // spotamp --bench-loudness [seconds]: loudness meter / normalizer cost
+    if (argc > 1 && std::strcmp(argv[1], "--bench-loudness") == 0) {
+        loudness_benchmark(argc > 2 ? std::atoi(argv[2]) : 600);
+        return 0;
+    }
+    // spotamp --bench-convolver [seconds]: FIR convolution cost against IR length
+    if (argc > 1 && std::strcmp(argv[1], "--bench-convolver") == 0) {
+        convolver_benchmark(argc > 2 ? std::atoi(argv[2]) : 20);
+        return 0;
+    }
+
+    // spotamp --latency-probe: log command -> audible latency breakdowns
+    // spotamp --ir file.wav: convolve the output with an impulse response
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--latency-probe") == 0) {
+            gLatencyProbe = new LatencyProbe();
+            std::cout << "[latency] probe enabled" << std::endl;
+        }
+        if (std::strcmp(argv[i], "--ir") == 0 && i + 1 < argc) {
+            // long IRs may spread over up to half the cores
+            int threads = (int)std::min(4u, std::max(1u, std::thread::hardware_concurrency() / 2));
+            gConvolver = new Convolver(44100, threads);
+            if (gConvolver->load(argv[++i])) {
+                std::cout << "[convolver] " << gConvolver->irName() << ": " << gConvolver->irSeconds() << " s, "
+                          << gConvolver->partitions() << " partitions on " << gConvolver->threads()
+                          << " thread(s)" << std::endl;
+            } else {
+                delete gConvolver;
+                gConvolver = nullptr;
+            }
+        }
+    }
+
     if (!glfwInit()) return 1;
 
     int WIDTH = 590;
@@ -286,6 +1444,11 @@ int main() {
     glfwMakeContextCurrent(window);
     glfwSwapInterval(1);
 
+    const GLFWvidmode *video_mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    pacer.configure(video_mode ? video_mode->refreshRate : 60,
+        glfwExtensionSupported("GLX_EXT_swap_control_tear") ||
+        glfwExtensionSupported("WGL_EXT_swap_control_tear"));
+
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
@@ -295,36 +1458,224 @@ int main() {
     ImFont* pixelFont = io.Fonts->AddFontFromFileTTF("fonts/BetterVCR 25.09.ttf", 12.0f);
     ImFont* songTitleFont = io.Fonts->AddFontFromFileTTF("fonts/UbuntuMono-Regular.ttf", 18.0f);
 
+    // installed first so the ImGui backend chains to them
+    glfwSetCursorPosCallback(window, on_cursor_pos);
+    glfwSetMouseButtonCallback(window, on_mouse_button);
+    glfwSetScrollCallback(window, on_scroll);
+    glfwSetKeyCallback(window, on_key);
+    glfwSetCharCallback(window, on_char);
+    glfwSetCursorEnterCallback(window, on_cursor_enter);
+    glfwSetWindowFocusCallback(window, on_focus);
+    glfwSetWindowRefreshCallback(window, on_refresh);
+    glfwSetDropCallback(window, on_drop);
+
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL2_Init();
 
-    refresh_status();
-    get_volume();
-    get_shuffle();
-    get_seek();
+    // loudness of tracks heard before; the normalizer must exist before audio
+    // runs and before the first track change is published
+    if (!loudness_cache.load())
+        std::cout << "[loudness] could not read the loudness cache" << std::endl;
+    gLoudness = new LoudnessNormalizer(44100);
+    gDynamics = new Dynamics(44100);
+    std::cout << "[audio] limiter look-ahead " << gDynamics->latencyFrames() << " frames" << std::endl;
+
+    // go-librespot may still be starting: initialization runs from the loop
+    // as soon as the health monitor sees the API come up
+    control.start();
+    player.setOnPublish(on_player_publish);
+    events.start([](const std::string &message) {
+        player.update([&](PlayerState &st) { parse_event(message, st); });
+    });
+    request_status();
+    status_last_refresh = std::chrono::steady_clock::now();
+    ApiHealth::State last_health = control.getHealth().getState();
 
     //start the fft
     gAudioFFT = new AudioFFT(1024);
+    // analyzers share the one FFT; hidden ones are disabled and cost nothing
+    gSpectrum = new SpectrumAnalyzer(64);
+    gSpectrum->setEnabled(show_spectrum);
+    gAudioFFT->addAnalyzer(gSpectrum);
     gAudioFFT->start();
 
     //init audio thread
     audio_init();
 
+    // sheds FFT/visual work under CPU pressure so audio never underruns
+    gGovernor = new QualityGovernor(gAudioFFT, 60);
+
     std::string song_uri = "spotify:track:6mfOyqROx7tnXkL9pNAp75";
     static char buffer[256] = {};
 
+    uint64_t last_visual_seq = 0;
+    bool visual_live = false;
+    bool queue_panel_open = false;
+
+    if (!play_queue.load())
+        std::cout << "[queue] could not read the saved queue" << std::endl;
+    queue_feeder.setMsLeft(queue_ms_left);
+    queue_feeder.setSend(add_to_remote_queue);
+    queue_feeder.start();
+    if (!playlist.load())
+        std::cout << "[playlist] could not read the saved playlist" << std::endl;
+    playlist.setOnReady(glfwPostEmptyEvent);
+    playlist.start();
+
+    meta_cache.setOnReady(glfwPostEmptyEvent);
+    meta_cache.start();
+    play_history.setOnReady(glfwPostEmptyEvent);
+    play_history.start();
+    album_art.setOnReady(glfwPostEmptyEvent);
+    album_art.start();
+
+    // the saved index, plus whatever the queue / playlist files hold
+    if (!search_index.load())
+        std::cout << "[search] rebuilding the search index" << std::endl;
+    for (size_t i = 0; i < play_queue.size(); i++)
+        search_index.add(play_queue.at(i), "", "", SearchIndex::SRC_QUEUE);
+    for (uint32_t i = 0; i < playlist.size(); i++)
+        search_index.add(playlist.uri(i), playlist.title(i), playlist.artist(i), SearchIndex::SRC_PLAYLIST);
+
+    importer.setOnReady(glfwPostEmptyEvent);
+    importer.setOnImported(LinkImporter::QUEUE, queue_imported);
+    importer.start();
+    // spotamp --import <file> (repeatable): queue every link in a text file
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--import") == 0)
+            importer.submitFile(argv[++i]);
+    }
+
     while (!glfwWindowShouldClose(window)) {
-        //fixes high CPU usage when minimized
-        if (glfwGetWindowAttrib(window, GLFW_ICONIFIED)) {
+        //fixes high CPU usage when minimized or hidden
+        if (glfwGetWindowAttrib(window, GLFW_ICONIFIED) || !glfwGetWindowAttrib(window, GLFW_VISIBLE)) {
+            gAudioFFT->setPaused(true);
             glfwWaitEvents();
             continue;
         }
-        //cap the FPS to 60
-        constexpr int TARGET_FPS = 60;
-        auto frame_start = std::chrono::steady_clock::now();
+
+        bool background = power_saving && !glfwGetWindowAttrib(window, GLFW_FOCUSED);
+        gAudioFFT->setPaused(background);
+
+        //cap the FPS to 60 (a few FPS in the background)
+        const int TARGET_FPS = background ? background_fps : gGovernor->getTargetFps();
+        pacer.setTargetFps(TARGET_FPS);
+        if (pacer.swapIntervalChanged())
+            glfwSwapInterval(pacer.swapInterval());
+
+        // ---- Sleep until input or the next tick that could change the picture ----
+        auto now = std::chrono::steady_clock::now();
+        const int status_interval_ms = events.isConnected() ? status_fallback_interval_ms : status_refresh_interval_ms;
+        auto next_tick = status_last_refresh + std::chrono::milliseconds(status_interval_ms);
+        if (!playback_paused && track_duration_ms > 0) {
+            // wake when the time readout or the seek handle would move
+            int to_next_second = 1000 - track_position_ms % 1000;
+            int ms_per_px = std::max(1, (int)(track_duration_ms / seek_width));
+            int to_next_px = ms_per_px - track_position_ms % ms_per_px;
+            next_tick = std::min(next_tick, now + std::chrono::milliseconds(std::min(to_next_second, to_next_px)));
+        }
+        if (int retry_ms = control.getHealth().retryInMs())
+            next_tick = std::min(next_tick, now + std::chrono::milliseconds(retry_ms));
+        if (!playback_paused && !full_text.empty())
+            next_tick = std::min(next_tick, scroll_last + std::chrono::milliseconds(scroll_ms));
+        if (latency_pending)
+            next_tick = std::min(next_tick, now + std::chrono::milliseconds(50));
+        if (redraw || visual_live || now - last_input < std::chrono::milliseconds(input_grace_ms))
+            next_tick = std::min(next_tick, pacer.nextFrameTime());
 
         // glfwMakeContextCurrent(window); //only when using more tha 1 window
-        glfwPollEvents();
+        if (next_tick > now) {
+            glfwWaitEventsTimeout(std::chrono::duration<double>(next_tick - now).count());
+        } else {
+            glfwPollEvents();
+        }
+
+        // ---- Non-visual ticks; each marks the frame dirty only on change ----
+        now = std::chrono::steady_clock::now();
+        gGovernor->update();
+        if (gLatencyProbe)
+            latency_pending = gLatencyProbe->poll();
+
+        ApiHealth &health = control.getHealth();
+        ApiHealth::State health_state = health.getState();
+        if (health_state != last_health) {
+            last_health = health_state;
+            redraw = true;
+        }
+        // (re)connected: re-run initialization
+        if (health.getGeneration() != api_generation) {
+            api_generation = health.getGeneration();
+            request_volume();
+            request_status();
+            status_last_refresh = now;
+        }
+
+        // while backing off, poll right when the breaker allows the next probe
+        bool probe_due = health_state == ApiHealth::STATE_DOWN && health.retryInMs() == 0;
+        if (probe_due || now - status_last_refresh >= std::chrono::milliseconds(status_interval_ms)) {
+            request_status();
+            status_last_refresh = now;
+        }
+        if (sync_player_state(window))
+            redraw = true;
+        feed_waveform();
+
+        int shown_position = track_position_ms;
+        if (!seek_dragging)
+            advance_position();
+        if (track_position_ms / 1000 != shown_position / 1000 ||
+            seek_pixel(track_position_ms) != seek_pixel(shown_position))
+            redraw = true;
+
+        // finished imports are indexed (and listed) a chunk per frame
+        if (feed_imports())
+            redraw = true;
+        if (!meta_applied && meta_cache.isReady()) {
+            meta_applied = true;
+            apply_meta_cache();
+            redraw = true;
+        }
+        // a sort / filter / import finished on the playlist worker
+        if (std::shared_ptr<const Playlist::View> view = playlist.view()) {
+            if (view->seq != playlist_seen_seq) {
+                playlist_seen_seq = view->seq;
+                redraw = true;
+            }
+        }
+        if (importer.isBusy() != import_busy_shown) {
+            import_busy_shown = importer.isBusy();
+            redraw = true;
+        }
+
+        if (now - scroll_last >= std::chrono::milliseconds(scroll_ms)) {
+            scroll_last = now;
+            if (!playback_paused) {
+                update_scroll();
+                redraw = true;
+            }
+        }
+
+        // new waveform block or analysis frame since the last check
+        uint64_t visual_seq = show_spectrum ? gAudioFFT->getFrameIndex() : gAudioFFT->getPushCount();
+        visual_live = visual_seq != last_visual_seq;
+        if (visual_live) {
+            last_visual_seq = visual_seq;
+            redraw = true;
+        }
+
+        if (now - last_input < std::chrono::milliseconds(input_grace_ms) || ImGui::GetIO().WantTextInput)
+            redraw = true;
+        // decoded covers are uploaded a few per frame, so keep frames coming
+        if (album_art.waiting())
+            redraw = true;
+
+        if (!redraw || !pacer.due(now))
+            continue;
+        redraw = false;
+        pacer.frameStarted(now);
+
+        auto frame_start = now;
+        album_art.update(art_upload_budget);
 
         ImGui_ImplOpenGL2_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -344,42 +1695,50 @@ int main() {
         // FFT
 
         if (gAudioFFT) {
-            // ImGui::PlotLines(
-            //     "FFT RAW",
-            //     gAudioFFT->fftMagnitude.data(),
-            //     gAudioFFT->fftMagnitude.size(),
-            //     0,
-            //     nullptr,
-            //     0.0f,
-            //     0.1f,
-            //     ImVec2(0, 200)
-            // );
-
-            // ImGui::PlotLines(
-            //     "FFT dB",
-            //     gAudioFFT->getDisplayVector().data(),
-            //     gAudioFFT->getDisplayVector().size(),
-            //     0,
-            //     nullptr,
-            //     0.0f,
-            //     1.0f,
-            //     ImVec2(0, 200)
-            // );
-
             ImGui::SetColumnWidth(0, 160); // left panel width in pixels
 
             float height = 87;
             ImGui::BeginChild("plot_child", ImVec2(0, height), false, ImGuiWindowFlags_NoScrollWithMouse | ImGuiWindowFlags_NoScrollbar);
-            ImGui::PlotLines(
-                "##waveform",                // label only for ID
-                gAudioFFT->waveform.data(),
-                gAudioFFT->waveform.size(),
-                0,
-                nullptr,
-                -1.0f,
-                1.0f,
-                ImVec2(ImGui::GetContentRegionAvail().x, height) // fills entire child width
-            );
+            if (show_spectrum) {
+                gSpectrum->getDisplay(spectrum_bars);
+                ImGui::PlotHistogram(
+                    "##spectrum",
+                    spectrum_bars.data(),
+                    spectrum_bars.size(),
+                    0,
+                    nullptr,
+                    0.0f,
+                    1.0f,
+                    ImVec2(ImGui::GetContentRegionAvail().x, height)
+                );
+            } else {
+                ImGui::PlotLines(
+                    "##waveform",                // label only for ID
+                    gAudioFFT->waveform.data(),
+                    gAudioFFT->waveform.size(),
+                    0,
+                    nullptr,
+                    -1.0f,
+                    1.0f,
+                    ImVec2(ImGui::GetContentRegionAvail().x, height) // fills entire child width
+                );
+            }
+
+            // click the visualizer to switch waveform <-> spectrum (like Winamp)
+            if (ImGui::IsItemClicked()) {
+                show_spectrum = !show_spectrum;
+                gSpectrum->setEnabled(show_spectrum);
+            }
+            if (ImGui::IsItemHovered()) {
+                const QualityGovernor::Metrics &m = gGovernor->getMetrics();
+                ImGui::SetTooltip(
+                    "quality: %s (down %u / up %u)\n"
+                    "audio load %.2f, underruns %u\n"
+                    "frame %.2f ms, cpu %.0f%%",
+                    QualityGovernor::levelName(m.level), m.stepDowns, m.stepUps,
+                    m.audioLoad, m.underruns,
+                    m.frameMs, m.processCpu * 100.0f);
+            }
 
             ImGui::EndChild();
         }
@@ -388,14 +1747,49 @@ int main() {
 
         //////////////////////////////////
         ImGui::PushFont(songTitleFont);
-        ImGui::Text("%s", display_text.c_str());
+        if (last_health == ApiHealth::STATE_UP) {
+            ImGui::Text("%s", display_text.c_str());
+            // cover of the playing track on hover
+            if (ImGui::IsItemHovered()) {
+                if (unsigned int tex = album_art.texture(player_seen.coverUrl, cover_tooltip_size)) {
+                    ImGui::BeginTooltip();
+                    ImGui::Image((ImTextureID)tex, ImVec2((float)cover_tooltip_size, (float)cover_tooltip_size));
+                    ImGui::EndTooltip();
+                }
+            }
+        } else {
+            ImGui::TextDisabled("Connecting to go-librespot...");
+        }
         ImGui::PopFont();
         //////////////////////////////////
         if (seek_initialized && track_duration_ms > 0) {
             int prev_pos = track_position_ms;
 
+            // waveform behind a see-through slider frame
+            bool wave_shown = waveform.columns((int)seek_width, wave_columns);
+            if (wave_shown) {
+                ImDrawList *dl = ImGui::GetWindowDrawList();
+                ImVec2 p = ImGui::GetCursorScreenPos();
+                float half = ImGui::GetFrameHeight() * 0.5f - 1.0f;
+                float mid = p.y + half + 1.0f;
+                int played = seek_pixel(track_position_ms);
+                ImU32 peak_col = ImGui::GetColorU32(ImGuiCol_PlotLines, 0.35f);
+                for (int x = 0; x < (int)wave_columns.size(); x++) {
+                    const WaveformCache::Column &c = wave_columns[x];
+                    if (c.lo > c.hi) continue;   // not heard yet
+                    float px = p.x + x + 0.5f;
+                    ImU32 rms_col = ImGui::GetColorU32(x < played ? ImGuiCol_PlotHistogram : ImGuiCol_PlotLines,
+                                                       x < played ? 0.9f : 0.5f);
+                    dl->AddLine(ImVec2(px, mid - c.hi * half), ImVec2(px, mid - c.lo * half + 1.0f), peak_col);
+                    dl->AddLine(ImVec2(px, mid - c.rms * half), ImVec2(px, mid + c.rms * half + 1.0f), rms_col);
+                }
+                ImGui::PushStyleColor(ImGuiCol_FrameBg, ImGui::GetColorU32(ImGuiCol_FrameBg, 0.3f));
+                ImGui::PushStyleColor(ImGuiCol_FrameBgHovered, ImGui::GetColorU32(ImGuiCol_FrameBgHovered, 0.3f));
+                ImGui::PushStyleColor(ImGuiCol_FrameBgActive, ImGui::GetColorU32(ImGuiCol_FrameBgActive, 0.3f));
+            }
+
             // Slider with range 0 → track duration
-            ImGui::SetNextItemWidth(385.0f); // pixels
+            ImGui::SetNextItemWidth(seek_width); // pixels
             ImGui::SliderInt(
                 "Seek",
                 &track_position_ms,
@@ -404,6 +1798,9 @@ int main() {
                 "",
                 ImGuiSliderFlags_AlwaysClamp
             );
+            seek_dragging = ImGui::IsItemActive();
+            if (wave_shown)
+                ImGui::PopStyleColor(3);
 
             // Only send new seek if user changed the slider
             if (track_position_ms != prev_pos) {
@@ -484,6 +1881,39 @@ int main() {
                 }
             }
 
+            if (ImGui::IsItemHovered() && gLoudness && gDynamics) {
+                ImGui::BeginTooltip();
+                if (!gLoudness->isEnabled())
+                    ImGui::Text("loudness normalization off (right-click)");
+                else if (gLoudness->measuredSeconds() > 0)
+                    ImGui::Text("track %.1f LUFS (%.0f s measured), short-term %.1f\ngain %+.1f dB, %s",
+                                gLoudness->measuredLufs(), gLoudness->measuredSeconds(),
+                                gLoudness->shortTermLufs(), gLoudness->gainDb(),
+                                gLoudness->gainKnown() ? "from an earlier play" : "adapting");
+                else
+                    ImGui::Text("gain %+.1f dB, %s", gLoudness->gainDb(),
+                                gLoudness->gainKnown() ? "from an earlier play" : "measuring");
+                if (gDynamics->compressorEnabled())
+                    ImGui::Text("compressor %.1f dB", gDynamics->compressorDb());
+                ImGui::Text("limiter %.1f dB", gDynamics->limiterDb());
+                ImGui::EndTooltip();
+            }
+            if (gLoudness && gDynamics && ImGui::BeginPopupContextItem("vol_menu")) {
+                bool normalize = gLoudness->isEnabled();
+                if (ImGui::MenuItem("Normalize loudness", nullptr, &normalize))
+                    gLoudness->setEnabled(normalize);
+                bool compress = gDynamics->compressorEnabled();
+                if (ImGui::MenuItem("Compressor", nullptr, &compress))
+                    gDynamics->setCompressor(compress);
+                if (gConvolver) {
+                    std::string label = "Convolve (" + gConvolver->irName() + ")";
+                    bool convolve = gConvolver->isEnabled();
+                    if (ImGui::MenuItem(label.c_str(), nullptr, &convolve))
+                        gConvolver->setEnabled(convolve);
+                }
+                ImGui::EndPopup();
+            }
+
             // Send to API only if user changed it
             if (volume_value != prev_volume) {
                 set_volume(volume_value);
@@ -501,20 +1931,48 @@ int main() {
             strncpy(buffer, song_uri.c_str(), sizeof(buffer));
         }
 
-        ImGui::SetNextItemWidth(341.0f); // pixels
+        ImGui::SetNextItemWidth(280.0f); // pixels
         if (ImGui::InputText("URI", buffer, sizeof(buffer))) {
-            song_uri = handle_paste(buffer);
-            // optionally, update buffer so the field shows canonical URI
-            std::strncpy(buffer, song_uri.c_str(), sizeof(buffer));
-            buffer[sizeof(buffer)-1] = '\0';
+            // the field shows the canonical URI right away
+            handle_paste(buffer, sizeof(buffer));
+            song_uri = buffer;
+        }
+        // a multi-line paste is a list of links: all of them go to the queue
+        // (the single-line field itself keeps only the first one)
+        if (ImGui::IsItemActive() && ImGui::IsKeyChordPressed(ImGuiMod_Ctrl | ImGuiKey_V)) {
+            const char *clip = ImGui::GetClipboardText();
+            if (clip && std::strchr(clip, '\n')) {
+                importer.submitText(clip);
+                show_queue = true;
+            }
         }
 
-
+        // queue: add the URI box, show/hide the queue panel
+        ImGui::SameLine();
+        if (ImGui::Button("+")) queue_uri(song_uri);
+        ImGui::SameLine();
+        if (ImGui::Button("Q")) show_queue = !show_queue;
 
         ImGui::Columns(1); // go back to single column mode
 
+        if (show_queue)
+            draw_list_panel(buffer);
+
         ImGui::End();
 
+        // the queue panel extends the window downwards
+        if (show_queue != queue_panel_open) {
+            queue_panel_open = show_queue;
+            int h = HEIGHT + (show_queue ? queue_panel_height : 0);
+            glfwSetWindowSizeLimits(window, WIDTH, h, WIDTH, h);
+            glfwSetWindowSize(window, WIDTH, h);
+        }
+
+        if (ImGui::IsKeyPressed(ImGuiKey_F2, false))
+            show_pacing_overlay = !show_pacing_overlay;
+        if (show_pacing_overlay)
+            draw_pacing_overlay();
+
         ImGui::Render();
         int w, h;
         glfwGetFramebufferSize(window, &w, &h);
@@ -522,43 +1980,50 @@ int main() {
         glClearColor(0.1f, 0.1f, 0.1f, 1);
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL2_RenderDrawData(ImGui::GetDrawData());
+        // frame work excludes the (possibly vsync-blocking) swap
+        auto frame_work_end = std::chrono::steady_clock::now();
         glfwSwapBuffers(window);
-
-        auto now = std::chrono::steady_clock::now();
-
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(now - status_last_refresh).count() > status_refresh_interval_ms) {
-            refresh_status();
-            get_seek();
-            full_text = track_name + " by " + artist_name + "    ";
-            status_last_refresh = now;
-            if (track_name != "N/A") {
-                std::string title = "SpotAmp - " + track_name + " by " + artist_name;
-                glfwSetWindowTitle(window, title.c_str());
-            }
-        }
-
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(now - scroll_last).count() > scroll_ms) {
-            update_scroll();
-            scroll_last = now;
-        }
-
-        
-        //FPS limiter
-        auto frame_end = std::chrono::steady_clock::now();
-        auto frame_ms = std::chrono::duration_cast<std::chrono::milliseconds>(frame_end - frame_start).count();
-        if (frame_ms < 1000 / TARGET_FPS) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000 / TARGET_FPS - frame_ms));
-        }
-
+        gGovernor->frameDone(std::chrono::duration<double, std::milli>(frame_work_end - frame_start).count());
     }
 
     //shutdown cleanup
+    queue_feeder.stop();
+    importer.stop();
+    playlist.stop();   // finishes a pending save
+    meta_cache.stop();  // writes what is still queued
+    feed_waveform();
+    waveform.save();
+    if (!search_index.save())
+        std::cout << "[search] could not save the search index" << std::endl;
+    events.stop();
+    control.stop();
+    // the writers are gone: close the last play and keep its measurement
+    end_play(track_seen, true);
+    play_history.stop();   // appends and syncs the last plays
+    loudness_track_changed("", track_seen.durationMs);
+    delete gGovernor;
+    gGovernor = nullptr;
     if (gAudioFFT) {
         gAudioFFT->stop();
         delete gAudioFFT;
         gAudioFFT = nullptr;
     }
+    delete gSpectrum;
+    gSpectrum = nullptr;
     audio_shutdown();
+    delete gLoudness;
+    gLoudness = nullptr;
+    delete gDynamics;
+    gDynamics = nullptr;
+    delete gConvolver;
+    gConvolver = nullptr;
+    if (gLatencyProbe) {
+        gLatencyProbe->printSummary();
+        delete gLatencyProbe;
+        gLatencyProbe = nullptr;
+    }
+    album_art.stop();
+    album_art.releaseTextures();   // while the GL context still exists
     ImGui_ImplOpenGL2_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();